@@ -12,6 +12,7 @@
 #include "nrfx_saadc.h"
 
 #include "microbit_v2.h"
+#include "gpio.h"
 
 // Digital outputs
 // Breakout pins 13, 14, and 15
@@ -40,8 +41,13 @@
 // Global variables
 APP_TIMER_DEF(sample_timer);
 
+// All three LED pins, changed together so the color never passes through a mix
+// of the old and new settings
+static gpio_mask_t rgb_mask;
+
 // Function prototypes
 static void gpio_init(void);
+static void rgb_set(bool red, bool green, bool blue);
 static void adc_init(void);
 static float adc_sample_blocking(uint8_t channel);
 
@@ -57,13 +63,30 @@ static void saadc_event_callback(nrfx_saadc_evt_t const* _unused) {
 
 static void gpio_init(void) {
   // Initialize output pins
-  // TODO
+  static const uint8_t rgb_pins[] = {LED_RED, LED_GREEN, LED_BLUE};
+  rgb_mask = gpio_mask(rgb_pins, 3);
+  gpio_config_mask(&rgb_mask, GPIO_OUTPUT);
 
   // Set LEDs off initially
-  // TODO
+  rgb_set(false, false, false);
 
   // Initialize input pin
-  // TODO
+  gpio_config(SWITCH_IN, GPIO_INPUT);
+}
+
+// Assumes a common cathode LED, where a high pin lights its color
+static void rgb_set(bool red, bool green, bool blue) {
+  const uint8_t led_pins[] = {LED_RED, LED_GREEN, LED_BLUE};
+  const bool on[] = {red, green, blue};
+  uint8_t pins[3];
+  uint8_t count = 0;
+  for (int i = 0; i < 3; i++) {
+    if (on[i]) {
+      pins[count++] = led_pins[i];
+    }
+  }
+  gpio_mask_t values = gpio_mask(pins, count);
+  gpio_write_mask(&rgb_mask, &values);
 }
 
 static void adc_init(void) {
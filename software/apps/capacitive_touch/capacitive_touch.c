@@ -1,89 +1,401 @@
 // Capacitive touch library
-// Detects touch status of the logo touchpad
+// Detects touch status of the logo and edge connector pads
+//
+// Each scan releases up to CAPACITIVE_TOUCH_LANES pads to charge through their
+// pull-ups and starts TIMER0 at the same moment. Each pad's rising edge
+// captures the timer into its lane's CC register through GPIOTE and PPI, so
+// the charge time is measured in hardware and interrupt latency never shows
+// up in it.
+//   CC[0], CC[3]  lane captures
+//   CC[1]         end of the charge window: read the captures, drive the pads low
+//   CC[2]         end of the scan: the timer stops by shortcut, start the next scan
+//
+// Bursts stop the timer after a set number of rounds, so a low-power timer can
+// start them and TIMER0 doesn't hold HFCLK on in between.
+//
+// Scan s measures pads s, s + scans per round, and so on, so pads measured
+// together are not neighbours on a slider. The lanes' GPIOTE channels are set
+// up once. Between scans only their MODE and pin change, Disabled while the
+// pads are held low and Event while they charge. Pads not being measured are
+// held low too, which shields the ones that are.
 
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <string.h>
 
-#include "app_timer.h"
-#include "nrf_delay.h"
+#include "app_error.h"
+#include "nrf.h"
 #include "nrf_gpio.h"
-#include "nrfx_gpiote.h"
+#include "nrf_gpiote.h"
+#include "nrfx_ppi.h"
 #include "nrfx_timer.h"
 
+#include "cycle_counter.h"
 #include "microbit_v2.h"
 
 #include "capacitive_touch.h"
 
-// High-speed timer for timeout detection
-static nrfx_timer_t TIMER4 = NRFX_TIMER_INSTANCE(0);
+#define TICKS_PER_US 16
+#define TIMEOUT_TICKS (CAPACITIVE_TOUCH_TIMEOUT_US * TICKS_PER_US)
+#define SCAN_TICKS (CAPACITIVE_TOUCH_SCAN_US * TICKS_PER_US)
+
+// Untouched charge time averaged over this many samples at the start
+#define CALIBRATION_SAMPLES 32
+
+// Baseline follows 1/64 of the difference to each untouched sample, which
+// tracks humidity and temperature drift but not a finger
+#define BASELINE_SHIFT 6
+
+// A touch held this long is more likely a changed pad than a finger, so the
+// baseline is measured again
+#define MAX_TOUCH_US 10000000
+
+typedef struct {
+  uint32_t pin;
+  bool active;
+  uint32_t last; // Latest charge time in ticks
 
-// Status of the touch sensor
-static bool touch_active = false;
+  // Baseline in ticks, scaled up by BASELINE_SHIFT
+  uint32_t baseline_scaled;
+  uint32_t calibration_sum;
+  uint8_t calibration_count;
+  uint8_t debounce_count;
+  uint32_t touched_samples;
 
-// Callback function for GPIO interrupts
-static void gpio_handler(nrfx_gpiote_pin_t pin, nrf_gpiote_polarity_t action) {
-  // Disable the GPIO interrupt event so you don't get multiple spurious events
-  nrfx_gpiote_in_event_disable(TOUCH_LOGO);
+  // Statistics
+  uint32_t samples;
+  uint32_t timeouts;
+  uint64_t sample_sum;
+  uint32_t sample_max;
+  uint32_t touches;
+  uint32_t recalibrations;
+} touch_pad_t;
 
-  // Implement me first!
+// Capture register of each lane
+static const nrf_timer_cc_channel_t lane_cc[CAPACITIVE_TOUCH_LANES] = {NRF_TIMER_CC_CHANNEL0, NRF_TIMER_CC_CHANNEL3};
+static const nrf_timer_task_t lane_capture[CAPACITIVE_TOUCH_LANES] = {NRF_TIMER_TASK_CAPTURE0, NRF_TIMER_TASK_CAPTURE3};
+
+// High-speed timer for the charge time
+static nrfx_timer_t TIMER = NRFX_TIMER_INSTANCE(0);
+static nrf_ppi_channel_t capture_channels[CAPACITIVE_TOUCH_LANES];
+
+static touch_pad_t pads[CAPACITIVE_TOUCH_MAX_PADS];
+static uint8_t pad_count = 0;
+static uint8_t scans_per_round = 0;
+static uint8_t scan_index = 0; // Scan of the round in progress
+
+static capacitive_touch_handler_t touch_handler = NULL;
+static capacitive_touch_round_handler_t round_handler = NULL;
+static volatile bool running = false;
+static volatile bool scanning = false;
+static volatile uint8_t burst_rounds = 0; // Rounds left in a burst, 0 when continuous
+static uint32_t round_period_us = 0;
+
+// Statistics
+static volatile uint32_t scans = 0;
+static volatile uint32_t isr_cycles = 0;
+
+static void recalibrate(touch_pad_t* pad) {
+  pad->calibration_sum = 0;
+  pad->calibration_count = 0;
+  pad->debounce_count = 0;
+  pad->touched_samples = 0;
 }
 
-static void timer_handler(nrf_timer_event_t event, void* context) {
-  // Implement in a later step
+static void report(uint8_t index, bool touched) {
+  pads[index].active = touched;
+  if (touch_handler != NULL) {
+    touch_handler(index, touched);
+  }
 }
 
-// Helper function for starting a test
-// A "capacitive test" consists of:
-//  1. Driving the pad low
-//  2. Changing to an input and allowing it to float high
-//  3. Either triggering a GPIO interrupt when it becomes high or timing out
+// Run one charge time through the pad's baseline and touch hysteresis
+static void process_sample(uint8_t index, uint32_t ticks) {
+  touch_pad_t* pad = &pads[index];
+  pad->last = ticks;
+
+  if (pad->calibration_count < CALIBRATION_SAMPLES) {
+    pad->calibration_sum += ticks;
+    if (++pad->calibration_count == CALIBRATION_SAMPLES) {
+      pad->baseline_scaled = (pad->calibration_sum / CALIBRATION_SAMPLES) << BASELINE_SHIFT;
+      if (pad->active) {
+        report(index, false);
+      }
+    }
+    return;
+  }
+
+  uint32_t baseline = pad->baseline_scaled >> BASELINE_SHIFT;
+  uint32_t percent = pad->active ? CAPACITIVE_TOUCH_RELEASE_PERCENT : CAPACITIVE_TOUCH_PRESS_PERCENT;
+  bool over = ticks > baseline + baseline * percent / 100;
+
+  if (over != pad->active) {
+    if (++pad->debounce_count >= CAPACITIVE_TOUCH_DEBOUNCE) {
+      pad->debounce_count = 0;
+      pad->touched_samples = 0;
+      if (over) {
+        pad->touches++;
+      }
+      report(index, over);
+    }
+    return;
+  }
+  pad->debounce_count = 0;
+
+  if (!pad->active) {
+    pad->baseline_scaled = pad->baseline_scaled - baseline + ticks;
+  } else if (++pad->touched_samples >= MAX_TOUCH_US / capacitive_touch_round_us()) {
+    pad->recalibrations++;
+    recalibrate(pad);
+  }
+}
+
+// Pad on <lane> in the current scan, or -1 if the lane is idle
+static int lane_pad(uint8_t lane) {
+  uint8_t index = scan_index + lane * scans_per_round;
+  return index < pad_count ? index : -1;
+}
+
+// Release this scan's pads and start counting, a fixed few cycles apart
 static void start_capacitive_test(void) {
-  // set pin as input and clear it
-  nrf_gpio_cfg(TOUCH_LOGO, NRF_GPIO_PIN_DIR_OUTPUT, NRF_GPIO_PIN_INPUT_DISCONNECT,
-      NRF_GPIO_PIN_NOPULL, NRF_GPIO_PIN_S0S1, NRF_GPIO_PIN_NOSENSE);
-  nrf_gpio_pin_clear(TOUCH_LOGO);
+  scanning = true;
+  nrfx_timer_clear(&TIMER);
 
-  // clear and resume timeout timer
-  nrfx_timer_clear(&TIMER4);
-  nrfx_timer_resume(&TIMER4);
+  uint32_t release[2] = {0, 0};
+  for (uint8_t lane = 0; lane < CAPACITIVE_TOUCH_LANES; lane++) {
+    int index = lane_pad(lane);
+    if (index < 0) {
+      continue;
+    }
+    uint32_t channel = CAPACITIVE_TOUCH_GPIOTE_CHANNEL + lane;
+    nrf_timer_cc_write(TIMER.p_reg, lane_cc[lane], 0);
+    nrf_gpiote_event_configure(channel, pads[index].pin, NRF_GPIOTE_POLARITY_LOTOHI);
+    NRF_GPIOTE->EVENTS_IN[channel] = 0;
+    nrf_gpiote_event_enable(channel);
+    release[pads[index].pin >> 5] |= 1UL << (pads[index].pin & 0x1F);
+  }
 
-  // re-initialize and enable GPIO interrupt event
-  nrfx_gpiote_in_config_t in_config = NRFX_GPIOTE_CONFIG_IN_SENSE_LOTOHI(true); // high-accuracy mode
-  nrfx_gpiote_in_init(TOUCH_LOGO, &in_config, gpio_handler);
-  nrfx_gpiote_in_event_enable(TOUCH_LOGO, true); // enable interrupts
+  // One DIRCLR per port lets the pads of a scan go together
+  NRF_P0->DIRCLR = release[0];
+  NRF_P1->DIRCLR = release[1];
+  nrfx_timer_resume(&TIMER);
 }
 
+static void timer_handler(nrf_timer_event_t event, void* context) {
+  uint32_t start = DWT->CYCCNT;
+
+  if (event == NRF_TIMER_EVENT_COMPARE1) {
+    // Charge window over, hold the pads low until the next scan
+    for (uint8_t lane = 0; lane < CAPACITIVE_TOUCH_LANES; lane++) {
+      int index = lane_pad(lane);
+      if (index < 0) {
+        continue;
+      }
+      nrf_gpiote_event_disable(CAPACITIVE_TOUCH_GPIOTE_CHANNEL + lane);
+      nrf_gpio_pin_dir_set(pads[index].pin, NRF_GPIO_PIN_DIR_OUTPUT);
+
+      // Nothing captured, or the edge came in just as the window closed
+      touch_pad_t* pad = &pads[index];
+      uint32_t ticks = nrfx_timer_capture_get(&TIMER, lane_cc[lane]);
+      if (ticks == 0 || ticks > TIMEOUT_TICKS) {
+        ticks = TIMEOUT_TICKS;
+        pad->timeouts++;
+      }
+      pad->samples++;
+      pad->sample_sum += ticks;
+      if (ticks > pad->sample_max) {
+        pad->sample_max = ticks;
+      }
+      process_sample(index, ticks);
+    }
 
-// Starts continuously measuring capacitive touch for the logo
+    scans++;
+    if (++scan_index == scans_per_round) {
+      scan_index = 0;
+      if (round_handler != NULL) {
+        round_handler();
+      }
+
+      // Last round of a burst, the timer stops at the end of this scan
+      if (burst_rounds > 0 && --burst_rounds == 0) {
+        running = false;
+      }
+    }
+  } else if (event == NRF_TIMER_EVENT_COMPARE2) {
+    scanning = false;
+    if (running) {
+      start_capacitive_test();
+    }
+  }
+
+  isr_cycles += DWT->CYCCNT - start;
+}
+
+void capacitive_touch_set_pads(const uint32_t* pins, uint8_t count) {
+  capacitive_touch_stop();
+  while (scanning) {
+    // the scan in progress ends within CAPACITIVE_TOUCH_SCAN_US
+  }
+
+  // Pads dropped from the list go back to their default state
+  for (uint8_t i = 0; i < pad_count; i++) {
+    nrf_gpio_cfg_default(pads[i].pin);
+  }
+
+  pad_count = count < CAPACITIVE_TOUCH_MAX_PADS ? count : CAPACITIVE_TOUCH_MAX_PADS;
+  scans_per_round = (pad_count + CAPACITIVE_TOUCH_LANES - 1) / CAPACITIVE_TOUCH_LANES;
+  scan_index = 0;
+  round_period_us = scans_per_round * CAPACITIVE_TOUCH_SCAN_US;
+  memset(pads, 0, sizeof(pads));
+  for (uint8_t i = 0; i < pad_count; i++) {
+    pads[i].pin = pins[i];
+
+    // held low between measurements, input buffer connected for GPIOTE
+    nrf_gpio_cfg(pins[i], NRF_GPIO_PIN_DIR_OUTPUT, NRF_GPIO_PIN_INPUT_CONNECT,
+        NRF_GPIO_PIN_NOPULL, NRF_GPIO_PIN_S0S1, NRF_GPIO_PIN_NOSENSE);
+    nrf_gpio_pin_clear(pins[i]);
+  }
+  scans = 0;
+  isr_cycles = 0;
+}
+
+// Starts continuously measuring capacitive touch
 // Function returns immediately without blocking
-void capacitive_touch_init(void) {
+void capacitive_touch_init(const uint32_t* pins, uint8_t count, capacitive_touch_handler_t handler) {
+  touch_handler = handler;
+
+  // CPU load of the timer interrupt
+  cycle_counter_init();
+
   // configure high-speed timer
-  // timer should be 1 MHz and 32-bit
+  // timer should be 16 MHz and 32-bit
   nrfx_timer_config_t timer_config = {
-    .frequency = NRF_TIMER_FREQ_1MHz,
+    .frequency = NRF_TIMER_FREQ_16MHz,
     .mode = NRF_TIMER_MODE_TIMER,
     .bit_width = NRF_TIMER_BIT_WIDTH_32,
     .interrupt_priority = 4,
     .p_context = NULL
   };
-  nrfx_timer_init(&TIMER4, &timer_config, timer_handler);
+  ret_code_t err_code = nrfx_timer_init(&TIMER, &timer_config, timer_handler);
+  APP_ERROR_CHECK(err_code);
+  nrfx_timer_compare(&TIMER, NRF_TIMER_CC_CHANNEL1, TIMEOUT_TICKS, true);
+  nrfx_timer_extended_compare(&TIMER, NRF_TIMER_CC_CHANNEL2, SCAN_TICKS, NRF_TIMER_SHORT_COMPARE2_STOP_MASK, true);
+
+  // each lane's rising edge captures the timer into the lane's CC register
+  // No GPIOTE interrupt: the events only go to PPI
+  for (uint8_t lane = 0; lane < CAPACITIVE_TOUCH_LANES; lane++) {
+    uint32_t channel = CAPACITIVE_TOUCH_GPIOTE_CHANNEL + lane;
+    nrf_gpiote_event_disable(channel);
+    nrf_gpiote_int_disable(1UL << channel);
+
+    err_code = nrfx_ppi_channel_alloc(&capture_channels[lane]);
+    APP_ERROR_CHECK(err_code);
+    nrfx_ppi_channel_assign(capture_channels[lane], (uint32_t)&NRF_GPIOTE->EVENTS_IN[channel],
+        nrfx_timer_task_address_get(&TIMER, lane_capture[lane]));
+    nrfx_ppi_channel_enable(capture_channels[lane]);
+  }
 
   // enable, but pause the timer
-  nrfx_timer_enable(&TIMER4);
-  nrfx_timer_pause(&TIMER4);
+  nrfx_timer_enable(&TIMER);
+  nrfx_timer_pause(&TIMER);
 
   // start the touch test
-  start_capacitive_test();
+  capacitive_touch_set_pads(pins, count);
+  capacitive_touch_start();
+}
+
+void capacitive_touch_set_round_handler(capacitive_touch_round_handler_t handler) {
+  round_handler = handler;
+}
+
+void capacitive_touch_stop(void) {
+  // The scan in progress finishes and the timer stops at its end
+  running = false;
+}
+
+void capacitive_touch_start(void) {
+  burst_rounds = 0;
+  round_period_us = scans_per_round * CAPACITIVE_TOUCH_SCAN_US;
+  if (running || pad_count == 0) {
+    return;
+  }
+  running = true;
+
+  // Inside a scan its CC[2] interrupt starts the next one
+  if (!scanning) {
+    start_capacitive_test();
+  }
 }
 
-// Determines whether the logo is being touched
-//	True means the logo is being touched
-//	False means the logo is not being touched
+void capacitive_touch_burst(uint8_t rounds, uint32_t interval_us) {
+  if (rounds == 0 || pad_count == 0) {
+    return;
+  }
+  // A burst still running when the next one is due just carries on
+  burst_rounds = rounds;
+  round_period_us = interval_us / rounds;
+  if (running) {
+    return;
+  }
+  running = true;
+  if (!scanning) {
+    start_capacitive_test();
+  }
+}
+
+// Determines whether pad <pad> is being touched
+//	True means the pad is being touched
+//	False means the pad is not being touched
 //
 // Function returns immediately without blocking
-bool capacitive_touch_is_active(void) {
+bool capacitive_touch_is_active(uint8_t pad) {
   // return latest reading from the capacitive touch sensor
-  return touch_active;
+  return pad < pad_count && pads[pad].active;
 }
 
+uint32_t capacitive_touch_strength(uint8_t pad) {
+  if (pad >= pad_count || pads[pad].calibration_count < CALIBRATION_SAMPLES) {
+    return 0;
+  }
+  uint32_t baseline = pads[pad].baseline_scaled >> BASELINE_SHIFT;
+  return pads[pad].last > baseline ? pads[pad].last - baseline : 0;
+}
+
+uint32_t capacitive_touch_round_us(void) {
+  return round_period_us;
+}
+
+void capacitive_touch_print_stats(void) {
+  uint32_t scan_count = scans;
+  if (scan_count == 0) {
+    return;
+  }
+
+  // Rounds come every round period, so scans tell the time. TIMER0 only runs
+  // for the scans themselves
+  uint64_t elapsed_us = (uint64_t)scan_count * round_period_us / scans_per_round;
+  uint32_t load = (uint32_t)((uint64_t)isr_cycles * 10000 / CYCLES_PER_US / elapsed_us);
+  uint32_t timer_on = scans_per_round * CAPACITIVE_TOUCH_SCAN_US * 100 / round_period_us;
+  printf("Touch: %u pads, %u scans per round, %lu Hz per pad, CPU load %lu.%02lu%%, TIMER0 on %lu%%\n", pad_count,
+      scans_per_round, 1000000 / capacitive_touch_round_us(), load / 100, load % 100, timer_on);
+
+  for (uint8_t i = 0; i < pad_count; i++) {
+    touch_pad_t* pad = &pads[i];
+    if (pad->samples == 0) {
+      continue;
+    }
+    printf("  Pad %u: %lu samples, %lu timeouts, charge avg %lu max %lu us, baseline %lu us, %lu touches, %lu recalibrations\n",
+        i, pad->samples, pad->timeouts, (uint32_t)(pad->sample_sum / pad->samples / TICKS_PER_US),
+        pad->sample_max / TICKS_PER_US, (pad->baseline_scaled >> BASELINE_SHIFT) / TICKS_PER_US, pad->touches,
+        pad->recalibrations);
+    pad->samples = 0;
+    pad->timeouts = 0;
+    pad->sample_sum = 0;
+    pad->sample_max = 0;
+    pad->touches = 0;
+    pad->recalibrations = 0;
+  }
+  scans = 0;
+  isr_cycles = 0;
+}
@@ -1,15 +1,83 @@
 #pragma once
 
 #include <stdbool.h>
+#include <stdint.h>
 
-// Starts continuously measuring capacitive touch for the logo
+// Pads measured by one driver. The logo and the ring pins (edge P0 to P2)
+// have pull-ups on the board, any other edge pin needs a ~10 MOhm pull-up
+// resistor to 3V to work as a pad
+#define CAPACITIVE_TOUCH_MAX_PADS 6
+
+// Pads measured at the same time, each with a GPIOTE channel, a PPI channel
+// and a TIMER0 capture register of its own. The pads take turns on these
+// lanes, so every pad is measured once per round of
+// ceil(pads / CAPACITIVE_TOUCH_LANES) scans
+#define CAPACITIVE_TOUCH_LANES 2
+
+// GPIOTE channels used by the lanes, taken from the top so they stay clear of
+// the channels nrfx_gpiote hands out from the bottom
+#define CAPACITIVE_TOUCH_GPIOTE_CHANNEL 6
+
+// Charge-time measurement, in microseconds
+// The pads are released at the start of each scan and must charge within the
+// timeout, otherwise the sample counts as the timeout. Between the timeout and
+// the end of the scan the pads are held low to discharge
+#define CAPACITIVE_TOUCH_TIMEOUT_US 500
+#define CAPACITIVE_TOUCH_SCAN_US 2000
+
+// Touch detection, relative to the untouched baseline
+// A touch needs the charge time this many percent above the baseline, and a
+// release needs it back below the lower release threshold
+#define CAPACITIVE_TOUCH_PRESS_PERCENT 30
+#define CAPACITIVE_TOUCH_RELEASE_PERCENT 15
+#define CAPACITIVE_TOUCH_DEBOUNCE 3 // Samples in a row before the state changes
+
+// Called from the TIMER0 interrupt when pad <pad> is touched or released
+typedef void (*capacitive_touch_handler_t)(uint8_t pad, bool touched);
+
+// Called from the TIMER0 interrupt after every pad was measured once
+typedef void (*capacitive_touch_round_handler_t)(void);
+
+// Starts continuously measuring capacitive touch on <count> pads
+// <pins> are in pad order, pad numbers index into it
 // Function returns immediately without blocking
-void capacitive_touch_init(void);
+// The first samples calibrate the baselines, so keep off the pads for a moment
+// Needs nrfx_gpiote_init() first. Uses TIMER0, CAPACITIVE_TOUCH_LANES GPIOTE
+// and PPI channels. The handler may be NULL
+void capacitive_touch_init(const uint32_t* pins, uint8_t count, capacitive_touch_handler_t handler);
 
-// Determines whether the logo is being touched
-//	True means the logo is being touched
-//	False means the logo is not being touched
+// Measure a different set of pads. Stops measuring, call start afterwards
+void capacitive_touch_set_pads(const uint32_t* pins, uint8_t count);
+
+// Called after each round, e.g. to update a slider. NULL to remove
+void capacitive_touch_set_round_handler(capacitive_touch_round_handler_t handler);
+
+// Pause and resume measuring. TIMER0 keeps HFCLK running while measuring
+void capacitive_touch_stop(void);
+void capacitive_touch_start(void);
+
+// Measure <rounds> rounds back to back, then stop
+// For duty-cycled measuring started every <interval_us> from a low-power
+// timer, so TIMER0 and HFCLK only run during the burst. Replaces continuous
+// measuring until the next capacitive_touch_start()
+void capacitive_touch_burst(uint8_t rounds, uint32_t interval_us);
+
+// Determines whether pad <pad> is being touched
+//	True means the pad is being touched
+//	False means the pad is not being touched
 //
 // Function returns immediately without blocking
-bool capacitive_touch_is_active(void);
+bool capacitive_touch_is_active(uint8_t pad);
+
+// Latest charge time of <pad> above its baseline, in timer ticks (16 MHz)
+// 0 while calibrating or at or below the baseline
+uint32_t capacitive_touch_strength(uint8_t pad);
+
+// Time between rounds, how often each pad is measured. One round's scans
+// while measuring continuously, the burst interval spread over its rounds
+// while bursting
+uint32_t capacitive_touch_round_us(void);
 
+// Print scan rate per pad, CPU load, charge times and touch events since the
+// last call
+void capacitive_touch_print_stats(void);
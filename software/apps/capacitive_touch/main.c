@@ -1,6 +1,7 @@
 // Capacitive Touch app
 //
-// Use capacitance to detect touch on the microbit logo pad
+// Use capacitance to detect touch on the microbit logo pad and a slider made
+// of the three ring pins on the edge connector
 
 #include <stdbool.h>
 #include <stdint.h>
@@ -12,6 +13,43 @@
 
 #include "microbit_v2.h"
 #include "capacitive_touch.h"
+#include "touch_slider.h"
+
+// Pad 0 is the logo, pads 1 to 3 the slider. The benchmark adds EDGE_P8,
+// which times out every scan without a pull-up but costs the same to measure
+static const uint32_t pad_pins[] = {TOUCH_LOGO, TOUCH_RING0, TOUCH_RING1, TOUCH_RING2, EDGE_P8};
+#define SLIDER_FIRST_PAD 1
+#define SLIDER_PADS 3
+
+static touch_slider_t slider;
+
+// Set from the touch interrupt, printed from the main loop
+static volatile bool logo_changed = false;
+static volatile touch_gesture_t gesture = TOUCH_GESTURE_NONE;
+
+static void touch_handler(uint8_t pad, bool touched) {
+  if (pad == 0) {
+    logo_changed = true;
+  }
+}
+
+static void round_handler(void) {
+  touch_gesture_t finished = touch_slider_update(&slider, capacitive_touch_round_us());
+  if (finished != TOUCH_GESTURE_NONE) {
+    gesture = finished;
+  }
+}
+
+// Scan rate and CPU load with 1, 3 and 5 pads sharing the lanes
+static void benchmark(void) {
+  static const uint8_t pad_counts[] = {1, 3, 5};
+  for (int i = 0; i < 3; i++) {
+    capacitive_touch_set_pads(pad_pins, pad_counts[i]);
+    capacitive_touch_start();
+    nrf_delay_ms(5000);
+    capacitive_touch_print_stats();
+  }
+}
 
 int main(void) {
   printf("Board started!\n");
@@ -19,16 +57,40 @@ int main(void) {
   // intialize drivers
   nrfx_gpiote_init();
   app_timer_init();
-  
+
   // start capacitive touch driver
-  capacitive_touch_init();
+  capacitive_touch_init(pad_pins, 1, touch_handler);
+  benchmark();
+
+  // logo and slider
+  capacitive_touch_set_pads(pad_pins, SLIDER_FIRST_PAD + SLIDER_PADS);
+  touch_slider_init(&slider, SLIDER_FIRST_PAD, SLIDER_PADS);
+  capacitive_touch_set_round_handler(round_handler);
+  capacitive_touch_start();
 
   // loop forever
+  uint32_t loops = 0;
   while (1) {
     // Faster than normal so that we can see the touch sensor responding
     nrf_delay_ms(100);
 
-    // Add some stuff here to demonstrate that your driver works
+    if (logo_changed) {
+      logo_changed = false;
+      printf("Logo %s\n", capacitive_touch_is_active(0) ? "touched" : "released");
+    }
+
+    uint16_t position = 0;
+    if (touch_slider_position(&slider, &position)) {
+      printf("Slider at %u\n", position);
+    }
+    if (gesture != TOUCH_GESTURE_NONE) {
+      printf("Slider %s\n", touch_gesture_name(gesture));
+      gesture = TOUCH_GESTURE_NONE;
+    }
+
+    // Charge times every 5 seconds, to tune the thresholds
+    if (++loops % 50 == 0) {
+      capacitive_touch_print_stats();
+    }
   }
 }
-
@@ -0,0 +1,99 @@
+// Slider position and swipe gestures over a row of touch pads
+//
+// Pads report touch and release with some debounce, so the last rounds of a
+// touch already have the finger lifting off. The position only follows rounds
+// where the strongest pad is still touched, which keeps a swipe's end point
+// from sliding back towards the middle.
+
+#include "touch_slider.h"
+#include "capacitive_touch.h"
+
+static const char* gesture_names[] = {
+  [TOUCH_GESTURE_NONE] = "none",
+  [TOUCH_GESTURE_TAP] = "tap",
+  [TOUCH_GESTURE_SWIPE_FORWARD] = "swipe forward",
+  [TOUCH_GESTURE_SWIPE_BACK] = "swipe back",
+};
+
+void touch_slider_init(touch_slider_t* slider, uint8_t first_pad, uint8_t pad_count) {
+  slider->first_pad = first_pad;
+  slider->pad_count = pad_count;
+  slider->touching = false;
+  slider->position = 0;
+  slider->start_position = 0;
+  slider->touch_us = 0;
+}
+
+// Centroid of the strengths, false unless the strongest pad is touched
+static bool centroid(const touch_slider_t* slider, uint16_t* position) {
+  uint32_t weighted = 0;
+  uint32_t total = 0;
+  uint32_t strongest = 0;
+  uint8_t strongest_pad = slider->first_pad;
+  for (uint8_t i = 0; i < slider->pad_count; i++) {
+    uint8_t pad = slider->first_pad + i;
+    uint32_t strength = capacitive_touch_strength(pad);
+    weighted += strength * i * TOUCH_SLIDER_PAD_STEP;
+    total += strength;
+    if (strength > strongest) {
+      strongest = strength;
+      strongest_pad = pad;
+    }
+  }
+  if (total == 0 || !capacitive_touch_is_active(strongest_pad)) {
+    return false;
+  }
+  *position = weighted / total;
+  return true;
+}
+
+touch_gesture_t touch_slider_update(touch_slider_t* slider, uint32_t round_us) {
+  bool touching = false;
+  for (uint8_t i = 0; i < slider->pad_count; i++) {
+    touching |= capacitive_touch_is_active(slider->first_pad + i);
+  }
+
+  if (touching) {
+    uint16_t position = slider->position;
+    bool found = centroid(slider, &position);
+    if (!slider->touching) {
+      // A touch only starts once a position is known
+      if (!found) {
+        return TOUCH_GESTURE_NONE;
+      }
+      slider->touching = true;
+      slider->start_position = position;
+      slider->touch_us = 0;
+    } else {
+      slider->touch_us += round_us;
+    }
+    slider->position = position;
+    return TOUCH_GESTURE_NONE;
+  }
+
+  if (!slider->touching) {
+    return TOUCH_GESTURE_NONE;
+  }
+  slider->touching = false;
+  if (slider->touch_us > TOUCH_SLIDER_SWIPE_MAX_US) {
+    return TOUCH_GESTURE_NONE;
+  }
+
+  int32_t travel = (int32_t)slider->position - slider->start_position;
+  if (travel >= TOUCH_SLIDER_SWIPE_DISTANCE) {
+    return TOUCH_GESTURE_SWIPE_FORWARD;
+  }
+  if (travel <= -TOUCH_SLIDER_SWIPE_DISTANCE) {
+    return TOUCH_GESTURE_SWIPE_BACK;
+  }
+  return TOUCH_GESTURE_TAP;
+}
+
+bool touch_slider_position(const touch_slider_t* slider, uint16_t* position) {
+  *position = slider->position;
+  return slider->touching;
+}
+
+const char* touch_gesture_name(touch_gesture_t gesture) {
+  return gesture <= TOUCH_GESTURE_SWIPE_BACK ? gesture_names[gesture] : "?";
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Slider position and swipe gestures over a row of touch pads
+//
+// The position is the centroid of the pads' charge times above their
+// baselines, so a finger between two pads lands between them. It runs from 0
+// at the first pad to (pads - 1) * TOUCH_SLIDER_PAD_STEP at the last.
+
+#define TOUCH_SLIDER_PAD_STEP 256
+#define TOUCH_SLIDER_SWIPE_DISTANCE (TOUCH_SLIDER_PAD_STEP / 2) // Travel that makes a swipe
+#define TOUCH_SLIDER_SWIPE_MAX_US 800000 // Longer touches are holds, not swipes
+
+typedef enum {
+  TOUCH_GESTURE_NONE,
+  TOUCH_GESTURE_TAP,           // Touched and released without moving
+  TOUCH_GESTURE_SWIPE_FORWARD, // Moved towards the last pad
+  TOUCH_GESTURE_SWIPE_BACK,    // Moved towards the first pad
+} touch_gesture_t;
+
+typedef struct {
+  uint8_t first_pad; // Capacitive touch pad numbers of the slider, in order
+  uint8_t pad_count;
+
+  bool touching;
+  uint16_t position;
+  uint16_t start_position;
+  uint32_t touch_us;
+} touch_slider_t;
+
+void touch_slider_init(touch_slider_t* slider, uint8_t first_pad, uint8_t pad_count);
+
+// Feed one round of measurements, <round_us> after the last one. Call from
+// the capacitive touch round handler. Returns the gesture finished by this
+// round, if any
+touch_gesture_t touch_slider_update(touch_slider_t* slider, uint32_t round_us);
+
+// Position of the finger, false when the slider isn't touched
+bool touch_slider_position(const touch_slider_t* slider, uint16_t* position);
+
+const char* touch_gesture_name(touch_gesture_t gesture);
@@ -1,51 +1,147 @@
 #include "gpio.h"
 
+#include <stddef.h>
+#include <stdio.h>
+
 typedef struct{
-  // Step 3:
-  // Add register definitions here
+  uint32_t OUT;        // 0x504
+  uint32_t OUTSET;     // 0x508
+  uint32_t OUTCLR;     // 0x50C
+  uint32_t IN;         // 0x510
+  uint32_t DIR;        // 0x514
+  uint32_t DIRSET;     // 0x518
+  uint32_t DIRCLR;     // 0x51C
+  uint32_t LATCH;      // 0x520
+  uint32_t DETECTMODE; // 0x524
+  uint32_t _unused[118];
+  uint32_t PIN_CNF[32]; // 0x700
 } gpio_reg_t;
 
-// Inputs: 
+_Static_assert(offsetof(gpio_reg_t, PIN_CNF) == 0x700 - 0x504, "PIN_CNF must be at 0x700");
+
+// Port registers, starting at OUT
+static volatile gpio_reg_t* const ports[GPIO_PORT_COUNT] = {
+  (volatile gpio_reg_t*)0x50000504,
+  (volatile gpio_reg_t*)0x50000804,
+};
+
+// PIN_CNF fields
+#define PIN_CNF_DIR_OUTPUT (1 << 0)
+#define PIN_CNF_INPUT_DISCONNECT (1 << 1)
+
+static volatile gpio_reg_t* port_of(uint8_t gpio_num) {
+  return ports[gpio_num >> 5];
+}
+
+static uint32_t bit_of(uint8_t gpio_num) {
+  return 1UL << (gpio_num & 0x1F);
+}
+
+// Inputs:
 //  gpio_num - gpio number 0-31 OR (32 + gpio number)
 //  dir - gpio direction (INPUT, OUTPUT)
 void gpio_config(uint8_t gpio_num, gpio_direction_t dir) {
-  // Implement me
-  // This function should configure the pin as an input/output
-  // Hint: Use proper PIN_CNF instead of DIR
+  // Inputs keep their input buffer, outputs disconnect it like the SDK does
+  // No pull, standard drive, no sense
+  uint32_t cnf = (dir == GPIO_OUTPUT) ? (PIN_CNF_DIR_OUTPUT | PIN_CNF_INPUT_DISCONNECT) : 0;
+  port_of(gpio_num)->PIN_CNF[gpio_num & 0x1F] = cnf;
 }
 
-// Inputs: 
+// Inputs:
 //  gpio_num - gpio number 0-31 OR (32 + gpio number)
 void gpio_set(uint8_t gpio_num) {
-  // Implement me
-  // This function should make the pin high
-  // It can assume that the pin has already been configured
+  port_of(gpio_num)->OUTSET = bit_of(gpio_num);
 }
 
-// Inputs: 
+// Inputs:
 //  gpio_num - gpio number 0-31 OR (32 + gpio number)
 void gpio_clear(uint8_t gpio_num) {
-  // Implement me
-  // This function should make the pin low
-  // It can assume that the pin has already been configured
+  port_of(gpio_num)->OUTCLR = bit_of(gpio_num);
 }
 
-// Inputs: 
+// Inputs:
 //  gpio_num - gpio number 0-31 OR (32 + gpio number)
 // Output:
 //  bool - pin state (true == high)
 bool gpio_read(uint8_t gpio_num) {
-  // Implement me
-  // This function should read the value from the pin
-  // It can assume that the pin has already been configured
+  return (port_of(gpio_num)->IN & bit_of(gpio_num)) != 0;
+}
+
+gpio_mask_t gpio_mask(const uint8_t* gpio_nums, uint8_t count) {
+  gpio_mask_t mask = {{0, 0}};
+  for (uint8_t i = 0; i < count; i++) {
+    mask.port[gpio_nums[i] >> 5] |= bit_of(gpio_nums[i]);
+  }
+  return mask;
+}
 
-  return true;
+void gpio_config_mask(const gpio_mask_t* mask, gpio_direction_t dir) {
+  for (uint8_t port = 0; port < GPIO_PORT_COUNT; port++) {
+    for (uint8_t pin = 0; pin < 32; pin++) {
+      if (mask->port[port] & (1UL << pin)) {
+        gpio_config(port * 32 + pin, dir);
+      }
+    }
+  }
+}
+
+// Ports without pins in the mask are left alone, not written with 0
+void gpio_set_mask(const gpio_mask_t* mask) {
+  for (uint8_t port = 0; port < GPIO_PORT_COUNT; port++) {
+    if (mask->port[port]) {
+      ports[port]->OUTSET = mask->port[port];
+    }
+  }
+}
+
+void gpio_clear_mask(const gpio_mask_t* mask) {
+  for (uint8_t port = 0; port < GPIO_PORT_COUNT; port++) {
+    if (mask->port[port]) {
+      ports[port]->OUTCLR = mask->port[port];
+    }
+  }
+}
+
+void gpio_toggle_mask(const gpio_mask_t* mask) {
+  // An interrupt changing the same port between the read and the write
+  // would be undone by it
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+  for (uint8_t port = 0; port < GPIO_PORT_COUNT; port++) {
+    if (mask->port[port]) {
+      ports[port]->OUT ^= mask->port[port];
+    }
+  }
+  __set_PRIMASK(primask);
+}
+
+void gpio_write_mask(const gpio_mask_t* mask, const gpio_mask_t* values) {
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+  for (uint8_t port = 0; port < GPIO_PORT_COUNT; port++) {
+    if (mask->port[port]) {
+      uint32_t out = ports[port]->OUT;
+      ports[port]->OUT = (out & ~mask->port[port]) | (values->port[port] & mask->port[port]);
+    }
+  }
+  __set_PRIMASK(primask);
+}
+
+gpio_mask_t gpio_read_ports(void) {
+  gpio_mask_t values;
+  for (uint8_t port = 0; port < GPIO_PORT_COUNT; port++) {
+    values.port[port] = ports[port]->IN;
+  }
+  return values;
 }
 
 // prints out some information about the GPIO driver. Can be called from main()
 void gpio_print(void) {
-  // Use this function for debugging purposes
-  // For example, you could print out struct field addresses
-  // You don't otherwise have to write anything here
+  // Register addresses should match the datasheet: OUT at 0x504 and PIN_CNF[0]
+  // at 0x700 past each port's base, 0x50000000 and 0x50000300
+  for (uint8_t port = 0; port < GPIO_PORT_COUNT; port++) {
+    printf("P%u: OUT %p, IN %p, PIN_CNF[0] %p, OUT 0x%08lx, DIR 0x%08lx, IN 0x%08lx\n", port,
+        (void*)&ports[port]->OUT, (void*)&ports[port]->IN, (void*)&ports[port]->PIN_CNF[0],
+        ports[port]->OUT, ports[port]->DIR, ports[port]->IN);
+  }
 }
-
@@ -8,25 +8,75 @@ typedef enum {
   GPIO_OUTPUT,
 } gpio_direction_t;
 
-// Inputs: 
+// Number of GPIO ports: P0 has pins 0-31, P1 has pins 0-9
+#define GPIO_PORT_COUNT 2
+
+// A set of pins on both ports
+// Bit N of port[P] is pin P.N, which is gpio number (32 * P + N)
+typedef struct {
+  uint32_t port[GPIO_PORT_COUNT];
+} gpio_mask_t;
+
+// Inputs:
 //  gpio_num - gpio number 0-31 OR (32 + gpio number)
 //  dir - gpio direction (INPUT, OUTPUT)
 void gpio_config(uint8_t gpio_num, gpio_direction_t dir);
 
-// Inputs: 
+// Inputs:
 //  gpio_num - gpio number 0-31 OR (32 + gpio number)
 void gpio_set(uint8_t gpio_num);
 
-// Inputs: 
+// Inputs:
 //  gpio_num - gpio number 0-31 OR (32 + gpio number)
 void gpio_clear(uint8_t gpio_num);
 
-// Inputs: 
+// Inputs:
 //  gpio_num - gpio number 0-31 OR (32 + gpio number)
 // Returns:
 //  current state of the specified gpio pin (true == high)
 bool gpio_read(uint8_t gpio_num);
 
+// Batched operations
+// Each one touches every pin in the mask with a single register write per
+// port, so pins on the same port change at the same instant
+
+// Inputs:
+//  gpio_nums - array of gpio numbers, same format as above
+//  count - length of the array
+// Returns:
+//  mask with a bit set for every pin in the array
+gpio_mask_t gpio_mask(const uint8_t* gpio_nums, uint8_t count);
+
+// Inputs:
+//  mask - pins to configure
+//  dir - gpio direction (INPUT, OUTPUT)
+// PIN_CNF has one register per pin, so this is one write per pin
+void gpio_config_mask(const gpio_mask_t* mask, gpio_direction_t dir);
+
+// Inputs:
+//  mask - pins to make high, with one OUTSET write per port
+void gpio_set_mask(const gpio_mask_t* mask);
+
+// Inputs:
+//  mask - pins to make low, with one OUTCLR write per port
+void gpio_clear_mask(const gpio_mask_t* mask);
+
+// Inputs:
+//  mask - pins to invert
+// There is no OUTTOGGLE register, so OUT is read and written back with
+// interrupts masked, one write per port
+void gpio_toggle_mask(const gpio_mask_t* mask);
+
+// Inputs:
+//  mask - pins to change
+//  values - new state of each pin in the mask (bit set == high)
+// Pins going high and low change together, in one OUT write per port made
+// with interrupts masked. Pins outside the mask keep their state
+void gpio_write_mask(const gpio_mask_t* mask, const gpio_mask_t* values);
+
+// Returns:
+//  input state of every pin on both ports, one IN read per port
+gpio_mask_t gpio_read_ports(void);
+
 // prints out some information about the GPIO driver. Can be called from main()
 void gpio_print(void);
-
@@ -12,26 +12,55 @@
 #include "microbit_v2.h"
 #include "gpio.h"
 
+// LED matrix pins. Rows are active high, columns active low
+static const uint8_t row_pins[] = {LED_ROW1, LED_ROW2, LED_ROW3, LED_ROW4, LED_ROW5};
+static const uint8_t col_pins[] = {LED_COL1, LED_COL2, LED_COL3, LED_COL4, LED_COL5};
+
 int main(void) {
   printf("Board started!\n");
+  gpio_print();
 
   // Turn on all LEDs on the back of the Microbit
-  // Add code here
+  // All rows and columns change with one write per port instead of ten calls
+  gpio_mask_t rows = gpio_mask(row_pins, 5);
+  gpio_mask_t cols = gpio_mask(col_pins, 5);
+  gpio_config_mask(&rows, GPIO_OUTPUT);
+  gpio_config_mask(&cols, GPIO_OUTPUT);
+  gpio_set_mask(&rows);
+  gpio_clear_mask(&cols);
 
   // Control LED with raw MMIO
   // Microphone LED is P0.20 and active high
-  // Add code here
+  volatile uint32_t* p0_pin_cnf_20 = (volatile uint32_t*)(0x50000700 + 20 * 4);
+  volatile uint32_t* p0_outset = (volatile uint32_t*)0x50000508;
+  *p0_pin_cnf_20 = 1; // output, input buffer connected
+  *p0_outset = 1 << 20;
+
+  gpio_config(BTN_A, GPIO_INPUT);
+  gpio_config(BTN_B, GPIO_INPUT);
 
   // loop forever
   printf("Looping\n");
+  uint32_t loops = 0;
   while (1) {
 
     // Control LED with buttons
     // Button A is P0.14 and active low
     // Button B is P0.23 and active low
-    // Add code here
+    // Both buttons come from a single read of P0
+    gpio_mask_t inputs = gpio_read_ports();
+    if (!(inputs.port[0] & (1UL << 14))) {
+      gpio_set(LED_MIC);
+    } else if (!(inputs.port[0] & (1UL << 23))) {
+      gpio_clear(LED_MIC);
+    }
+
+    // Blink the matrix every half second, every column flips in the same
+    // write on each port
+    if (++loops % 5 == 0) {
+      gpio_toggle_mask(&cols);
+    }
 
     nrf_delay_ms(100);
   }
 }
-
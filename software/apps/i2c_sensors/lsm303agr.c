@@ -5,115 +5,253 @@
 
 #include <stdbool.h>
 #include <stdint.h>
+#include <stdio.h>
 
+#include "app_error.h"
+#include "i2c_bus.h"
 #include "lsm303agr.h"
+#include "microbit_v2.h"
 #include "nrf_delay.h"
+#include "nrfx_gpiote.h"
 
-// Pointer to an initialized I2C instance to use for transactions
-static const nrf_twi_mngr_t* i2c_manager = NULL;
+// Accelerometer and magnetometer on the shared bus
+// Register shadows let configuration writes be staged and sent as bursts
+static i2c_device_t acc_device;
+static i2c_device_t mag_device;
+static uint8_t acc_registers[ACT_DUR_A + 1];
+static uint8_t mag_registers[OUTZ_H_REG_M + 1];
 
-// Helper function to perform a 1-byte I2C read of a given register
-//
-// i2c_addr - address of the device to read from
-// reg_addr - address of the register within the device to read
-//
-// returns 8-bit read value
-static uint8_t i2c_reg_read(uint8_t i2c_addr, uint8_t reg_addr) {
-  uint8_t rx_buf = 0;
-  nrf_twi_mngr_transfer_t const read_transfer[] = {
-    //TODO: implement me
-  };
-  ret_code_t result = nrf_twi_mngr_perform(i2c_manager, NULL, read_transfer, 2, NULL);
-  if (result != NRF_SUCCESS) {
-    // Likely error codes:
-    //  NRF_ERROR_INTERNAL            (0x0003) - something is wrong with the driver itself
-    //  NRF_ERROR_INVALID_ADDR        (0x0010) - buffer passed was in Flash instead of RAM
-    //  NRF_ERROR_BUSY                (0x0011) - driver was busy with another transfer still
-    //  NRF_ERROR_DRV_TWI_ERR_OVERRUN (0x8200) - data was overwritten during the transaction
-    //  NRF_ERROR_DRV_TWI_ERR_ANACK   (0x8201) - i2c device did not acknowledge its address
-    //  NRF_ERROR_DRV_TWI_ERR_DNACK   (0x8202) - i2c device did not acknowledge a data byte
-    printf("I2C transaction failed! Error: %lX\n", result);
-  }
+// Set in the register address to read or write several accelerometer
+// registers in one transaction. The magnetometer always auto-increments
+#define AUTO_INCREMENT 0x80
 
-  return rx_buf;
-}
+// FIFO control bits
+#define CTRL_REG3_I1_WTM 0x04
+#define CTRL_REG5_FIFO_EN 0x40
+#define CTRL_REG6_H_LACTIVE 0x02
+#define FIFO_MODE_BYPASS 0x00
+#define FIFO_MODE_STREAM 0x80
+#define FIFO_SRC_FSS_MASK 0x1F
+#define FIFO_SRC_OVRN 0x40
 
-// Helper function to perform a 1-byte I2C write of a given register
-//
-// i2c_addr - address of the device to write to
-// reg_addr - address of the register within the device to write
-static void i2c_reg_write(uint8_t i2c_addr, uint8_t reg_addr, uint8_t data) {
-  //TODO: implement me
-  //Note: there should only be a single two-byte transfer to be performed
+// Bytes per accelerometer sample (X, Y, Z as 16-bit little endian)
+#define SAMPLE_BYTES 6
+
+// FIFO statistics
+static uint32_t fifo_samples = 0;
+static uint32_t fifo_drains = 0;
+static uint32_t fifo_overruns = 0;
+
+// FIFO state
+static lsm303agr_fifo_callback_t fifo_callback = NULL;
+static volatile bool fifo_watermark = false;
+static uint8_t fifo_buffer[LSM303AGR_FIFO_DEPTH * SAMPLE_BYTES];
+static lsm303agr_measurement_t fifo_measurements[LSM303AGR_FIFO_DEPTH];
+
+// Convert a left-justified 10-bit accelerometer reading to g's
+// Normal mode at +/-2g is 3.9 mg per digit
+static float acc_to_g(const uint8_t* raw) {
+  int16_t value = (int16_t)(raw[0] | (raw[1] << 8));
+  return (value >> 6) * 0.0039f;
 }
 
 // Initialize and configure the LSM303AGR accelerometer/magnetometer
 //
-// i2c - pointer to already initialized and enabled twim instance
-void lsm303agr_init(const nrf_twi_mngr_t* i2c) {
-  i2c_manager = i2c;
+// bus - already initialized shared I2C bus the sensor is on
+void lsm303agr_init(i2c_bus_t* bus) {
+  i2c_device_init(&acc_device, bus, LSM303AGR_ACC_ADDRESS, AUTO_INCREMENT,
+      acc_registers, sizeof(acc_registers), "LSM303AGR acc");
+  i2c_device_init(&mag_device, bus, LSM303AGR_MAG_ADDRESS, 0,
+      mag_registers, sizeof(mag_registers), "LSM303AGR mag");
+  i2c_device_set_id(&acc_device, WHO_AM_I_A, LSM303AGR_ACC_WHO_AM_I);
+  i2c_device_set_id(&mag_device, WHO_AM_I_M, LSM303AGR_MAG_WHO_AM_I);
 
   // ---Initialize Accelerometer---
 
   // Reboot acclerometer
-  i2c_reg_write(LSM303AGR_ACC_ADDRESS, CTRL_REG5_A, 0x80);
+  i2c_device_write_reg(&acc_device, CTRL_REG5_A, 0x80);
   nrf_delay_ms(100); // needs delay to wait for reboot
 
-  // Enable Block Data Update
-  // Only updates sensor data when both halves of the data has been read
-  i2c_reg_write(LSM303AGR_ACC_ADDRESS, CTRL_REG4_A, 0x80);
+  // Enable temperature sensor
+  i2c_device_stage(&acc_device, TEMP_CFG_REG_A, 0xC0);
 
   // Configure accelerometer at 100Hz, normal mode (10-bit)
   // Enable x, y and z axes
-  i2c_reg_write(LSM303AGR_ACC_ADDRESS, CTRL_REG1_A, 0x57);
+  i2c_device_stage(&acc_device, CTRL_REG1_A, 0x57);
+  i2c_device_stage(&acc_device, CTRL_REG2_A, 0x00);
+  i2c_device_stage(&acc_device, CTRL_REG3_A, 0x00);
+
+  // Enable Block Data Update
+  // Only updates sensor data when both halves of the data has been read
+  i2c_device_stage(&acc_device, CTRL_REG4_A, 0x80);
+
+  // Clear the boot bit in the shadow and leave the FIFO off
+  i2c_device_stage(&acc_device, CTRL_REG5_A, 0x00);
+  i2c_device_stage(&acc_device, CTRL_REG6_A, 0x00);
+
+  // TEMP_CFG_REG_A through CTRL_REG6_A go out as one burst
+  i2c_device_flush(&acc_device);
 
   // Read WHO AM I register
   // Always returns the same value if working
-  //TODO: read the Accelerometer WHO AM I register and check the result
+  uint8_t acc_id = i2c_device_read_reg(&acc_device, WHO_AM_I_A);
+  if (acc_id != LSM303AGR_ACC_WHO_AM_I) {
+    printf("Accelerometer WHO_AM_I mismatch: 0x%02X\n", acc_id);
+  }
 
   // ---Initialize Magnetometer---
 
   // Reboot magnetometer
-  i2c_reg_write(LSM303AGR_MAG_ADDRESS, CFG_REG_A_M, 0x40);
+  i2c_device_write_reg(&mag_device, CFG_REG_A_M, 0x40);
   nrf_delay_ms(100); // needs delay to wait for reboot
 
+  // Configure magnetometer at 100Hz, continuous mode
+  i2c_device_stage(&mag_device, CFG_REG_A_M, 0x0C);
+  i2c_device_stage(&mag_device, CFG_REG_B_M, 0x00);
+
   // Enable Block Data Update
   // Only updates sensor data when both halves of the data has been read
-  i2c_reg_write(LSM303AGR_MAG_ADDRESS, CFG_REG_C_M, 0x10);
+  i2c_device_stage(&mag_device, CFG_REG_C_M, 0x10);
 
-  // Configure magnetometer at 100Hz, continuous mode
-  i2c_reg_write(LSM303AGR_MAG_ADDRESS, CFG_REG_A_M, 0x0C);
+  i2c_device_flush(&mag_device);
 
   // Read WHO AM I register
-  //TODO: read the Magnetometer WHO AM I register and check the result
-
-  // ---Initialize Temperature---
-
-  // Enable temperature sensor
-  i2c_reg_write(LSM303AGR_ACC_ADDRESS, TEMP_CFG_REG_A, 0xC0);
+  uint8_t mag_id = i2c_device_read_reg(&mag_device, WHO_AM_I_M);
+  if (mag_id != LSM303AGR_MAG_WHO_AM_I) {
+    printf("Magnetometer WHO_AM_I mismatch: 0x%02X\n", mag_id);
+  }
 }
 
 // Read the internal temperature sensor
 //
 // Return measurement as floating point value in degrees C
 float lsm303agr_read_temperature(void) {
-  //TODO: implement me
+  uint8_t raw[2];
+  i2c_device_read_regs(&acc_device, OUT_TEMP_L_A, raw, sizeof(raw));
 
-  return 0.0;
+  // Left-justified, 1 digit per degree above 25 C in normal mode
+  int16_t value = (int16_t)(raw[0] | (raw[1] << 8));
+  return value / 256.0f + 25.0f;
 }
 
 lsm303agr_measurement_t lsm303agr_read_accelerometer(void) {
-  //TODO: implement me
+  // All six output registers in one transaction
+  uint8_t raw[SAMPLE_BYTES];
+  i2c_device_read_regs(&acc_device, OUT_X_L_A, raw, sizeof(raw));
 
-  lsm303agr_measurement_t measurement = {0};
+  lsm303agr_measurement_t measurement = {
+    .x_axis = acc_to_g(&raw[0]),
+    .y_axis = acc_to_g(&raw[2]),
+    .z_axis = acc_to_g(&raw[4]),
+  };
   return measurement;
 }
 
 lsm303agr_measurement_t lsm303agr_read_magnetometer(void) {
-  //TODO: implement me
-
-  lsm303agr_measurement_t measurement = {0};
+  uint8_t raw[6];
+  i2c_device_read_regs(&mag_device, OUTX_L_REG_M, raw, sizeof(raw));
 
+  // 1.5 mGauss (0.15 uT) per digit
+  lsm303agr_measurement_t measurement = {
+    .x_axis = (int16_t)(raw[0] | (raw[1] << 8)) * 0.15f,
+    .y_axis = (int16_t)(raw[2] | (raw[3] << 8)) * 0.15f,
+    .z_axis = (int16_t)(raw[4] | (raw[5] << 8)) * 0.15f,
+  };
   return measurement;
 }
 
+// Watermark interrupt, only flags the FIFO for draining
+static void fifo_interrupt_handler(nrfx_gpiote_pin_t pin, nrf_gpiote_polarity_t action) {
+  fifo_watermark = true;
+}
+
+void lsm303agr_fifo_start(uint8_t watermark, lsm303agr_fifo_callback_t callback) {
+  if (watermark == 0 || watermark >= LSM303AGR_FIFO_DEPTH) {
+    watermark = LSM303AGR_FIFO_DEPTH - 1;
+  }
+  fifo_callback = callback;
+  fifo_watermark = false;
+
+  // Watermark interrupt on INT1, active low to match the shared interrupt line
+  if (!nrfx_gpiote_is_init()) {
+    APP_ERROR_CHECK(nrfx_gpiote_init());
+  }
+  nrfx_gpiote_in_config_t config = NRFX_GPIOTE_CONFIG_IN_SENSE_HITOLO(true);
+  config.pull = NRF_GPIO_PIN_PULLUP;
+  APP_ERROR_CHECK(nrfx_gpiote_in_init(SENSOR_INTERRUPT, &config, fifo_interrupt_handler));
+  nrfx_gpiote_in_event_enable(SENSOR_INTERRUPT, true);
+
+  // Accelerometer at 1.344 kHz, normal mode, x, y and z enabled
+  i2c_device_stage(&acc_device, CTRL_REG1_A, 0x97);
+  i2c_device_stage(&acc_device, CTRL_REG6_A, CTRL_REG6_H_LACTIVE);
+
+  // Stream mode keeps the newest 32 samples, watermark raises INT1
+  // Flushed in address order, so FIFO_EN is set before the FIFO mode
+  i2c_device_stage(&acc_device, CTRL_REG3_A, CTRL_REG3_I1_WTM);
+  i2c_device_stage(&acc_device, CTRL_REG5_A, CTRL_REG5_FIFO_EN);
+  i2c_device_stage(&acc_device, FIFO_CTRL_REG_A, FIFO_MODE_STREAM | watermark);
+  i2c_device_flush(&acc_device);
+
+  // Samples may already be past the watermark, so the edge would never come
+  fifo_watermark = true;
+}
+
+void lsm303agr_fifo_stop(void) {
+  nrfx_gpiote_in_event_disable(SENSOR_INTERRUPT);
+  nrfx_gpiote_in_uninit(SENSOR_INTERRUPT);
+
+  // Back to the 100 Hz single-sample configuration
+  i2c_device_stage(&acc_device, CTRL_REG1_A, 0x57);
+  i2c_device_stage(&acc_device, CTRL_REG3_A, 0x00);
+  i2c_device_stage(&acc_device, CTRL_REG5_A, 0x00);
+  i2c_device_stage(&acc_device, CTRL_REG6_A, 0x00);
+  i2c_device_stage(&acc_device, FIFO_CTRL_REG_A, FIFO_MODE_BYPASS);
+  i2c_device_flush(&acc_device);
+
+  fifo_callback = NULL;
+  fifo_watermark = false;
+}
+
+uint8_t lsm303agr_fifo_process(void) {
+  if (!fifo_watermark) {
+    return 0;
+  }
+  fifo_watermark = false;
+
+  // How many samples are waiting
+  uint8_t src = i2c_device_read_reg(&acc_device, FIFO_SRC_REG_A);
+  uint8_t count = src & FIFO_SRC_FSS_MASK;
+  if (src & FIFO_SRC_OVRN) {
+    // Full, FSS wraps at 32
+    count = LSM303AGR_FIFO_DEPTH;
+    fifo_overruns++;
+  }
+  if (count == 0) {
+    return 0;
+  }
+
+  // With the FIFO enabled the address rolls back from OUT_Z_H_A to OUT_X_L_A,
+  // so one read drains every sample
+  i2c_device_read_regs(&acc_device, OUT_X_L_A, fifo_buffer, count * SAMPLE_BYTES);
+
+  for (uint8_t i = 0; i < count; i++) {
+    const uint8_t* raw = &fifo_buffer[i * SAMPLE_BYTES];
+    fifo_measurements[i].x_axis = acc_to_g(&raw[0]);
+    fifo_measurements[i].y_axis = acc_to_g(&raw[2]);
+    fifo_measurements[i].z_axis = acc_to_g(&raw[4]);
+  }
+  fifo_samples += count;
+  fifo_drains++;
+
+  if (fifo_callback != NULL) {
+    fifo_callback(fifo_measurements, count);
+  }
+  return count;
+}
+
+void lsm303agr_print_stats(void) {
+  if (fifo_drains > 0) {
+    printf("LSM303AGR FIFO: %lu samples in %lu drains (%lu per drain), %lu overruns\n",
+        fifo_samples, fifo_drains, fifo_samples / fifo_drains, fifo_overruns);
+  }
+}
@@ -2,12 +2,19 @@
 
 #pragma once
 
-#include "nrf_twi_mngr.h"
+#include "i2c_bus.h"
 
 // Chip addresses for accelerometer and magnetometer
 static const uint8_t LSM303AGR_ACC_ADDRESS = 0x19;
 static const uint8_t LSM303AGR_MAG_ADDRESS = 0x1E;
 
+// Expected WHO_AM_I values
+#define LSM303AGR_ACC_WHO_AM_I 0x33
+#define LSM303AGR_MAG_WHO_AM_I 0x40
+
+// Accelerometer FIFO depth in samples
+#define LSM303AGR_FIFO_DEPTH 32
+
 // Measurement data type
 typedef struct {
   float x_axis;
@@ -15,6 +22,9 @@ typedef struct {
   float z_axis;
 } lsm303agr_measurement_t;
 
+// Called with each batch of samples drained from the FIFO, oldest first
+typedef void (*lsm303agr_fifo_callback_t)(const lsm303agr_measurement_t* samples, uint8_t count);
+
 // Register definitions for accelerometer
 typedef enum {
   STATUS_REG_AUX_A = 0x07,
@@ -86,8 +96,8 @@ typedef enum {
 
 // Initialize and configure the LSM303AGR accelerometer/magnetometer
 //
-// i2c - pointer to already initialized and enabled twim instance
-void lsm303agr_init(const nrf_twi_mngr_t* i2c);
+// bus - already initialized shared I2C bus the sensor is on
+void lsm303agr_init(i2c_bus_t* bus);
 
 // Read the internal temperature sensor
 //
@@ -104,3 +114,23 @@ lsm303agr_measurement_t lsm303agr_read_accelerometer(void);
 // Return measurements as floating point values in uT
 lsm303agr_measurement_t lsm303agr_read_magnetometer(void);
 
+
+// Switch the accelerometer to 1.344 kHz and buffer samples in its FIFO
+// The FIFO raises SENSOR_INTERRUPT once <watermark> samples are waiting
+//
+// watermark - samples per batch, 1 to 31
+// callback - receives each batch from lsm303agr_fifo_process()
+void lsm303agr_fifo_start(uint8_t watermark, lsm303agr_fifo_callback_t callback);
+
+// Disable the FIFO and return to 100 Hz single-sample reads
+void lsm303agr_fifo_stop(void);
+
+// Drain the FIFO in one burst if the watermark interrupt has fired
+// Call from the main loop, the callback runs here and not in interrupt context
+//
+// Return number of samples delivered
+uint8_t lsm303agr_fifo_process(void);
+
+// Print FIFO batch sizes
+// Transaction counts are kept by the bus, see i2c_bus_print_stats()
+void lsm303agr_print_stats(void);
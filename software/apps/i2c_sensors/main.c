@@ -10,11 +10,32 @@
 #include "nrf_delay.h"
 #include "nrf_twi_mngr.h"
 
+#include "i2c_bus.h"
 #include "microbit_v2.h"
 #include "lsm303agr.h"
 
+// Samples per FIFO batch
+#define FIFO_WATERMARK 24
+
+// Print a summary after this many samples, about one second at 1.344 kHz
+#define SAMPLES_PER_REPORT 1344
+
 // Global variables
 NRF_TWI_MNGR_DEF(twi_mngr_instance, 1, 0);
+static i2c_bus_t internal_bus;
+
+static uint32_t batch_samples = 0;
+static lsm303agr_measurement_t batch_sum = {0};
+
+// Accumulate each FIFO batch into a running average
+static void fifo_callback(const lsm303agr_measurement_t* samples, uint8_t count) {
+  for (uint8_t i = 0; i < count; i++) {
+    batch_sum.x_axis += samples[i].x_axis;
+    batch_sum.y_axis += samples[i].y_axis;
+    batch_sum.z_axis += samples[i].z_axis;
+  }
+  batch_samples += count;
+}
 
 int main(void) {
   printf("Board started!\n");
@@ -27,19 +48,41 @@ int main(void) {
   // connected to EDGE_P19 (a.k.a. I2C_QWIIC_SCL) and EDGE_P20 (a.k.a. I2C_QWIIC_SDA)
   i2c_config.scl = I2C_INTERNAL_SCL;
   i2c_config.sda = I2C_INTERNAL_SDA;
+  // Start slow, the bus is raised to the fastest clock the sensor passes at
   i2c_config.frequency = NRF_TWIM_FREQ_100K;
   i2c_config.interrupt_priority = 0;
-  nrf_twi_mngr_init(&twi_mngr_instance, &i2c_config);
+  i2c_bus_init(&internal_bus, &twi_mngr_instance, &i2c_config, "internal");
 
   // Initialize the LSM303AGR accelerometer/magnetometer sensor
-  lsm303agr_init(&twi_mngr_instance);
+  lsm303agr_init(&internal_bus);
+
+  // 400 kHz, if it passes, leaves headroom to drain the FIFO at 1.344 kHz
+  i2c_bus_select_frequency(&internal_bus);
 
-  //TODO: implement me!
+  // Single reads, one transaction each
+  printf("Temperature: %.1f C\n", lsm303agr_read_temperature());
+  lsm303agr_measurement_t mag = lsm303agr_read_magnetometer();
+  printf("Magnetometer: %.1f %.1f %.1f uT\n", mag.x_axis, mag.y_axis, mag.z_axis);
+
+  // Batched accelerometer samples from the FIFO
+  lsm303agr_fifo_start(FIFO_WATERMARK, fifo_callback);
 
   // Loop forever
   while (1) {
-    // Don't put any code in here. Instead put periodic code in a callback using a timer.
-    nrf_delay_ms(1000);
+    // Sleep until the watermark interrupt, then drain the FIFO
+    if (lsm303agr_fifo_process() == 0) {
+      __WFE();
+    }
+
+    if (batch_samples >= SAMPLES_PER_REPORT) {
+      printf("Accelerometer: %.3f %.3f %.3f g (mean of %lu)\n",
+          batch_sum.x_axis / batch_samples, batch_sum.y_axis / batch_samples,
+          batch_sum.z_axis / batch_samples, batch_samples);
+      lsm303agr_print_stats();
+      i2c_bus_print_stats(&internal_bus);
+      batch_samples = 0;
+      batch_sum = (lsm303agr_measurement_t){0};
+    }
   }
 }
 
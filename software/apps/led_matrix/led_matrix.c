@@ -1,27 +1,240 @@
 // LED Matrix Driver
 // Displays characters on the LED matrix
+//
+// Rows are scanned by the TIMER3 interrupt. Each row is shown once per bit of
+// brightness, for a time proportional to that bit's weight (binary code
+// modulation), so 16 brightness levels cost only 4 interrupts per row.
+// The interrupt reads from a front frame of precomputed port masks while the
+// application edits the back buffer. Frames are swapped between scans.
 
 #include <stdbool.h>
 #include <stdio.h>
 
+#include "nrf.h"
 #include "nrf_gpio.h"
-#include "app_timer.h"
 
+#include "cycle_counter.h"
 #include "led_matrix.h"
-#include "font.h"
 #include "microbit_v2.h"
 
+// Length of the shortest (least significant bit) slot in microseconds
+#define BIT_SLOT_US (1000000 / (LED_MATRIX_REFRESH_HZ * LED_MATRIX_SIZE * LED_MATRIX_MAX_BRIGHTNESS))
+
+// Scan interrupt should preempt app_timer callbacks to avoid visible flicker
+#define SCAN_IRQ_PRIORITY 2
+
+static const uint32_t row_pins[LED_MATRIX_SIZE] = {LED_ROW1, LED_ROW2, LED_ROW3, LED_ROW4, LED_ROW5};
+static const uint32_t col_pins[LED_MATRIX_SIZE] = {LED_COL1, LED_COL2, LED_COL3, LED_COL4, LED_COL5};
+
+// Columns to pull low (turn on) for each row and brightness bit, per port
+typedef struct {
+  uint32_t p0_on[LED_MATRIX_SIZE][LED_MATRIX_BRIGHTNESS_BITS];
+  uint32_t p1_on[LED_MATRIX_SIZE][LED_MATRIX_BRIGHTNESS_BITS];
+} led_frame_t;
+
+static led_frame_t frames[2];
+static led_frame_t* front = &frames[0];
+static led_frame_t* volatile pending = NULL;
+
+// Back buffer edited by the application
+static uint8_t pixels[LED_MATRIX_SIZE][LED_MATRIX_SIZE];
+
+// Port masks for all rows/columns, and for each single row/column
+static uint32_t rows_p0 = 0;
+static uint32_t rows_p1 = 0;
+static uint32_t cols_p0 = 0;
+static uint32_t cols_p1 = 0;
+static uint32_t row_p0[LED_MATRIX_SIZE];
+static uint32_t row_p1[LED_MATRIX_SIZE];
+static uint32_t col_p0[LED_MATRIX_SIZE];
+static uint32_t col_p1[LED_MATRIX_SIZE];
+
+// Scan position
+static uint8_t scan_row = 0;
+static uint8_t scan_bit = 0;
+
+// Statistics
+static volatile uint32_t frame_count = 0;
+static volatile uint32_t isr_cycles = 0;
+static uint32_t stats_start = 0;
+
+// Add a pin to the P0 or P1 mask it belongs to
+static void mask_add(uint32_t pin, uint32_t* p0, uint32_t* p1) {
+  if (pin < 32) {
+    *p0 |= 1UL << pin;
+  } else {
+    *p1 |= 1UL << (pin - 32);
+  }
+}
+
+void TIMER3_IRQHandler(void) {
+  uint32_t start = DWT->CYCCNT;
+  NRF_TIMER3->EVENTS_COMPARE[0] = 0;
+
+  // Advance to the next brightness bit, row, and frame
+  scan_bit++;
+  if (scan_bit == LED_MATRIX_BRIGHTNESS_BITS) {
+    scan_bit = 0;
+    scan_row++;
+    if (scan_row == LED_MATRIX_SIZE) {
+      scan_row = 0;
+      frame_count++;
+      if (pending != NULL) {
+        front = pending;
+        pending = NULL;
+      }
+    }
+  }
+
+  // Blank the rows, load the columns, then enable the new row
+  NRF_P0->OUTCLR = rows_p0;
+  NRF_P1->OUTCLR = rows_p1;
+  NRF_P0->OUTSET = cols_p0;
+  NRF_P1->OUTSET = cols_p1;
+  NRF_P0->OUTCLR = front->p0_on[scan_row][scan_bit];
+  NRF_P1->OUTCLR = front->p1_on[scan_row][scan_bit];
+  NRF_P0->OUTSET = row_p0[scan_row];
+  NRF_P1->OUTSET = row_p1[scan_row];
+
+  // Hold this bit for a time proportional to its weight
+  NRF_TIMER3->CC[0] += BIT_SLOT_US << scan_bit;
+
+  isr_cycles += DWT->CYCCNT - start;
+}
 
 void led_matrix_init(void) {
   // initialize row pins
+  for (int i = 0; i < LED_MATRIX_SIZE; i++) {
+    nrf_gpio_cfg_output(row_pins[i]);
+    nrf_gpio_pin_clear(row_pins[i]);
+    mask_add(row_pins[i], &rows_p0, &rows_p1);
+    row_p0[i] = 0;
+    row_p1[i] = 0;
+    mask_add(row_pins[i], &row_p0[i], &row_p1[i]);
+  }
 
   // initialize col pins
+  for (int i = 0; i < LED_MATRIX_SIZE; i++) {
+    nrf_gpio_cfg_output(col_pins[i]);
+    nrf_gpio_pin_set(col_pins[i]);
+    mask_add(col_pins[i], &cols_p0, &cols_p1);
+    col_p0[i] = 0;
+    col_p1[i] = 0;
+    mask_add(col_pins[i], &col_p0[i], &col_p1[i]);
+  }
+
+  // set default state for the LED display
+  memset(frames, 0, sizeof(frames));
+  led_matrix_clear();
 
-  // set default values for pins
+  // cycle counter for load measurements
+  cycle_counter_init();
+  stats_start = DWT->CYCCNT;
 
-  // initialize timer(s) (Step 2 and onwards)
+  // initialize scan timer: 1 MHz, 32-bit, interrupt on compare 0
+  NRF_TIMER3->MODE = TIMER_MODE_MODE_Timer;
+  NRF_TIMER3->BITMODE = TIMER_BITMODE_BITMODE_32Bit;
+  NRF_TIMER3->PRESCALER = 4;
+  NRF_TIMER3->TASKS_CLEAR = 1;
+  NRF_TIMER3->CC[0] = BIT_SLOT_US;
+  NRF_TIMER3->INTENSET = 1 << TIMER_INTENSET_COMPARE0_Pos;
 
-  // set default state for the LED display (Step 3 and onwards)
+  NVIC_ClearPendingIRQ(TIMER3_IRQn);
+  NVIC_SetPriority(TIMER3_IRQn, SCAN_IRQ_PRIORITY);
+  NVIC_EnableIRQ(TIMER3_IRQn);
+
+  NRF_TIMER3->TASKS_START = 1;
 }
 
+void led_matrix_stop(void) {
+  NRF_TIMER3->TASKS_STOP = 1;
+  NVIC_DisableIRQ(TIMER3_IRQn);
+  NRF_TIMER3->EVENTS_COMPARE[0] = 0;
+
+  // all rows off
+  NRF_P0->OUTCLR = rows_p0;
+  NRF_P1->OUTCLR = rows_p1;
+  pending = NULL;
+}
+
+void led_matrix_set_pixel(uint8_t row, uint8_t col, uint8_t brightness) {
+  if (row >= LED_MATRIX_SIZE || col >= LED_MATRIX_SIZE) {
+    return;
+  }
+  if (brightness > LED_MATRIX_MAX_BRIGHTNESS) {
+    brightness = LED_MATRIX_MAX_BRIGHTNESS;
+  }
+  pixels[row][col] = brightness;
+}
+
+void led_matrix_clear(void) {
+  memset(pixels, 0, sizeof(pixels));
+}
+
+// Wait for the previous swap and return the frame that isn't displayed
+static led_frame_t* back_frame(void) {
+  while (pending != NULL) {
+  }
+  return (front == &frames[0]) ? &frames[1] : &frames[0];
+}
 
+void led_matrix_show(void) {
+  // Compile the back buffer into port masks
+  led_frame_t* back = back_frame();
+  for (int row = 0; row < LED_MATRIX_SIZE; row++) {
+    for (int bit = 0; bit < LED_MATRIX_BRIGHTNESS_BITS; bit++) {
+      uint32_t p0 = 0;
+      uint32_t p1 = 0;
+      for (int col = 0; col < LED_MATRIX_SIZE; col++) {
+        if (pixels[row][col] & (1 << bit)) {
+          p0 |= col_p0[col];
+          p1 |= col_p1[col];
+        }
+      }
+      back->p0_on[row][bit] = p0;
+      back->p1_on[row][bit] = p1;
+    }
+  }
+
+  // Single pointer write, picked up at the start of the next frame
+  pending = back;
+}
+
+void led_matrix_show_columns(const uint8_t* columns, uint8_t brightness) {
+  led_frame_t* back = back_frame();
+  for (int row = 0; row < LED_MATRIX_SIZE; row++) {
+    uint32_t p0 = 0;
+    uint32_t p1 = 0;
+    for (int col = 0; col < LED_MATRIX_SIZE; col++) {
+      if (columns[col] & (1 << row)) {
+        p0 |= col_p0[col];
+        p1 |= col_p1[col];
+      }
+    }
+    for (int bit = 0; bit < LED_MATRIX_BRIGHTNESS_BITS; bit++) {
+      back->p0_on[row][bit] = (brightness & (1 << bit)) ? p0 : 0;
+      back->p1_on[row][bit] = (brightness & (1 << bit)) ? p1 : 0;
+    }
+  }
+  pending = back;
+}
+
+void led_matrix_print_stats(void) {
+  uint32_t now = DWT->CYCCNT;
+  uint32_t elapsed = now - stats_start;
+  uint32_t frames_shown = frame_count;
+  uint32_t busy = isr_cycles;
+
+  frame_count = 0;
+  isr_cycles = 0;
+  stats_start = now;
+
+  if (elapsed == 0) {
+    return;
+  }
+  uint32_t elapsed_ms = elapsed / (CYCLES_PER_US * 1000);
+  printf("LED matrix: %lu Hz refresh, scan CPU load %lu.%02lu%%\n",
+      elapsed_ms ? frames_shown * 1000 / elapsed_ms : 0,
+      (uint32_t)((uint64_t)busy * 100 / elapsed),
+      (uint32_t)((uint64_t)busy * 10000 / elapsed % 100));
+}
@@ -1,11 +1,40 @@
 #pragma once
 
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <string.h>
 
+// Matrix geometry and timing
+#define LED_MATRIX_SIZE 5
+#define LED_MATRIX_REFRESH_HZ 120
+#define LED_MATRIX_BRIGHTNESS_BITS 4
+#define LED_MATRIX_MAX_BRIGHTNESS ((1 << LED_MATRIX_BRIGHTNESS_BITS) - 1)
+
 // Initialize the LED matrix display
+// Rows are scanned from TIMER3 interrupts, so no other code may use TIMER3
 void led_matrix_init(void);
 
-// You may need to add more functions here
+// Stop scanning and turn every LED off, releasing TIMER3
+// Call led_matrix_init() to start again
+void led_matrix_stop(void);
+
+// Set one pixel in the back buffer
+// brightness ranges from 0 (off) to LED_MATRIX_MAX_BRIGHTNESS
+// Nothing changes on the display until led_matrix_show() is called
+void led_matrix_set_pixel(uint8_t row, uint8_t col, uint8_t brightness);
+
+// Turn off every pixel in the back buffer
+void led_matrix_clear(void);
+
+// Swap the back buffer to the display at the start of the next frame
+// Blocks for at most one frame if the previous swap has not happened yet
+void led_matrix_show(void);
+
+// Load five column bitmaps straight into the back frame and swap it in
+// Bit N of each column lights row N. All lit pixels share one brightness
+// Faster than setting 25 pixels, intended for scrolling text
+void led_matrix_show_columns(const uint8_t* columns, uint8_t brightness);
 
+// Print refresh rate and scan CPU load since the last call
+void led_matrix_print_stats(void);
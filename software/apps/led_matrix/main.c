@@ -9,6 +9,7 @@
 #include "nrf_delay.h"
 
 #include "led_matrix.h"
+#include "marquee.h"
 #include "microbit_v2.h"
 
 int main(void) {
@@ -17,11 +18,29 @@ int main(void) {
   // initialize LED matrix driver
   led_matrix_init();
 
-  // call other functions here
+  // show a diagonal brightness gradient
+  for (int row = 0; row < LED_MATRIX_SIZE; row++) {
+    for (int col = 0; col < LED_MATRIX_SIZE; col++) {
+      led_matrix_set_pixel(row, col, (row + col) * LED_MATRIX_MAX_BRIGHTNESS / (2 * (LED_MATRIX_SIZE - 1)));
+    }
+  }
+  led_matrix_show();
+  nrf_delay_ms(1000);
+
+  // scroll a message, one column every 100 ms
+  marquee_set_text("Hello, World!", LED_MATRIX_MAX_BRIGHTNESS);
 
   // loop forever
+  uint32_t steps = 0;
   while (1) {
-    nrf_delay_ms(1000);
+    nrf_delay_ms(100);
+    marquee_step();
+
+    steps++;
+    if (steps % 50 == 0) {
+      led_matrix_print_stats();
+      marquee_print_stats();
+    }
   }
 }
 
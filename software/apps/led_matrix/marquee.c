@@ -0,0 +1,137 @@
+// Scrolling text on the LED matrix
+//
+// Column bitmaps use bit N for row N, matching led_matrix_show_columns().
+// The strip starts and ends with a blank screen width so the text scrolls in
+// from the right and fully off to the left.
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "nrf.h"
+
+#include "cycle_counter.h"
+#include "font.h"
+#include "led_matrix.h"
+#include "marquee.h"
+
+#define GLYPH_ROWS 5
+#define GLYPH_COLUMNS 5
+#define SPACE_COLUMNS 2
+
+static uint8_t strip[MARQUEE_MAX_COLUMNS];
+static uint16_t strip_length = 0;
+static uint16_t strip_chars = 0;
+static uint16_t window = 0;
+static uint8_t text_brightness = LED_MATRIX_MAX_BRIGHTNESS;
+
+// Render statistics
+static uint32_t render_cycles = 0;
+static uint32_t step_cycles_total = 0;
+static uint32_t step_cycles_max = 0;
+static uint32_t steps = 0;
+
+// Append blank columns, returns false if the strip is full
+static bool append_blank(uint16_t count) {
+  if (strip_length + count > MARQUEE_MAX_COLUMNS) {
+    return false;
+  }
+  for (uint16_t i = 0; i < count; i++) {
+    strip[strip_length++] = 0;
+  }
+  return true;
+}
+
+// Append one glyph trimmed to its used columns plus a spacer column
+static bool append_glyph(char c) {
+  const uint8_t* glyph = font[(uint8_t)c & 0x7F];
+
+  // Transpose rows into columns
+  uint8_t columns[GLYPH_COLUMNS] = {0};
+  for (int row = 0; row < GLYPH_ROWS; row++) {
+    for (int col = 0; col < GLYPH_COLUMNS; col++) {
+      if (glyph[row] & (1 << col)) {
+        columns[col] |= 1 << row;
+      }
+    }
+  }
+
+  // Proportional width, blank glyphs become a narrow space
+  int width = GLYPH_COLUMNS;
+  while (width > 0 && columns[width - 1] == 0) {
+    width--;
+  }
+
+  // Leave room for the blank screen width at the end
+  int needed = (width == 0) ? SPACE_COLUMNS : width + 1;
+  if (strip_length + needed > MARQUEE_MAX_COLUMNS - LED_MATRIX_SIZE) {
+    return false;
+  }
+  if (width == 0) {
+    return append_blank(SPACE_COLUMNS);
+  }
+  for (int col = 0; col < width; col++) {
+    strip[strip_length++] = columns[col];
+  }
+  strip[strip_length++] = 0;
+  return true;
+}
+
+uint16_t marquee_set_text(const char* text, uint8_t brightness) {
+  uint32_t start = DWT->CYCCNT;
+
+  strip_length = 0;
+  strip_chars = 0;
+  window = 0;
+  text_brightness = brightness;
+
+  append_blank(LED_MATRIX_SIZE);
+  while (*text != '\0' && append_glyph(*text)) {
+    text++;
+    strip_chars++;
+  }
+  append_blank(LED_MATRIX_SIZE);
+
+  render_cycles = DWT->CYCCNT - start;
+  return strip_length;
+}
+
+void marquee_step(void) {
+  if (strip_length == 0) {
+    return;
+  }
+
+  uint32_t start = DWT->CYCCNT;
+
+  led_matrix_show_columns(&strip[window], text_brightness);
+  window++;
+  if (window + LED_MATRIX_SIZE > strip_length) {
+    window = 0;
+  }
+
+  uint32_t cycles = DWT->CYCCNT - start;
+  step_cycles_total += cycles;
+  if (cycles > step_cycles_max) {
+    step_cycles_max = cycles;
+  }
+  steps++;
+}
+
+void marquee_clear(void) {
+  static const uint8_t blank[LED_MATRIX_SIZE] = {0};
+
+  strip_length = 0;
+  strip_chars = 0;
+  window = 0;
+  led_matrix_show_columns(blank, 0);
+}
+
+void marquee_print_stats(void) {
+  printf("Marquee: %u chars in %u columns (%u.%02u bytes/char), pre-render %lu us\n",
+      strip_chars, strip_length,
+      strip_chars ? strip_length / strip_chars : 0,
+      strip_chars ? strip_length * 100 / strip_chars % 100 : 0,
+      render_cycles / CYCLES_PER_US);
+  printf("  step render: avg %lu cycles, max %lu cycles over %lu steps\n",
+      steps ? step_cycles_total / steps : 0, step_cycles_max, steps);
+}
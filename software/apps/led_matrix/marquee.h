@@ -0,0 +1,27 @@
+#pragma once
+
+#include <stdint.h>
+
+// Scrolling text on the LED matrix
+//
+// The text is rendered once into a strip of column bitmaps. Each scroll step
+// only moves a five-column window along the strip, so no glyphs are looked up
+// while scrolling.
+
+// Longest strip in columns (about 40 characters)
+#define MARQUEE_MAX_COLUMNS 256
+
+// Render <text> into the column strip and rewind to its start
+// Text that does not fit is truncated
+// Returns the number of columns in the strip
+uint16_t marquee_set_text(const char* text, uint8_t brightness);
+
+// Advance the window by one column and display it
+// Wraps around to the start once the text has scrolled off
+void marquee_step(void);
+
+// Blank the matrix and forget the current text
+void marquee_clear(void);
+
+// Print strip memory per character and per-step render time
+void marquee_print_stats(void);
@@ -7,6 +7,7 @@
 #include <stdint.h>
 #include <stdio.h>
 
+#include "app_scheduler.h"
 #include "nrf.h"
 #include "nrf_delay.h"
 #include "nrfx_pwm.h"
@@ -34,6 +35,11 @@ static const nrfx_pwm_t PWM_INST = NRFX_PWM_INSTANCE(0);
 uint16_t samples[BUFFER_SIZE] = {0}; // stores ADC samples and PWM duty cycle values
 volatile bool samples_complete = false; // flag for blocking while sampling
 
+// Scheduler configuration
+// Events carry no data, they only move work out of interrupt context
+#define SCHED_MAX_EVENT_DATA_SIZE 0
+#define SCHED_QUEUE_SIZE 4
+
 
 void TIMER4_IRQHandler(void) {
   // Needs to be quick! No printf here!!
@@ -48,6 +54,30 @@ void TIMER4_IRQHandler(void) {
   nrfx_saadc_sample();
 }
 
+// Runs from the main loop via the scheduler, not in the SAADC interrupt
+static void process_samples(void* _unused_data, uint16_t _unused_size) {
+  // adjust the data here before returning
+  // Warning: don't try to print all the ADC samples without adding an nRF
+  //  delay every few samples. It really messes up the system. Something
+  //  definitely breaks and it needs to be re-programmed to start again
+
+  // determine the average of the samples
+  uint32_t average = 0;
+  for (int i=0; i<BUFFER_SIZE; i++) {
+    average += (uint16_t)samples[i];
+  }
+  average = average/BUFFER_SIZE;
+
+  // scale each sample based on the average value and recenter around 50%
+  for (int i=0; i<BUFFER_SIZE; i++) {
+    // scaling determined experimentally
+    samples[i] = (((int32_t)samples[i] - average) * 10) + (ADC_MAX_COUNTS/2);
+  }
+
+  // Signal completion
+  samples_complete = true;
+}
+
 static void saadc_event_callback(nrfx_saadc_evt_t const* event) {
   if (event->type == NRFX_SAADC_EVT_DONE) {
 
@@ -55,28 +85,10 @@ static void saadc_event_callback(nrfx_saadc_evt_t const* event) {
     NRF_TIMER4->CC[0] = 0;
     NRF_TIMER4->TASKS_STOP = 1;
 
-    printf("ADC sampling complete (%d samples)\n", event->data.done.size);
-
-    // adjust the data here before returning
-    // Warning: don't try to print all the ADC samples without adding an nRF
-    //  delay every few samples. It really messes up the system. Something
-    //  definitely breaks and it needs to be re-programmed to start again
-
-    // determine the average of the samples
-    uint32_t average = 0;
-    for (int i=0; i<BUFFER_SIZE; i++) {
-      average += (uint16_t)samples[i];
-    }
-    average = average/BUFFER_SIZE;
-
-    // scale each sample based on the average value and recenter around 50%
-    for (int i=0; i<BUFFER_SIZE; i++) {
-      // scaling determined experimentally
-      samples[i] = (((int32_t)samples[i] - average) * 10) + (ADC_MAX_COUNTS/2);
-    }
-
-    // Signal completion
-    samples_complete = true;
+    // Looping over every sample takes far too long for an interrupt
+    // Hand it to the main loop instead
+    ret_code_t error_code = app_sched_event_put(NULL, 0, process_samples);
+    APP_ERROR_CHECK(error_code);
 
   } else {
     printf("Got some other SAADC event?!\n");
@@ -175,6 +187,9 @@ static void play_audio_samples_looped(void) {
 int main(void) {
   printf("Board started!\n");
 
+  // Initialize the scheduler
+  APP_SCHED_INIT(SCHED_MAX_EVENT_DATA_SIZE, SCHED_QUEUE_SIZE);
+
   // Initialize GPIO
   gpio_init();
 
@@ -190,10 +205,12 @@ int main(void) {
   // Sample audio from the microphone
   sample_microphone();
 
-  // Delay until sampling the ADC is complete
+  // Sleep until the SAADC interrupt schedules sample processing, then run it
   while (!samples_complete) {
-    nrf_delay_ms(100);
+    __WFE();
+    app_sched_execute();
   }
+  printf("ADC sampling complete (%d samples)\n", BUFFER_SIZE);
 
   // Play audio over the speaker
   play_audio_samples_looped();
@@ -0,0 +1,143 @@
+// Boot profiler and init graph
+//
+// Steps are picked in table order, so list the ones on the longest chain
+// first. The critical path is rebuilt afterwards by walking back from the
+// last step to finish, each time to the dependency that finished latest.
+
+#include "boot_profile.h"
+#include <stdio.h>
+#include <string.h>
+#include "nrf.h"
+#include "cycle_counter.h"
+
+#define NO_STEP 0xFF
+
+typedef struct
+{
+    uint32_t ready;   // Dependencies met
+    uint32_t started; // First slice
+    uint32_t ended;   // Last slice returned BOOT_STEP_DONE
+    uint32_t busy;    // Cycles spent inside slices
+    uint32_t slices;
+} step_times_t;
+
+static uint32_t boot_start = 0;
+static const boot_step_t *boot_steps = NULL;
+static uint8_t boot_count = 0;
+static step_times_t times[BOOT_MAX_STEPS];
+static uint32_t boot_end = 0;
+
+void boot_profile_start(void)
+{
+    cycle_counter_init();
+    boot_start = DWT->CYCCNT;
+}
+
+static uint32_t since_boot_us(uint32_t cycles)
+{
+    return (cycles - boot_start) / CYCLES_PER_US;
+}
+
+void boot_run(const boot_step_t *steps, uint8_t count)
+{
+    if (count > BOOT_MAX_STEPS)
+    {
+        count = BOOT_MAX_STEPS;
+    }
+    boot_steps = steps;
+    boot_count = count;
+    memset(times, 0, sizeof(times));
+
+    uint32_t all = (1UL << count) - 1;
+    uint32_t done = 0;
+    uint32_t started = 0;
+    uint32_t wake[BOOT_MAX_STEPS] = {0};
+
+    while (done != all)
+    {
+        for (uint8_t i = 0; i < count; i++)
+        {
+            uint32_t bit = BOOT_DEPENDS(i);
+            if ((done & bit) || (steps[i].depends_on & done) != steps[i].depends_on)
+            {
+                continue;
+            }
+
+            uint32_t now = DWT->CYCCNT;
+            if (!(started & bit))
+            {
+                started |= bit;
+                times[i].ready = now;
+                times[i].started = now;
+                wake[i] = now;
+            }
+            if ((int32_t)(now - wake[i]) < 0)
+            {
+                continue;
+            }
+
+            uint32_t wait_us = steps[i].run();
+            uint32_t after = DWT->CYCCNT;
+            times[i].busy += after - now;
+            times[i].slices++;
+
+            if (wait_us == BOOT_STEP_DONE)
+            {
+                done |= bit;
+                times[i].ended = after;
+            }
+            else
+            {
+                wake[i] = after + wait_us * CYCLES_PER_US;
+            }
+        }
+    }
+    boot_end = DWT->CYCCNT;
+}
+
+void boot_profile_print(void)
+{
+    printf("Boot profile (us from start of main):\n");
+    printf("  %-14s %9s %9s %9s %6s\n", "step", "start", "end", "busy", "slices");
+    for (uint8_t i = 0; i < boot_count; i++)
+    {
+        printf("  %-14s %9lu %9lu %9lu %6lu\n", boot_steps[i].name,
+               since_boot_us(times[i].started), since_boot_us(times[i].ended),
+               times[i].busy / CYCLES_PER_US, times[i].slices);
+    }
+
+    // Walk back from the last step to finish
+    uint8_t path[BOOT_MAX_STEPS];
+    uint8_t length = 0;
+    uint8_t step = NO_STEP;
+    for (uint8_t i = 0; i < boot_count; i++)
+    {
+        if (step == NO_STEP || (int32_t)(times[i].ended - times[step].ended) > 0)
+        {
+            step = i;
+        }
+    }
+    while (step != NO_STEP && length < BOOT_MAX_STEPS)
+    {
+        path[length++] = step;
+        uint8_t previous = NO_STEP;
+        for (uint8_t i = 0; i < boot_count; i++)
+        {
+            if ((boot_steps[step].depends_on & BOOT_DEPENDS(i)) &&
+                (previous == NO_STEP || (int32_t)(times[i].ended - times[previous].ended) > 0))
+            {
+                previous = i;
+            }
+        }
+        step = previous;
+    }
+
+    printf("Critical path (%lu us):", since_boot_us(boot_end));
+    while (length > 0)
+    {
+        length--;
+        uint8_t i = path[length];
+        printf(" %s %lu us%s", boot_steps[i].name, (times[i].ended - times[i].ready) / CYCLES_PER_US,
+               length > 0 ? " ->" : "\n");
+    }
+}
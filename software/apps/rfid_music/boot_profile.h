@@ -0,0 +1,40 @@
+#ifndef BOOT_PROFILE_H
+#define BOOT_PROFILE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Boot profiler and init graph
+//
+// Startup is described as a table of steps with dependencies. Each step runs
+// in slices: it returns how long to wait before it should be called again, or
+// BOOT_STEP_DONE. While one step waits (a display reset delay, say), any other
+// step whose dependencies are met gets to run. Every step is timestamped with
+// the DWT cycle counter from boot_profile_start().
+
+#define BOOT_MAX_STEPS 16
+#define BOOT_STEP_DONE 0
+
+// Run one slice of a step
+// Returns BOOT_STEP_DONE, or microseconds until the next slice
+typedef uint32_t (*boot_step_fn_t)(void);
+
+typedef struct
+{
+    const char *name;
+    uint32_t depends_on; // BOOT_DEPENDS(i) of every step that must finish first
+    boot_step_fn_t run;
+} boot_step_t;
+
+#define BOOT_DEPENDS(step) (1UL << (step))
+
+// Start the boot clock. Call first thing in main()
+void boot_profile_start(void);
+
+// Run <steps> until all of them are done, overlapping their waits
+void boot_run(const boot_step_t *steps, uint8_t count);
+
+// Print when each step ran and the chain of steps that set the boot time
+void boot_profile_print(void);
+
+#endif
@@ -0,0 +1,201 @@
+// Boot-time discovery of the devices on the Qwiic bus
+//
+// The cache lives in a .noinit section, which the C runtime leaves alone, so
+// it survives soft resets, watchdog resets and the reset pin. A power-on reset
+// leaves RESETREAS clear and RAM undefined, so the cache is only trusted when
+// RESETREAS shows some other reset and the magic and checksum match.
+
+#include "bus_discovery.h"
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include "nrf.h"
+#include "cycle_counter.h"
+
+#define CACHE_MAGIC 0x44495343 // "DISC"
+
+typedef struct
+{
+    uint8_t address;
+    const char *name;
+} known_device_t;
+
+// Every device RetroScan knows how to use. Nothing else is probed
+static const known_device_t known_devices[DISCOVERY_DEVICE_COUNT] = {
+    [DISCOVERY_RFID] = {0x7D, "Qwiic RFID"},
+    [DISCOVERY_RFID_ALT] = {0x7C, "Qwiic RFID (alt)"},
+    [DISCOVERY_RFID_3] = {0x7B, "Qwiic RFID (3rd)"},
+};
+
+typedef struct
+{
+    uint32_t magic;
+    uint32_t table_hash; // Detects a firmware with a different table
+    uint32_t found;      // Bit per discovery_device_t
+    uint32_t frequency;  // 0 until bus_discovery_save_frequency()
+    uint32_t checksum;
+} discovery_cache_t;
+
+static discovery_cache_t cache __attribute__((section(".noinit")));
+
+// Probe jobs in flight
+static i2c_bus_job_t jobs[DISCOVERY_DEVICE_COUNT];
+static i2c_device_t scratch[DISCOVERY_DEVICE_COUNT];
+static uint8_t probe_data[DISCOVERY_DEVICE_COUNT];
+static volatile uint32_t found = 0;
+static volatile uint8_t pending = 0;
+
+static i2c_bus_t *discovery_bus = NULL;
+static bool from_cache = false;
+static uint32_t start_cycles = 0;
+static volatile uint32_t elapsed_cycles = 0;
+
+// FNV-1a over a block of memory
+static uint32_t hash_bytes(uint32_t hash, const void *data, size_t length)
+{
+    const uint8_t *bytes = data;
+    for (size_t i = 0; i < length; i++)
+    {
+        hash ^= bytes[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static uint32_t table_hash(void)
+{
+    uint32_t hash = 2166136261u;
+    for (int i = 0; i < DISCOVERY_DEVICE_COUNT; i++)
+    {
+        hash = hash_bytes(hash, &known_devices[i].address, 1);
+    }
+    return hash;
+}
+
+static uint32_t cache_checksum(void)
+{
+    return hash_bytes(2166136261u, &cache, offsetof(discovery_cache_t, checksum));
+}
+
+static bool cache_valid(void)
+{
+    // Power-on reset, RAM contents are undefined
+    if (NRF_POWER->RESETREAS == 0)
+    {
+        return false;
+    }
+    return cache.magic == CACHE_MAGIC && cache.table_hash == table_hash() && cache.checksum == cache_checksum();
+}
+
+static void cache_store(void)
+{
+    cache.magic = CACHE_MAGIC;
+    cache.table_hash = table_hash();
+    cache.found = found;
+    cache.checksum = cache_checksum();
+}
+
+// Runs from the TWI interrupt as each probe completes
+static void probe_done(ret_code_t result, void *context)
+{
+    discovery_device_t device = (discovery_device_t)(uintptr_t)context;
+    if (result == NRF_SUCCESS)
+    {
+        found |= 1UL << device;
+    }
+    pending--;
+    if (pending == 0)
+    {
+        elapsed_cycles = DWT->CYCCNT - start_cycles;
+    }
+}
+
+void bus_discovery_start(i2c_bus_t *bus)
+{
+    discovery_bus = bus;
+    start_cycles = DWT->CYCCNT;
+
+    if (cache_valid())
+    {
+        found = cache.found;
+        from_cache = true;
+        elapsed_cycles = DWT->CYCCNT - start_cycles;
+        return;
+    }
+
+    // Not cached, queue one probe per known address
+    memset(&cache, 0, sizeof(cache));
+    found = 0;
+    pending = DISCOVERY_DEVICE_COUNT;
+    for (int i = 0; i < DISCOVERY_DEVICE_COUNT; i++)
+    {
+        i2c_job_probe(&jobs[i], &scratch[i], bus, known_devices[i].address, &probe_data[i]);
+        i2c_bus_submit(&jobs[i], I2C_BUS_PRIORITY_LOW, probe_done, (void *)(uintptr_t)i);
+    }
+}
+
+bool bus_discovery_done(void)
+{
+    if (from_cache || pending == 0)
+    {
+        return true;
+    }
+    i2c_bus_poll(discovery_bus);
+    return false;
+}
+
+bool bus_discovery_finish(void)
+{
+    if (!from_cache)
+    {
+        // Normally done already, but a stuck bus needs polling to time out
+        while (pending > 0)
+        {
+            i2c_bus_poll(discovery_bus);
+        }
+
+        // An empty bus is not cached, so a reader plugged in later is found
+        // after a reset
+        if (found != 0)
+        {
+            cache_store();
+        }
+    }
+    return from_cache;
+}
+
+bool bus_discovery_found(discovery_device_t device)
+{
+    return (found >> device) & 1;
+}
+
+uint8_t bus_discovery_address(discovery_device_t device)
+{
+    return known_devices[device].address;
+}
+
+const char *bus_discovery_name(discovery_device_t device)
+{
+    return known_devices[device].name;
+}
+
+nrf_drv_twi_frequency_t bus_discovery_cached_frequency(void)
+{
+    return from_cache ? (nrf_drv_twi_frequency_t)cache.frequency : 0;
+}
+
+void bus_discovery_save_frequency(nrf_drv_twi_frequency_t frequency)
+{
+    cache.frequency = frequency;
+    cache.checksum = cache_checksum();
+}
+
+void bus_discovery_print(void)
+{
+    printf("Bus discovery (%s): %lu us\n", from_cache ? "cached" : "probed", elapsed_cycles / CYCLES_PER_US);
+    for (int i = 0; i < DISCOVERY_DEVICE_COUNT; i++)
+    {
+        printf("  %-18s 0x%02X %s\n", known_devices[i].name, known_devices[i].address,
+               bus_discovery_found(i) ? "found" : "absent");
+    }
+}
@@ -0,0 +1,56 @@
+#ifndef BUS_DISCOVERY_H
+#define BUS_DISCOVERY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "i2c_bus.h"
+
+// Boot-time discovery of the devices on the Qwiic bus
+//
+// Only the addresses in a compile-time table of known devices are probed, and
+// the probes run from the TWI interrupt so the CPU is free to initialize the
+// display meanwhile. The result, along with the bus clock chosen for it, is
+// kept in RAM that survives a reset, so warm boots skip probing altogether.
+
+typedef enum
+{
+    DISCOVERY_RFID,     // SparkFun Qwiic RFID, default address
+    DISCOVERY_RFID_ALT, // Same reader with its address jumper closed
+    DISCOVERY_RFID_3,   // Third reader, address changed in its firmware
+    DISCOVERY_DEVICE_COUNT,
+} discovery_device_t;
+
+// RFID readers are the entries from DISCOVERY_RFID to here
+#define DISCOVERY_RFID_LAST DISCOVERY_RFID_3
+
+// Start probing the known addresses on <bus>, or load the cached topology
+// Returns immediately, call bus_discovery_finish() before using the results
+void bus_discovery_start(i2c_bus_t *bus);
+
+// Whether every probe has completed, without waiting
+// Keeps a stuck bus moving towards its timeout
+bool bus_discovery_done(void);
+
+// Wait for the probes to finish, then cache the result if anything answered
+// Returns true if the result came from the cache
+bool bus_discovery_finish(void);
+
+// Whether <device> answered
+bool bus_discovery_found(discovery_device_t device);
+
+// Address of <device> from the known-device table
+uint8_t bus_discovery_address(discovery_device_t device);
+
+// Name of <device> from the known-device table
+const char *bus_discovery_name(discovery_device_t device);
+
+// Bus clock stored with a cached result, or 0 if the clock still needs probing
+nrf_drv_twi_frequency_t bus_discovery_cached_frequency(void);
+
+// Store the bus clock chosen for this topology so warm boots can reuse it
+void bus_discovery_save_frequency(nrf_drv_twi_frequency_t frequency);
+
+// Print what was found and how long discovery took
+void bus_discovery_print(void);
+
+#endif
@@ -0,0 +1,32 @@
+#include "catalog.h"
+#include <string.h>
+
+static const catalog_entry_t catalog[] = {
+    {"3A006C84D200", MEDIA_VINYL, "Travis Scott", "Utopia", "Meltdown", "Thank God", "Fein", "Rap", "2023", "5", {0xC5, 0xFB, 0xFF}},
+    {"3A006C762F0F", MEDIA_VHS, "Sonnenfeld", "Men in Black", "Will Smith", "Tommy Lee Jones", "Rip Torn", "Sci-Fi", "1997", "10", {0x00, 0x00, 0xFF}},
+    {"00000015C9DC", MEDIA_VINYL, "Radiohead", "In Rainbows", "All I Need", "Weird Fishes", "Videotape Garden", "Rock", "2007", "5", {0xF7, 0xEE, 0x49}},
+    // Add more entries as needed
+};
+static const size_t entry_count = sizeof(catalog) / sizeof(catalog[0]);
+
+const catalog_entry_t *catalog_find(const char *tag_id)
+{
+    for (size_t i = 0; i < entry_count; i++)
+    {
+        if (strcmp(catalog[i].tag_id, tag_id) == 0)
+        {
+            return &catalog[i];
+        }
+    }
+    return NULL;
+}
+
+uint8_t catalog_count(void)
+{
+    return entry_count;
+}
+
+const catalog_entry_t *catalog_at(uint8_t index)
+{
+    return index < entry_count ? &catalog[index] : NULL;
+}
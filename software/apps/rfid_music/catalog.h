@@ -0,0 +1,40 @@
+#ifndef CATALOG_H
+#define CATALOG_H
+
+#include <stdint.h>
+
+// Items RetroScan knows, keyed by RFID tag
+
+typedef enum
+{
+    MEDIA_VINYL,
+    MEDIA_VHS,
+    MEDIA_CASSETTE,
+    MEDIA_CD,
+    MEDIA_CARTRIDGE,
+    MEDIA_TYPE_COUNT,
+} media_type_t;
+
+typedef struct
+{
+    const char *tag_id; // RFID tag ID
+    media_type_t media;
+    const char *person; // Director or Artist
+    const char *title;  // Title
+    const char *field1; // Field 1 (e.g., song/actor)
+    const char *field2; // Field 2
+    const char *field3; // Field 3
+    const char *genre;  // Genre
+    const char *year;   // Year
+    const char *weight; // Weight
+    uint8_t accent[3];  // Shown briefly before the info screen
+} catalog_entry_t;
+
+// Entry for <tag_id>, or NULL if the tag is unknown
+const catalog_entry_t *catalog_find(const char *tag_id);
+
+// Entries in catalog order, for browsing without a tag
+uint8_t catalog_count(void);
+const catalog_entry_t *catalog_at(uint8_t index);
+
+#endif
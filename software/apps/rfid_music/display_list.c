@@ -0,0 +1,233 @@
+// Captured screens, replayed without redoing their layout
+//
+// A capture records into the slot it will occupy, so a render that misses
+// costs no copying afterwards. A list that runs out of ops or text is
+// dropped and the screen simply isn't cached.
+
+#include "display_list.h"
+#include <stdio.h>
+#include <string.h>
+#include "font_data.h"
+#include "ili9341.h"
+#include "nrf.h"
+#include "cycle_counter.h"
+
+static display_list_t cache[DISPLAY_LIST_CACHE_SIZE];
+static display_list_t *capturing = NULL;
+static bool overflowed = false;
+static uint32_t use_counter = 0;
+
+// Statistics
+static uint32_t hits = 0;
+static uint32_t misses = 0;
+static uint32_t evictions = 0;
+static uint32_t overflows = 0;
+static uint64_t replay_cycles = 0;
+static uint64_t capture_cycles = 0;
+static uint32_t captures = 0;
+
+static display_op_t *next_op(void)
+{
+    if (capturing->op_count == DISPLAY_LIST_MAX_OPS)
+    {
+        overflowed = true;
+        return NULL;
+    }
+    display_op_t *op = &capturing->ops[capturing->op_count++];
+    memset(op, 0, sizeof(*op));
+    return op;
+}
+
+static void record_fill(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint8_t r, uint8_t g, uint8_t b)
+{
+    display_op_t *op = next_op();
+    if (op == NULL)
+    {
+        return;
+    }
+    op->type = DISPLAY_OP_FILL;
+    op->x = x;
+    op->y = y;
+    op->w = w;
+    op->h = h;
+    op->r = r;
+    op->g = g;
+    op->b = b;
+}
+
+static uint8_t font_index(const tft_font_t *font)
+{
+    for (uint8_t i = 0; i < TFT_FONT_COUNT; i++)
+    {
+        if (tft_fonts[i] == font)
+        {
+            return i;
+        }
+    }
+    return 0;
+}
+
+static void record_glyph(uint16_t x, uint16_t y, uint16_t width, char c, const tft_font_t *font, uint8_t scale,
+                         uint8_t r, uint8_t g, uint8_t b)
+{
+    if (capturing->text_length == DISPLAY_LIST_MAX_TEXT)
+    {
+        overflowed = true;
+        return;
+    }
+
+    // Carry on the previous run if this glyph sits right after it
+    uint8_t font_id = font_index(font);
+    display_op_t *op = capturing->op_count ? &capturing->ops[capturing->op_count - 1] : NULL;
+    bool extends = op != NULL && op->type == DISPLAY_OP_GLYPHS && op->y == y && op->x + op->w == x &&
+                   op->font == font_id && op->scale == scale && op->count < UINT8_MAX &&
+                   op->r == r && op->g == g && op->b == b;
+    if (!extends)
+    {
+        op = next_op();
+        if (op == NULL)
+        {
+            return;
+        }
+        op->type = DISPLAY_OP_GLYPHS;
+        op->font = font_id;
+        op->scale = scale;
+        op->x = x;
+        op->y = y;
+        op->text = capturing->text_length;
+        op->r = r;
+        op->g = g;
+        op->b = b;
+    }
+    capturing->text[capturing->text_length++] = c;
+    op->count++;
+    op->w += width;
+}
+
+static const ili9341_recorder_t recorder = {
+    .fill = record_fill,
+    .glyph = record_glyph,
+};
+
+static display_list_t *find(const void *key)
+{
+    for (int i = 0; i < DISPLAY_LIST_CACHE_SIZE; i++)
+    {
+        if (cache[i].valid && cache[i].key == key)
+        {
+            return &cache[i];
+        }
+    }
+    return NULL;
+}
+
+bool display_list_replay(const void *key)
+{
+    display_list_t *list = find(key);
+    if (list == NULL)
+    {
+        misses++;
+        return false;
+    }
+
+    uint32_t start = DWT->CYCCNT;
+    for (uint16_t i = 0; i < list->op_count; i++)
+    {
+        const display_op_t *op = &list->ops[i];
+        if (op->type == DISPLAY_OP_FILL)
+        {
+            draw_rectangle(op->x, op->y, op->w, op->h, op->r, op->g, op->b);
+        }
+        else
+        {
+            ili9341_draw_run(op->x, op->y, &list->text[op->text], op->count, tft_fonts[op->font], op->scale,
+                             op->r, op->g, op->b);
+        }
+    }
+    replay_cycles += DWT->CYCCNT - start;
+
+    list->last_used = ++use_counter;
+    hits++;
+    return true;
+}
+
+void display_list_capture_begin(const void *key)
+{
+    // An empty slot, or else the least recently used one
+    display_list_t *slot = &cache[0];
+    for (int i = 0; i < DISPLAY_LIST_CACHE_SIZE; i++)
+    {
+        if (!cache[i].valid)
+        {
+            slot = &cache[i];
+            break;
+        }
+        if (cache[i].last_used < slot->last_used)
+        {
+            slot = &cache[i];
+        }
+    }
+    if (slot->valid)
+    {
+        evictions++;
+    }
+
+    slot->valid = false;
+    slot->key = key;
+    slot->op_count = 0;
+    slot->text_length = 0;
+    capturing = slot;
+    overflowed = false;
+    ili9341_set_recorder(&recorder);
+}
+
+void display_list_capture_end(uint32_t cycles)
+{
+    ili9341_set_recorder(NULL);
+    if (capturing == NULL)
+    {
+        return;
+    }
+
+    if (overflowed)
+    {
+        overflows++;
+    }
+    else
+    {
+        capturing->valid = true;
+        capturing->last_used = ++use_counter;
+    }
+    capturing = NULL;
+    capture_cycles += cycles;
+    captures++;
+}
+
+void display_list_print_stats(void)
+{
+    uint32_t lookups = hits + misses;
+    if (lookups == 0)
+    {
+        return;
+    }
+
+    uint32_t capture_us = captures ? (uint32_t)(capture_cycles / captures / CYCLES_PER_US) : 0;
+    uint32_t replay_us = hits ? (uint32_t)(replay_cycles / hits / CYCLES_PER_US) : 0;
+    printf("Display lists: %lu/%lu hits (%lu%%), %lu evictions, %lu overflows\n", hits, lookups,
+           hits * 100 / lookups, evictions, overflows);
+
+    // Each hit saved the difference between a full render and a replay
+    if (hits > 0 && captures > 0)
+    {
+        uint32_t saved_ms = capture_us > replay_us ? (uint32_t)((uint64_t)(capture_us - replay_us) * hits / 1000) : 0;
+        printf("  Render %lu us, replay %lu us, saved %lu ms\n", capture_us, replay_us, saved_ms);
+    }
+
+    hits = 0;
+    misses = 0;
+    evictions = 0;
+    overflows = 0;
+    replay_cycles = 0;
+    capture_cycles = 0;
+    captures = 0;
+}
@@ -0,0 +1,65 @@
+#ifndef DISPLAY_LIST_H
+#define DISPLAY_LIST_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Captured screens, replayed without redoing their layout
+//
+// While a capture is open every fill and glyph the ILI9341 driver draws is
+// appended to a display list. Glyphs drawn side by side in the same font and
+// color merge into one run, which replay sends as a single address window
+// instead of one per glyph. The DISPLAY_LIST_CACHE_SIZE most recently used
+// lists stay in RAM, keyed by whatever the caller draws from.
+
+#define DISPLAY_LIST_CACHE_SIZE 4
+#define DISPLAY_LIST_MAX_OPS 160  // Fills and glyph runs per list
+#define DISPLAY_LIST_MAX_TEXT 320 // Characters across all glyph runs in a list
+
+typedef enum
+{
+    DISPLAY_OP_FILL,
+    DISPLAY_OP_GLYPHS,
+} display_op_type_t;
+
+typedef struct
+{
+    uint8_t type;
+    uint8_t font;  // Index into tft_fonts
+    uint8_t scale;
+    uint8_t count; // Glyphs in a run
+    uint16_t x;
+    uint16_t y;
+    uint16_t w;    // Fill size, or the run's width so far while capturing
+    uint16_t h;
+    uint16_t text; // Offset of a run's characters in the list's text
+    uint8_t r;
+    uint8_t g;
+    uint8_t b;
+} display_op_t;
+
+typedef struct
+{
+    const void *key;
+    uint32_t last_used;
+    bool valid;
+    uint16_t op_count;
+    uint16_t text_length;
+    display_op_t ops[DISPLAY_LIST_MAX_OPS];
+    char text[DISPLAY_LIST_MAX_TEXT];
+} display_list_t;
+
+// Replay the list cached for <key>. Returns false on a miss
+bool display_list_replay(const void *key);
+
+// Start capturing for <key> into the least recently used slot
+void display_list_capture_begin(const void *key);
+
+// Stop capturing. A list that overflowed is dropped
+// <cycles> is what the captured render cost, for the saving estimate
+void display_list_capture_end(uint32_t cycles);
+
+// Print hit rate, replay and capture times and the estimated saving
+void display_list_print_stats(void);
+
+#endif
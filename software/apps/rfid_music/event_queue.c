@@ -0,0 +1,144 @@
+// Run-to-completion event queue
+//
+// One ring buffer per priority. Producers reserve a slot with a
+// compare-and-exchange on the head index and then publish it with a ready
+// flag, so posting never disables interrupts. Only the main loop consumes.
+
+#include "event_queue.h"
+#include <stdio.h>
+#include <string.h>
+#include "nrf.h"
+#include "cycle_counter.h"
+#include "nrf_atomic.h"
+
+#define EVENT_QUEUE_MASK (EVENT_QUEUE_SIZE - 1)
+
+typedef struct
+{
+    event_handler_t handler;
+    void *context;
+    uint32_t posted_at; // DWT cycle count
+    volatile bool ready;
+} event_t;
+
+typedef struct
+{
+    event_t slots[EVENT_QUEUE_SIZE];
+    nrf_atomic_u32_t head; // Next slot to reserve, advanced by producers
+    volatile uint32_t tail; // Next slot to run, advanced by the main loop only
+    nrf_atomic_u32_t high_water;
+    nrf_atomic_u32_t dropped;
+    uint32_t dispatched;
+    uint32_t max_latency;   // Cycles
+    uint64_t total_latency; // Cycles
+} event_ring_t;
+
+static event_ring_t rings[EVENT_PRIORITY_COUNT];
+
+void event_queue_init(void)
+{
+    memset(rings, 0, sizeof(rings));
+
+    // Cycle counter is used to timestamp events
+    cycle_counter_init();
+}
+
+bool event_post(event_priority_t priority, event_handler_t handler, void *context)
+{
+    event_ring_t *ring = &rings[priority];
+
+    // Reserve a slot
+    uint32_t head = ring->head;
+    do
+    {
+        if (head - ring->tail >= EVENT_QUEUE_SIZE)
+        {
+            nrf_atomic_u32_add(&ring->dropped, 1);
+            return false;
+        }
+    } while (!nrf_atomic_u32_cmp_exch(&ring->head, &head, head + 1));
+
+    // Fill and publish it
+    event_t *event = &ring->slots[head & EVENT_QUEUE_MASK];
+    event->handler = handler;
+    event->context = context;
+    event->posted_at = DWT->CYCCNT;
+    __DMB();
+    event->ready = true;
+
+    // Track the deepest the queue has been
+    uint32_t depth = head + 1 - ring->tail;
+    uint32_t high_water = ring->high_water;
+    while (depth > high_water && !nrf_atomic_u32_cmp_exch(&ring->high_water, &high_water, depth))
+    {
+    }
+
+    return true;
+}
+
+// Take the oldest published event from the highest non-empty priority
+static bool event_pop(event_t *out, event_ring_t **from)
+{
+    for (int priority = 0; priority < EVENT_PRIORITY_COUNT; priority++)
+    {
+        event_ring_t *ring = &rings[priority];
+        if (ring->tail == ring->head)
+        {
+            continue;
+        }
+
+        event_t *event = &ring->slots[ring->tail & EVENT_QUEUE_MASK];
+        if (!event->ready)
+        {
+            // Reserved but not yet published. Its producer will finish before
+            // we run again, so leave this priority alone for now
+            continue;
+        }
+
+        *out = *event;
+        event->ready = false;
+        __DMB();
+        ring->tail++;
+        *from = ring;
+        return true;
+    }
+    return false;
+}
+
+uint32_t event_queue_dispatch(void)
+{
+    uint32_t count = 0;
+    event_t event;
+    event_ring_t *ring;
+
+    while (event_pop(&event, &ring))
+    {
+        uint32_t latency = DWT->CYCCNT - event.posted_at;
+        ring->dispatched++;
+        ring->total_latency += latency;
+        if (latency > ring->max_latency)
+        {
+            ring->max_latency = latency;
+        }
+
+        event.handler(event.context);
+        count++;
+    }
+
+    return count;
+}
+
+void event_queue_print_stats(void)
+{
+    static const char *names[EVENT_PRIORITY_COUNT] = {"high", "normal", "low"};
+
+    printf("Event queue (%d slots per priority):\n", EVENT_QUEUE_SIZE);
+    for (int priority = 0; priority < EVENT_PRIORITY_COUNT; priority++)
+    {
+        event_ring_t *ring = &rings[priority];
+        uint32_t average = ring->dispatched ? (uint32_t)(ring->total_latency / ring->dispatched) : 0;
+        printf("  %-6s: %lu run, %lu dropped, high-water %lu, latency avg %lu us max %lu us\n",
+               names[priority], ring->dispatched, ring->dropped, ring->high_water,
+               average / CYCLES_PER_US, ring->max_latency / CYCLES_PER_US);
+    }
+}
@@ -0,0 +1,39 @@
+#ifndef EVENT_QUEUE_H
+#define EVENT_QUEUE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Run-to-completion event queue
+//
+// Interrupt handlers and timer callbacks post short events here instead of
+// doing the work themselves. The main loop runs them one at a time, highest
+// priority first, and sleeps when nothing is pending.
+
+#define EVENT_QUEUE_SIZE 16 // Slots per priority level, must be a power of two
+
+typedef enum
+{
+    EVENT_PRIORITY_HIGH,   // Sensor reads that must not be delayed
+    EVENT_PRIORITY_NORMAL, // Display updates
+    EVENT_PRIORITY_LOW,    // Housekeeping and reports
+    EVENT_PRIORITY_COUNT,
+} event_priority_t;
+
+typedef void (*event_handler_t)(void *context);
+
+// Reset the queue and its statistics
+void event_queue_init(void);
+
+// Post an event. Safe to call from any interrupt priority, constant time
+// Returns false if the queue for <priority> is full and the event was dropped
+bool event_post(event_priority_t priority, event_handler_t handler, void *context);
+
+// Run pending events until the queue is empty
+// Returns the number of events that ran
+uint32_t event_queue_dispatch(void);
+
+// Print per-priority latency and high-water marks
+void event_queue_print_stats(void);
+
+#endif
@@ -0,0 +1,132 @@
+// Generated by software/tools/font_gen.py, do not edit
+// Rebuild with: python3 font_gen.py fonts/font_8x8.txt fonts/font_5x5.txt -o <app>/font_data
+
+#include "font_data.h"
+
+// font_8x8: 77 glyphs in 6 ranges, 640 bytes (a dense 128 entry table is 1024)
+static const uint8_t font_8x8_rows[] = {
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x18, 0x18, 0x18, 0x18, 0x18, 0x00, 0x18, 0x00,
+    0x66, 0x66, 0x24, 0x00, 0x00, 0x00, 0x00, 0x00, 0x36, 0x36, 0x7F, 0x36, 0x7F, 0x36, 0x36, 0x00,
+    0x1C, 0x36, 0x1C, 0x6E, 0x3B, 0x33, 0x6E, 0x00, 0x18, 0x18, 0x0C, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x30, 0x18, 0x0C, 0x0C, 0x0C, 0x18, 0x30, 0x00, 0x0C, 0x18, 0x30, 0x30, 0x30, 0x18, 0x0C, 0x00,
+    0x00, 0x18, 0x18, 0x7E, 0x18, 0x18, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x18, 0x18, 0x0C,
+    0x00, 0x00, 0x00, 0x7E, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x18, 0x18, 0x00,
+    0x60, 0x30, 0x18, 0x0C, 0x06, 0x03, 0x01, 0x00, 0x3C, 0x66, 0x76, 0x6E, 0x7E, 0x66, 0x66, 0x3C,
+    0x18, 0x1C, 0x18, 0x18, 0x18, 0x18, 0x18, 0x3C, 0x3C, 0x66, 0x60, 0x30, 0x18, 0x0C, 0x06, 0x7E,
+    0x3C, 0x66, 0x60, 0x38, 0x60, 0x60, 0x66, 0x3C, 0x30, 0x38, 0x3C, 0x36, 0x7E, 0x30, 0x30, 0x30,
+    0x7E, 0x06, 0x3E, 0x60, 0x60, 0x60, 0x66, 0x3C, 0x3C, 0x66, 0x06, 0x3E, 0x66, 0x66, 0x66, 0x3C,
+    0x7E, 0x60, 0x30, 0x18, 0x0C, 0x0C, 0x0C, 0x0C, 0x3C, 0x66, 0x66, 0x3C, 0x66, 0x66, 0x66, 0x3C,
+    0x3C, 0x66, 0x66, 0x66, 0x7C, 0x60, 0x66, 0x3C, 0x00, 0x18, 0x18, 0x00, 0x00, 0x18, 0x18, 0x00,
+    0x3C, 0x66, 0x60, 0x30, 0x18, 0x00, 0x18, 0x00, 0x18, 0x3C, 0x66, 0x66, 0x7E, 0x66, 0x66, 0x66,
+    0x3E, 0x66, 0x66, 0x3E, 0x66, 0x66, 0x66, 0x3E, 0x3C, 0x66, 0x06, 0x06, 0x06, 0x06, 0x66, 0x3C,
+    0x3E, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x3E, 0x7E, 0x06, 0x06, 0x3E, 0x06, 0x06, 0x06, 0x7E,
+    0x7E, 0x06, 0x06, 0x3E, 0x06, 0x06, 0x06, 0x06, 0x3C, 0x66, 0x06, 0x76, 0x66, 0x66, 0x66, 0x3C,
+    0x66, 0x66, 0x66, 0x7E, 0x66, 0x66, 0x66, 0x66, 0x3C, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x3C,
+    0x78, 0x30, 0x30, 0x30, 0x30, 0x30, 0x36, 0x1C, 0x66, 0x36, 0x1E, 0x0E, 0x1E, 0x36, 0x66, 0x66,
+    0x06, 0x06, 0x06, 0x06, 0x06, 0x06, 0x06, 0x7E, 0xC6, 0xEE, 0xFE, 0xD6, 0xC6, 0xC6, 0xC6, 0xC6,
+    0x66, 0x66, 0x6E, 0x7E, 0x7E, 0x76, 0x66, 0x66, 0x3C, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x3C,
+    0x3E, 0x66, 0x66, 0x3E, 0x06, 0x06, 0x06, 0x06, 0x3C, 0x66, 0x66, 0x66, 0x66, 0x76, 0x3C, 0x60,
+    0x3E, 0x66, 0x66, 0x3E, 0x1E, 0x36, 0x66, 0x66, 0x7C, 0x06, 0x06, 0x3C, 0x60, 0x60, 0x66, 0x3C,
+    0x7E, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x3C,
+    0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x3C, 0x18, 0xC6, 0xC6, 0xC6, 0xC6, 0xD6, 0xFE, 0xEE, 0xC6,
+    0x66, 0x66, 0x3C, 0x18, 0x18, 0x3C, 0x66, 0x66, 0x66, 0x66, 0x66, 0x3C, 0x18, 0x18, 0x18, 0x18,
+    0x7E, 0x60, 0x30, 0x18, 0x0C, 0x06, 0x06, 0x7E, 0x00, 0x00, 0x3C, 0x60, 0x7C, 0x66, 0x66, 0x7C,
+    0x06, 0x06, 0x3E, 0x66, 0x66, 0x66, 0x66, 0x3E, 0x00, 0x00, 0x3C, 0x66, 0x06, 0x06, 0x66, 0x3C,
+    0x60, 0x60, 0x7C, 0x66, 0x66, 0x66, 0x66, 0x7C, 0x00, 0x00, 0x3C, 0x66, 0x7E, 0x06, 0x66, 0x3C,
+    0x70, 0x18, 0x18, 0x7E, 0x18, 0x18, 0x18, 0x18, 0x00, 0x00, 0x7C, 0x66, 0x66, 0x66, 0x7C, 0x60,
+    0x06, 0x06, 0x3E, 0x66, 0x66, 0x66, 0x66, 0x66, 0x18, 0x00, 0x1C, 0x18, 0x18, 0x18, 0x18, 0x3C,
+    0x60, 0x00, 0x70, 0x60, 0x60, 0x60, 0x60, 0x3C, 0x06, 0x06, 0x66, 0x36, 0x1E, 0x36, 0x66, 0x66,
+    0x1C, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x3C, 0x00, 0x00, 0x36, 0x7E, 0x7E, 0xD6, 0xC6, 0xC6,
+    0x00, 0x00, 0x3A, 0x66, 0x66, 0x66, 0x66, 0x66, 0x00, 0x00, 0x3C, 0x66, 0x66, 0x66, 0x66, 0x3C,
+    0x00, 0x00, 0x3E, 0x66, 0x66, 0x66, 0x3E, 0x06, 0x00, 0x00, 0x7C, 0x66, 0x66, 0x66, 0x7C, 0x60,
+    0x00, 0x00, 0x3E, 0x66, 0x06, 0x06, 0x06, 0x06, 0x00, 0x00, 0x7C, 0x06, 0x3C, 0x60, 0x60, 0x3E,
+    0x18, 0x18, 0x7E, 0x18, 0x18, 0x18, 0x18, 0x70, 0x00, 0x00, 0x66, 0x66, 0x66, 0x66, 0x66, 0x7C,
+    0x00, 0x00, 0x66, 0x66, 0x66, 0x66, 0x3C, 0x18, 0x00, 0x00, 0xC6, 0xC6, 0xC6, 0xD6, 0x7E, 0x6C,
+    0x00, 0x00, 0x66, 0x66, 0x3C, 0x18, 0x3C, 0x66, 0x00, 0x00, 0x66, 0x66, 0x66, 0x66, 0x7C, 0x60,
+    0x00, 0x00, 0x7E, 0x30, 0x18, 0x0C, 0x06, 0x7E,
+};
+
+static const tft_font_range_t font_8x8_ranges[] = {
+    {0x20, 0x23, 0},
+    {0x26, 0x29, 4},
+    {0x2B, 0x3A, 8},
+    {0x3F, 0x3F, 24},
+    {0x41, 0x5A, 25},
+    {0x61, 0x7A, 51},
+};
+
+const tft_font_t font_8x8 = {
+    .name = "font_8x8",
+    .height = 8,
+    .advance = 8,
+    .spacing = 0,
+    .range_count = 6,
+    .glyph_count = 77,
+    .ranges = font_8x8_ranges,
+    .widths = NULL,
+    .rows = font_8x8_rows,
+};
+
+// font_5x5: 95 glyphs in 1 ranges, 574 bytes (a dense 128 entry table is 640)
+static const uint8_t font_5x5_rows[] = {
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x80, 0x80, 0x80, 0x00, 0x80, 0xA0, 0xA0, 0x00, 0x00, 0x00, 0x50,
+    0xF8, 0x50, 0xF8, 0x50, 0xF0, 0x28, 0x70, 0xA0, 0x78, 0x98, 0x58, 0x20, 0xD0, 0xC8, 0x20, 0x50,
+    0x20, 0x50, 0xA0, 0x80, 0x40, 0x00, 0x00, 0x00, 0x80, 0x40, 0x40, 0x40, 0x80, 0x40, 0x80, 0x80,
+    0x80, 0x40, 0xA8, 0x70, 0xF8, 0x70, 0xA8, 0x00, 0x40, 0xE0, 0x40, 0x00, 0x00, 0x00, 0x00, 0x80,
+    0x40, 0x00, 0x00, 0xE0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x80, 0x80, 0x40, 0x20, 0x10, 0x08,
+    0x70, 0xC8, 0xA8, 0x98, 0x70, 0x40, 0x60, 0x40, 0x40, 0xE0, 0x60, 0x90, 0x40, 0x20, 0xF0, 0x60,
+    0x80, 0x40, 0x80, 0x60, 0x60, 0x50, 0xF0, 0x40, 0x40, 0xE0, 0x20, 0x60, 0x80, 0x60, 0x40, 0x20,
+    0x70, 0x90, 0x60, 0xF0, 0x80, 0x40, 0x20, 0x20, 0x60, 0x90, 0x60, 0x90, 0x60, 0x60, 0x90, 0xE0,
+    0x80, 0x80, 0x00, 0x80, 0x00, 0x80, 0x00, 0x00, 0x80, 0x00, 0x80, 0x40, 0x80, 0x40, 0x20, 0x40,
+    0x80, 0x00, 0xE0, 0x00, 0xE0, 0x00, 0x20, 0x40, 0x80, 0x40, 0x20, 0x60, 0x80, 0x40, 0x00, 0x40,
+    0x70, 0x80, 0xB0, 0xA8, 0x70, 0x70, 0x88, 0xF8, 0x88, 0x88, 0x78, 0x88, 0x78, 0x88, 0x78, 0xF0,
+    0x08, 0x08, 0x08, 0xF0, 0x78, 0x88, 0x88, 0x88, 0x78, 0xF8, 0x08, 0x78, 0x08, 0xF8, 0xF8, 0x08,
+    0x78, 0x08, 0x08, 0xF0, 0x08, 0xC8, 0x88, 0xF0, 0x88, 0x88, 0xF8, 0x88, 0x88, 0xE0, 0x40, 0x40,
+    0x40, 0xE0, 0xE0, 0x40, 0x40, 0x48, 0x30, 0x90, 0x50, 0x30, 0x50, 0x90, 0x10, 0x10, 0x10, 0x10,
+    0xF0, 0x88, 0xD8, 0xA8, 0x88, 0x88, 0x88, 0x98, 0xA8, 0xC8, 0x88, 0x70, 0x88, 0x88, 0x88, 0x70,
+    0x78, 0x88, 0x78, 0x08, 0x08, 0x70, 0x88, 0x88, 0x48, 0xB0, 0x78, 0x88, 0x78, 0x28, 0x48, 0xF0,
+    0x08, 0x70, 0x80, 0x78, 0xF8, 0x20, 0x20, 0x20, 0x20, 0x88, 0x88, 0x88, 0x88, 0x70, 0x88, 0x88,
+    0x88, 0x50, 0x20, 0x88, 0x88, 0xA8, 0xA8, 0x50, 0x88, 0x50, 0x20, 0x50, 0x88, 0x88, 0x50, 0x20,
+    0x20, 0x20, 0xE0, 0x80, 0x40, 0x20, 0xE0, 0xE0, 0x20, 0x20, 0x20, 0xE0, 0x08, 0x10, 0x20, 0x40,
+    0x80, 0xE0, 0x80, 0x80, 0x80, 0xE0, 0x40, 0xA0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xF8,
+    0x40, 0x80, 0x00, 0x00, 0x00, 0x00, 0x70, 0x48, 0x48, 0xB0, 0x10, 0x70, 0x90, 0x90, 0x70, 0x00,
+    0xC0, 0x20, 0x20, 0xC0, 0x80, 0x80, 0xE0, 0x90, 0xE0, 0x00, 0x40, 0xA0, 0x60, 0xC0, 0x80, 0x40,
+    0xE0, 0x40, 0x40, 0xC0, 0xA0, 0xC0, 0x80, 0x60, 0x10, 0x10, 0x70, 0x90, 0x90, 0x80, 0x00, 0x80,
+    0x80, 0x80, 0x80, 0x00, 0x80, 0xA0, 0x40, 0x20, 0x20, 0xA0, 0x60, 0xA0, 0x80, 0x80, 0x80, 0x80,
+    0x80, 0x00, 0x58, 0xA8, 0x88, 0x88, 0x00, 0x60, 0xA0, 0xA0, 0xA0, 0x00, 0x40, 0xA0, 0xA0, 0x40,
+    0x00, 0x60, 0xA0, 0x60, 0x20, 0x00, 0xC0, 0xA0, 0xC0, 0x80, 0x00, 0xA0, 0x60, 0x20, 0x20, 0x00,
+    0xC0, 0x40, 0x80, 0xC0, 0x00, 0xE0, 0x40, 0x40, 0x80, 0x00, 0x90, 0x90, 0x90, 0x60, 0x00, 0xA0,
+    0xA0, 0xA0, 0x40, 0x00, 0x88, 0xA8, 0xA8, 0x50, 0x00, 0xA0, 0x40, 0x40, 0xA0, 0x00, 0xA0, 0xA0,
+    0x40, 0x20, 0x00, 0xC0, 0x80, 0x40, 0xC0, 0x80, 0x40, 0x60, 0x40, 0x80, 0x80, 0x80, 0x00, 0x80,
+    0x80, 0x20, 0x40, 0xC0, 0x40, 0x20, 0x00, 0xA0, 0x50, 0x00, 0x00,
+};
+
+static const tft_font_range_t font_5x5_ranges[] = {
+    {0x20, 0x7E, 0},
+};
+
+static const uint8_t font_5x5_widths[] = {
+    0x03, 0x01, 0x03, 0x05, 0x05, 0x05, 0x04, 0x02, 0x02, 0x02, 0x05, 0x03, 0x02, 0x03, 0x01, 0x05,
+    0x05, 0x03, 0x04, 0x03, 0x04, 0x03, 0x04, 0x04, 0x04, 0x04, 0x01, 0x02, 0x03, 0x03, 0x03, 0x03,
+    0x05, 0x05, 0x05, 0x05, 0x05, 0x05, 0x05, 0x05, 0x05, 0x03, 0x05, 0x04, 0x04, 0x05, 0x05, 0x05,
+    0x05, 0x05, 0x05, 0x05, 0x05, 0x05, 0x05, 0x05, 0x05, 0x05, 0x03, 0x03, 0x05, 0x03, 0x03, 0x05,
+    0x02, 0x05, 0x04, 0x03, 0x04, 0x03, 0x03, 0x03, 0x04, 0x01, 0x03, 0x03, 0x01, 0x05, 0x03, 0x03,
+    0x03, 0x03, 0x03, 0x02, 0x03, 0x04, 0x03, 0x05, 0x03, 0x03, 0x02, 0x03, 0x01, 0x03, 0x04,
+};
+
+const tft_font_t font_5x5 = {
+    .name = "font_5x5",
+    .height = 5,
+    .advance = 0,
+    .spacing = 1,
+    .range_count = 1,
+    .glyph_count = 95,
+    .ranges = font_5x5_ranges,
+    .widths = font_5x5_widths,
+    .rows = font_5x5_rows,
+};
+
+const tft_font_t *const tft_fonts[TFT_FONT_COUNT] = {
+    &font_8x8,
+    &font_5x5,
+};
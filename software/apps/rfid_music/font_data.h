@@ -0,0 +1,16 @@
+// Generated by software/tools/font_gen.py, do not edit
+
+#ifndef FONT_DATA_H
+#define FONT_DATA_H
+
+#include "tft_font.h"
+
+#define TFT_FONT_COUNT 2
+
+extern const tft_font_t font_8x8;
+extern const tft_font_t font_5x5;
+
+// Every generated font, for reporting
+extern const tft_font_t *const tft_fonts[TFT_FONT_COUNT];
+
+#endif
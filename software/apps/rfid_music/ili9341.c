@@ -1,10 +1,44 @@
 #include "ili9341.h"
+#include <stdio.h>
+#include <string.h>
 #include <nrf_delay.h>
 #include <nrfx_spim.h>
 #include <nrf_gpio.h>
 #include "microbit_v2.h"
+#include "scan_trace.h"
+#include "tickless_timer.h"
 
-static const nrfx_spim_t SPIM_INST = NRFX_SPIM_INSTANCE(2);
+// SPIM3 is the only instance that can clock at 16 and 32 MHz
+static const nrfx_spim_t SPIM_INST = NRFX_SPIM_INSTANCE(3);
+
+// Write clocks tried by the startup self-test, fastest first
+static const nrf_spim_frequency_t write_clocks[] = {NRF_SPIM_FREQ_32M, NRF_SPIM_FREQ_16M, NRF_SPIM_FREQ_8M};
+static const uint8_t write_clock_mhz[] = {32, 16, 8};
+
+// The ILI9341 read cycle is at least 150 ns, so reads always use 4 MHz
+#define READ_CLOCK NRF_SPIM_FREQ_4M
+
+// Pixels per SPI transfer when sending runs of pixels
+#define PIXEL_CHUNK 256
+
+// Pixels written and read back by the self-test
+#define SELFTEST_PIXELS 8
+
+// Longest glyph run ili9341_draw_run() draws in one window
+#define MAX_RUN_GLYPHS 64
+
+static nrf_spim_frequency_t write_clock = NRF_SPIM_FREQ_8M;
+static uint8_t write_mhz = 8;
+
+static bool display_on = false;
+
+// Told about every fill and glyph while a display list is being captured
+static const ili9341_recorder_t *recorder = NULL;
+
+// Next entry of initcmd to send, NULL before the reset
+static const uint8_t *init_cursor = NULL;
+
+#define INIT_DELAY_US 150000 // After reset, sleep out and display on
 
 #define TFT_SCK EDGE_P13  // SPI clock
 #define TFT_MOSI EDGE_P15 // SPI MOSI
@@ -13,13 +47,20 @@ static const nrfx_spim_t SPIM_INST = NRFX_SPIM_INSTANCE(2);
 
 // ILI9341 Commands
 #define ILI9341_SWRESET 0x01 // Software reset
+#define ILI9341_RDDID 0x04   // Read display identification
 #define ILI9341_SLPOUT 0x11  // Sleep out
+#define ILI9341_DISPOFF 0x28 // Display OFF
 #define ILI9341_DISPON 0x29  // Display ON
 #define ILI9341_CASET 0x2A   // Column address set
 #define ILI9341_PASET 0x2B   // Page address set
 #define ILI9341_RAMWR 0x2C   // Memory write
+#define ILI9341_RAMRD 0x2E   // Memory read
+#define ILI9341_VSCRDEF 0x33 // Vertical scrolling definition
 #define ILI9341_MADCTL 0x36  // Memory data access control
+#define ILI9341_VSCRSADD 0x37 // Vertical scrolling start address
 #define ILI9341_PIXFMT 0x3A  // Pixel format
+#define ILI9341_WRDISBV 0x51 // Write display brightness
+#define ILI9341_WRCTRLD 0x53 // Write CTRL display
 
 #define ILI9341_PWCTR1 0xC0   ///< Power Control 1
 #define ILI9341_PWCTR2 0xC1   ///< Power Control 2
@@ -69,8 +110,12 @@ static void send_command(uint8_t cmd)
     nrf_gpio_pin_clear(TFT_DC); // DC low for command
     nrf_gpio_pin_clear(TFT_CS); // CS low to select the screen
 
+    scan_trace_spi(false);
+    tickless_timer_hf_begin(TICKLESS_HF_SPIM3);
     nrfx_spim_xfer_desc_t xfer_desc = NRFX_SPIM_XFER_TX(&cmd, 1);
     nrfx_spim_xfer(&SPIM_INST, &xfer_desc, 0);
+    tickless_timer_hf_end(TICKLESS_HF_SPIM3);
+    scan_trace_spi(true);
 
     nrf_gpio_pin_set(TFT_CS); // CS high to deselect
 }
@@ -81,15 +126,159 @@ static void send_data(uint8_t *data, size_t len)
     nrf_gpio_pin_set(TFT_DC);   // DC high for data
     nrf_gpio_pin_clear(TFT_CS); // CS low to select the screen
 
+    scan_trace_spi(false);
+    tickless_timer_hf_begin(TICKLESS_HF_SPIM3);
     nrfx_spim_xfer_desc_t xfer_desc = NRFX_SPIM_XFER_TX(data, len);
     nrfx_spim_xfer(&SPIM_INST, &xfer_desc, 0);
+    tickless_timer_hf_end(TICKLESS_HF_SPIM3);
+    scan_trace_spi(true);
 
     nrf_gpio_pin_set(TFT_CS); // CS high to deselect
 }
 
-// Initialize the ILI9341 display using initcmd array
-void ili9341_init(void)
+// Send a command and read its reply, keeping CS low across both
+static void read_command(uint8_t cmd, uint8_t *data, size_t len)
+{
+    nrf_spim_frequency_set(SPIM_INST.p_reg, READ_CLOCK);
+    nrf_gpio_pin_clear(TFT_DC);
+    nrf_gpio_pin_clear(TFT_CS);
+
+    tickless_timer_hf_begin(TICKLESS_HF_SPIM3);
+    nrfx_spim_xfer_desc_t cmd_desc = NRFX_SPIM_XFER_TX(&cmd, 1);
+    nrfx_spim_xfer(&SPIM_INST, &cmd_desc, 0);
+    nrf_gpio_pin_set(TFT_DC);
+    nrfx_spim_xfer_desc_t read_desc = NRFX_SPIM_XFER_RX(data, len);
+    nrfx_spim_xfer(&SPIM_INST, &read_desc, 0);
+    tickless_timer_hf_end(TICKLESS_HF_SPIM3);
+
+    nrf_gpio_pin_set(TFT_CS);
+    nrf_spim_frequency_set(SPIM_INST.p_reg, write_clock);
+}
+
+// Pixels are RGB565, high byte first
+static void pack_pixel(uint8_t *out, uint8_t r, uint8_t g, uint8_t b)
+{
+    uint16_t pixel = ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3);
+    out[0] = pixel >> 8;
+    out[1] = pixel & 0xFF;
+}
+
+// Send <count> pixels of one color into the current window
+static void send_pixels(uint8_t r, uint8_t g, uint8_t b, uint32_t count)
+{
+    static uint8_t chunk[PIXEL_CHUNK * 2];
+    uint32_t filled = count < PIXEL_CHUNK ? count : PIXEL_CHUNK;
+    for (uint32_t i = 0; i < filled; i++)
+    {
+        pack_pixel(&chunk[i * 2], r, g, b);
+    }
+
+    while (count > 0)
+    {
+        uint32_t n = count < PIXEL_CHUNK ? count : PIXEL_CHUNK;
+        send_data(chunk, n * 2);
+        count -= n;
+    }
+}
+
+void set_address_window(uint16_t x, uint16_t y, uint16_t w, uint16_t h);
+
+// Write a test pattern into the bottom row at <clock>, read it back and compare
+static bool readback_ok(nrf_spim_frequency_t clock)
+{
+    // Red and blue match in every pixel, so BGR order doesn't matter
+    static const uint8_t colors[SELFTEST_PIXELS][3] = {
+        {0xF8, 0x00, 0xF8}, {0x00, 0xFC, 0x00}, {0xA8, 0x54, 0xA8}, {0x50, 0xA8, 0x50},
+        {0xF8, 0xFC, 0xF8}, {0x08, 0x04, 0x08}, {0x80, 0x80, 0x80}, {0x00, 0x00, 0x00},
+    };
+    uint8_t pattern[SELFTEST_PIXELS * 2];
+    for (int i = 0; i < SELFTEST_PIXELS; i++)
+    {
+        pack_pixel(&pattern[i * 2], colors[i][0], colors[i][1], colors[i][2]);
+    }
+
+    write_clock = clock;
+    nrf_spim_frequency_set(SPIM_INST.p_reg, clock);
+    set_address_window(0, TFT_HEIGHT - 1, SELFTEST_PIXELS, 1);
+    send_data(pattern, sizeof(pattern));
+
+    // Reads come back as 18-bit pixels after one dummy byte
+    uint8_t readback[1 + SELFTEST_PIXELS * 3];
+    set_address_window(0, TFT_HEIGHT - 1, SELFTEST_PIXELS, 1);
+    read_command(ILI9341_RAMRD, readback, sizeof(readback));
+
+    for (int i = 0; i < SELFTEST_PIXELS; i++)
+    {
+        const uint8_t *pixel = &readback[1 + i * 3];
+        if ((pixel[0] & 0xF8) != colors[i][0] ||
+            (pixel[1] & 0xFC) != colors[i][1] ||
+            (pixel[2] & 0xF8) != colors[i][2])
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Pick the fastest write clock whose writes read back intact
+static void select_write_clock(void)
+{
+    // RDDID starts with a single dummy clock, not a dummy byte, so the 24 ID
+    // bits sit one bit into the four bytes read
+    uint8_t reply[4];
+    read_command(ILI9341_RDDID, reply, sizeof(reply));
+    uint32_t bits = ((uint32_t)reply[0] << 24) | ((uint32_t)reply[1] << 16) | ((uint32_t)reply[2] << 8) | reply[3];
+    uint32_t id = (bits << 1) >> 8;
+    printf("ILI9341 ID %02lX %02lX %02lX\n", (id >> 16) & 0xFF, (id >> 8) & 0xFF, id & 0xFF);
+
+    for (size_t i = 0; i < sizeof(write_clocks) / sizeof(write_clocks[0]); i++)
+    {
+        if (readback_ok(write_clocks[i]))
+        {
+            write_mhz = write_clock_mhz[i];
+            printf("Display SPI at %u MHz\n", write_mhz);
+            return;
+        }
+    }
+
+    // Nothing read back, MISO may not be wired. Stay at the known-good clock
+    write_clock = NRF_SPIM_FREQ_8M;
+    nrf_spim_frequency_set(SPIM_INST.p_reg, write_clock);
+    write_mhz = 8;
+    printf("Display readback failed, SPI stays at 8 MHz\n");
+}
+
+// Run the next part of the initialization, up to the next mandatory delay
+uint32_t ili9341_init_step(void)
 {
+    if (init_cursor != NULL)
+    {
+        // Send initialization commands from initcmd array
+        uint8_t cmd, x, numArgs;
+        while ((cmd = *init_cursor++) > 0)
+        {
+            x = *init_cursor++;
+            numArgs = x & 0x7F;
+            send_command(cmd);
+            if (numArgs)
+            {
+                // EasyDMA can't read flash, so the arguments go through RAM
+                uint8_t args[16];
+                memcpy(args, init_cursor, numArgs);
+                send_data(args, numArgs);
+                init_cursor += numArgs;
+            }
+            if (x & 0x80)
+            {
+                return INIT_DELAY_US;
+            }
+        }
+        init_cursor = NULL;
+        display_on = true;
+        select_write_clock();
+        return 0;
+    }
+
     // Configure GPIO
     nrf_gpio_cfg_output(TFT_CS);
     nrf_gpio_cfg_output(TFT_DC);
@@ -99,38 +288,64 @@ void ili9341_init(void)
     spim_config.sck_pin = TFT_SCK;
     spim_config.mosi_pin = TFT_MOSI;
     spim_config.miso_pin = EDGE_P14;
-    spim_config.frequency = NRF_SPIM_FREQ_8M;
+    spim_config.frequency = NRF_SPIM_FREQ_8M; // Raised by the self-test
     spim_config.mode = NRF_SPIM_MODE_0;
     nrfx_spim_init(&SPIM_INST, &spim_config, NULL, NULL);
 
+    // 16 and 32 MHz edges need high drive on the clock and data lines
+    nrf_gpio_cfg(TFT_SCK, NRF_GPIO_PIN_DIR_OUTPUT, NRF_GPIO_PIN_INPUT_CONNECT,
+                 NRF_GPIO_PIN_NOPULL, NRF_GPIO_PIN_H0H1, NRF_GPIO_PIN_NOSENSE);
+    nrf_gpio_cfg(TFT_MOSI, NRF_GPIO_PIN_DIR_OUTPUT, NRF_GPIO_PIN_INPUT_DISCONNECT,
+                 NRF_GPIO_PIN_NOPULL, NRF_GPIO_PIN_H0H1, NRF_GPIO_PIN_NOSENSE);
+
     // Perform software reset
     send_command(ILI9341_SWRESET);
-    nrf_delay_ms(150); // Allow time for reset
+    init_cursor = initcmd;
+    return INIT_DELAY_US; // Allow time for reset
+}
 
-    // Send initialization commands from initcmd array
-    const uint8_t *addr = initcmd;
-    uint8_t cmd, x, numArgs;
-    while ((cmd = *addr++) > 0)
+// Initialize the ILI9341 display using initcmd array
+void ili9341_init(void)
+{
+    uint32_t wait_us;
+    while ((wait_us = ili9341_init_step()) > 0)
     {
-        x = *addr++;
-        numArgs = x & 0x7F;
-        send_command(cmd);
-        if (numArgs)
-        {
-            send_data((uint8_t *)addr, numArgs);
-            addr += numArgs;
-        }
-        if (x & 0x80)
-        {
-            nrf_delay_ms(150);
-        }
+        nrf_delay_us(wait_us);
     }
 }
 
+// Blank or restore the panel. Frame memory is kept, so nothing needs redrawing
+void ili9341_set_display_on(bool on)
+{
+    send_command(on ? ILI9341_DISPON : ILI9341_DISPOFF);
+    display_on = on;
+}
+
+bool ili9341_is_display_on(void)
+{
+    return display_on;
+}
+
+void ili9341_set_brightness(uint8_t level)
+{
+    // BCTRL on, and BL on while the level is above zero
+    uint8_t control = level ? 0x24 : 0x20;
+    send_command(ILI9341_WRCTRLD);
+    send_data(&control, 1);
+    send_command(ILI9341_WRDISBV);
+    send_data(&level, 1);
+}
+
 // Fill the screen with a solid color
 void ili9341_fill_screen(uint8_t r, uint8_t g, uint8_t b)
 {
-    // Set full screen address window
+    ili9341_fill_rows(0, TFT_HEIGHT, r, g, b);
+}
+
+// Fill <h> full-width rows starting at row <y>
+void ili9341_fill_rows(uint16_t y, uint16_t h, uint8_t r, uint8_t g, uint8_t b)
+{
+    // Set full width address window
     send_command(ILI9341_CASET);
     uint8_t caset_data[] = {
         0x00, 0x00,
@@ -138,30 +353,45 @@ void ili9341_fill_screen(uint8_t r, uint8_t g, uint8_t b)
         (TFT_WIDTH - 1) & 0xFF};
     send_data(caset_data, 4);
 
+    uint16_t y2 = y + h - 1;
     send_command(ILI9341_PASET);
     uint8_t paset_data[] = {
-        0x00, 0x00,
-        (TFT_HEIGHT - 1) >> 8,
-        (TFT_HEIGHT - 1) & 0xFF};
+        y >> 8, y & 0xFF,
+        y2 >> 8, y2 & 0xFF};
     send_data(paset_data, 4);
 
     // Start memory write
     send_command(ILI9341_RAMWR);
 
-    // Create a buffer for multiple pixels
-    uint8_t pixel_buffer[3];
-
-    pixel_buffer[0] = r;
-    pixel_buffer[1] = g;
-    pixel_buffer[2] = b;
-
     // Send pixels in chunks
-    for (uint32_t i = 0; i < (TFT_WIDTH * TFT_HEIGHT); i += 1)
+    send_pixels(r, g, b, (uint32_t)TFT_WIDTH * h);
+
+    if (recorder)
     {
-        send_data(pixel_buffer, 3);
+        recorder->fill(0, y, TFT_WIDTH, h, r, g, b);
     }
 }
 
+// Rows top_fixed..top_fixed + scroll_height - 1 become a circular scroll area
+void ili9341_set_scroll_area(uint16_t top_fixed, uint16_t scroll_height)
+{
+    uint16_t bottom_fixed = TFT_HEIGHT - top_fixed - scroll_height;
+    send_command(ILI9341_VSCRDEF);
+    uint8_t vscrdef_data[] = {
+        top_fixed >> 8, top_fixed & 0xFF,
+        scroll_height >> 8, scroll_height & 0xFF,
+        bottom_fixed >> 8, bottom_fixed & 0xFF};
+    send_data(vscrdef_data, 6);
+}
+
+// Show frame memory row <row> at the top of the scroll area
+void ili9341_scroll_to(uint16_t row)
+{
+    send_command(ILI9341_VSCRSADD);
+    uint8_t vscrsadd_data[] = {row >> 8, row & 0xFF};
+    send_data(vscrsadd_data, 2);
+}
+
 // Set the address window for the drawing area
 void set_address_window(uint16_t x, uint16_t y, uint16_t w, uint16_t h)
 {
@@ -186,82 +416,155 @@ void set_address_window(uint16_t x, uint16_t y, uint16_t w, uint16_t h)
     send_command(ILI9341_RAMWR);
 }
 
-// Function to reverse the bit order in a byte
-static uint8_t reverse_bits(uint8_t byte)
+// Draw a single character at a specific position with color
+void ili9341_draw_char(uint16_t x, uint16_t y, char c, uint8_t scale, uint8_t r, uint8_t g, uint8_t b)
+{
+    ili9341_draw_glyph(x, y, c, &font_8x8, scale, r, g, b);
+}
+
+void ili9341_set_recorder(const ili9341_recorder_t *new_recorder)
 {
-    byte = ((byte & 0xF0) >> 4) | ((byte & 0x0F) << 4);
-    byte = ((byte & 0xCC) >> 2) | ((byte & 0x33) << 2);
-    byte = ((byte & 0xAA) >> 1) | ((byte & 0x55) << 1);
-    return byte;
+    recorder = new_recorder;
 }
 
-// Draw a single character at a specific position with color
-void ili9341_draw_char(uint16_t x, uint16_t y, char c, uint8_t scale, uint8_t r, uint8_t g, uint8_t b)
+// Fill <char_width> pixels of <line> with one row of a glyph
+// Rows are stored in drawing order, the first pixel in the top bit
+static void compose_glyph_row(uint8_t *line, uint8_t bits, uint8_t width, uint16_t char_width, uint8_t scale,
+                              const uint8_t *foreground, const uint8_t *background)
 {
-    if ((unsigned char)c > 127)
-        return; // Ensure character is valid
+    for (uint16_t col = 0; col < char_width; col++)
+    {
+        uint8_t bit = col / scale;
+        const uint8_t *pixel = (bit < width && (bits & (0x80 >> bit))) ? foreground : background;
+        line[col * 2] = pixel[0];
+        line[col * 2 + 1] = pixel[1];
+    }
+}
 
-    const uint8_t *bitmap = font8x8_basic[(unsigned char)c];
+uint16_t ili9341_draw_glyph(uint16_t x, uint16_t y, char c, const tft_font_t *font, uint8_t scale, uint8_t r, uint8_t g, uint8_t b)
+{
+    uint8_t width;
+    const uint8_t *bitmap = tft_font_glyph(font, c, &width);
 
-    uint16_t char_width = 8 * scale;
-    uint16_t char_height = 8 * scale;
+    uint16_t char_width = (width + font->spacing) * scale;
+    uint16_t char_height = font->height * scale;
 
-    // Clear the character background (white)
+    // One window for the whole cell, sent a pixel row at a time with the
+    // background (white) and the glyph together
+    static uint8_t line[TFT_WIDTH * 2];
+    if (char_width > TFT_WIDTH)
+    {
+        return char_width;
+    }
     set_address_window(x, y, char_width, char_height);
-    uint8_t background_pixel[3] = {0xFF, 0xFF, 0xFF}; // White pixel
-    for (uint16_t i = 0; i < char_width * char_height; i++)
+
+    uint8_t background[2];
+    uint8_t foreground[2];
+    pack_pixel(background, 0xFF, 0xFF, 0xFF);
+    pack_pixel(foreground, r, g, b);
+
+    for (uint8_t row = 0; row < font->height; row++)
+    {
+        compose_glyph_row(line, bitmap[row], width, char_width, scale, foreground, background);
+        for (uint8_t i = 0; i < scale; i++)
+        {
+            send_data(line, char_width * 2);
+        }
+    }
+
+    if (recorder)
     {
-        send_data(background_pixel, 3);
+        recorder->glyph(x, y, char_width, c, font, scale, r, g, b);
     }
+    return char_width;
+}
 
-    // Draw the character with the specified color
-    for (uint8_t row = 0; row < 8; row++)
+uint16_t ili9341_draw_run(uint16_t x, uint16_t y, const char *chars, uint8_t count, const tft_font_t *font, uint8_t scale, uint8_t r, uint8_t g, uint8_t b)
+{
+    const uint8_t *bitmaps[MAX_RUN_GLYPHS];
+    uint8_t widths[MAX_RUN_GLYPHS];
+    uint16_t run_width = 0;
+    for (uint8_t i = 0; i < count && i < MAX_RUN_GLYPHS; i++)
     {
-        uint8_t reversed_row = reverse_bits(bitmap[row]); // Reverse the bits for correct rendering
+        bitmaps[i] = tft_font_glyph(font, chars[i], &widths[i]);
+        run_width += (widths[i] + font->spacing) * scale;
+    }
 
-        for (uint8_t col = 0; col < 8; col++)
+    // Too long for one window, fall back to a window per glyph
+    if (count > MAX_RUN_GLYPHS || run_width > TFT_WIDTH)
+    {
+        uint16_t start = x;
+        for (uint8_t i = 0; i < count; i++)
         {
-            if ((reversed_row >> (7 - col)) & 0x1)
-            {
-                set_address_window(x + col * scale, y + row * scale, scale, scale);
-                uint8_t foreground_pixel[3] = {r, g, b}; // Custom color pixel
-                for (uint16_t i = 0; i < scale * scale; i++)
-                {
-                    send_data(foreground_pixel, 3);
-                }
-            }
+            x += ili9341_draw_glyph(x, y, chars[i], font, scale, r, g, b);
+        }
+        return x - start;
+    }
+
+    static uint8_t line[TFT_WIDTH * 2];
+    set_address_window(x, y, run_width, font->height * scale);
+
+    uint8_t background[2];
+    uint8_t foreground[2];
+    pack_pixel(background, 0xFF, 0xFF, 0xFF);
+    pack_pixel(foreground, r, g, b);
+
+    for (uint8_t row = 0; row < font->height; row++)
+    {
+        uint16_t offset = 0;
+        for (uint8_t i = 0; i < count; i++)
+        {
+            uint16_t char_width = (widths[i] + font->spacing) * scale;
+            compose_glyph_row(&line[offset * 2], bitmaps[i][row], widths[i], char_width, scale, foreground, background);
+            offset += char_width;
+        }
+        for (uint8_t i = 0; i < scale; i++)
+        {
+            send_data(line, run_width * 2);
         }
     }
+    return run_width;
 }
 
 void ili9341_draw_string(uint16_t x, uint16_t y, const char *str, uint8_t scale, uint8_t r, uint8_t g, uint8_t b)
 {
+    ili9341_draw_text(x, y, str, &font_8x8, scale, r, g, b);
+}
 
+uint16_t ili9341_draw_text(uint16_t x, uint16_t y, const char *str, const tft_font_t *font, uint8_t scale, uint8_t r, uint8_t g, uint8_t b)
+{
     size_t len = 0;
     while (str[len] != '\0')
     {
         len++;
     }
+
+    // The panel is mirrored, so the last character goes leftmost in memory
+    uint16_t start = x;
     for (size_t i = 0; i < len; i++)
     {
-        ili9341_draw_char(x, y, str[len - 1 - i], scale, r, g, b);
-        x += 8 * scale;
+        x += ili9341_draw_glyph(x, y, str[len - 1 - i], font, scale, r, g, b);
     }
+    return x - start;
 }
 
 // Function to draw a circle
 void draw_circle(uint16_t x, uint16_t y, uint16_t radius, uint8_t r, uint8_t g, uint8_t b)
 {
+    // One horizontal span per row
     for (int16_t dy = -radius; dy <= radius; dy++)
     {
-        for (int16_t dx = -radius; dx <= radius; dx++)
+        int16_t dx = radius;
+        while (dx * dx + dy * dy > radius * radius)
         {
-            if (dx * dx + dy * dy <= radius * radius)
-            {
-                set_address_window(x + dx, y + dy, 1, 1);
-                uint8_t pixel_color[3] = {r, g, b}; // Custom color
-                send_data(pixel_color, 3);
-            }
+            dx--;
+        }
+        set_address_window(x - dx, y + dy, 2 * dx + 1, 1);
+        send_pixels(r, g, b, 2 * dx + 1);
+
+        if (recorder)
+        {
+            recorder->fill(x - dx, y + dy, 2 * dx + 1, 1, r, g, b);
         }
     }
 }
@@ -270,38 +573,58 @@ void draw_circle(uint16_t x, uint16_t y, uint16_t radius, uint8_t r, uint8_t g,
 void draw_rectangle(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint8_t r, uint8_t g, uint8_t b)
 {
     set_address_window(x, y, w, h);
-    uint8_t pixel_color[3] = {r, g, b}; // Custom color
-    for (uint32_t i = 0; i < w * h; i++)
+    send_pixels(r, g, b, (uint32_t)w * h);
+
+    if (recorder)
     {
-        send_data(pixel_color, 3);
+        recorder->fill(x, y, w, h, r, g, b);
     }
 }
 
+// Record with its label and spindle hole, <x>,<y> is its centre
 void draw_vinyl_icon(uint16_t x, uint16_t y)
 {
-    // Calculate position to be in the bottom-right corner
-    uint16_t center_x = 35;
-    uint16_t center_y = TFT_HEIGHT - 30;
-
     // Outer circle (black)
-    draw_circle(center_x, center_y, 20, 0x00, 0x00, 0x00);
+    draw_circle(x, y, 20, 0x00, 0x00, 0x00);
     // Inner circle (white)
-    draw_circle(center_x, center_y, 10, 0x80, 0x80, 0x80);
-    draw_circle(center_x, center_y, 5, 0xFF, 0xFF, 0xFF);
+    draw_circle(x, y, 10, 0x80, 0x80, 0x80);
+    draw_circle(x, y, 5, 0xFF, 0xFF, 0xFF);
 }
 
+// Tape with two reels, <x>,<y> is its corner
 void draw_vhs_icon(uint16_t x, uint16_t y)
 {
-    // Calculate position to be in the bottom-right corner
-    uint16_t rect_x = 20;
-    uint16_t rect_y = TFT_HEIGHT - 40;
-
     // Outer rectangle (black)
-    draw_rectangle(rect_x, rect_y, 60, 25, 0x00, 0x00, 0x00);
+    draw_rectangle(x, y, 60, 25, 0x00, 0x00, 0x00);
 
     // Left reel (white circle)
-    draw_circle(rect_x + 15, rect_y + 12.5, 6, 0xFF, 0xFF, 0xFF);
+    draw_circle(x + 15, y + 12, 6, 0xFF, 0xFF, 0xFF);
 
     // Right reel (white circle)
-    draw_circle(rect_x + 45, rect_y + 12.5, 6, 0xFF, 0xFF, 0xFF);
-}
\ No newline at end of file
+    draw_circle(x + 45, y + 12, 6, 0xFF, 0xFF, 0xFF);
+}
+
+// Cassette shell with two reels and the tape window, <x>,<y> is its corner
+void draw_cassette_icon(uint16_t x, uint16_t y)
+{
+    draw_rectangle(x, y, 56, 34, 0x00, 0x00, 0x00);
+    draw_rectangle(x + 8, y + 8, 40, 14, 0x80, 0x80, 0x80);
+    draw_circle(x + 18, y + 15, 4, 0xFF, 0xFF, 0xFF);
+    draw_circle(x + 38, y + 15, 4, 0xFF, 0xFF, 0xFF);
+}
+
+// Disc with its hub, <x>,<y> is its centre
+void draw_cd_icon(uint16_t x, uint16_t y)
+{
+    draw_circle(x, y, 20, 0xC0, 0xC0, 0xC0);
+    draw_circle(x, y, 7, 0x80, 0x80, 0x80);
+    draw_circle(x, y, 3, 0xFF, 0xFF, 0xFF);
+}
+
+// Game cartridge with a label and contacts, <x>,<y> is its corner
+void draw_cartridge_icon(uint16_t x, uint16_t y)
+{
+    draw_rectangle(x, y, 40, 36, 0x40, 0x40, 0x40);
+    draw_rectangle(x + 6, y + 4, 28, 18, 0xFF, 0xFF, 0xFF);
+    draw_rectangle(x + 8, y + 28, 24, 8, 0xD4, 0xAF, 0x37);
+}
@@ -1,85 +1,121 @@
 #include <stdio.h>
 #include "nrf_drv_twi.h"
 #include "nrf_twi_mngr.h"
+#include "i2c_bus.h"
+#include "bus_discovery.h"
+#include "boot_profile.h"
 #include "rfid_driver.h"
+#include "rfid_scheduler.h"
 #include "ili9341.h"
 #include "nrf_delay.h"
-#include "app_timer.h"
 #include "microbit_v2.h"
-#include "nrf_drv_saadc.h"
-
-#define POLLING_INTERVAL APP_TIMER_TICKS(500)
-#define ABBEY_ROAD "3A006C84D200"
-#define PULP_FICTION "3A006C762F0F"
-#define IN_RAINBOWS "00000015C9DC"
-
-#define MAX_TAGS 10
+#include "weight_sensor.h"
+#include "weight_monitor.h"
+#include "nrfx_gpiote.h"
+#include "nrf_gpio.h"
+#include "app_util_platform.h"
+#include "tickless_timer.h"
+#include "event_queue.h"
+#include "led_matrix.h"
+#include "marquee.h"
+#include "catalog.h"
+#include "screen_template.h"
+#include "display_list.h"
+#include "scan_history.h"
+#include "tag_presence.h"
+#include "scan_journal.h"
+#include "scan_trace.h"
+#include "capacitive_touch.h"
+#include "touch_slider.h"
+
+#define POLLING_INTERVAL_US 500000 // Every reader is read once per interval
+#define WEIGHT_INTERVAL_US 500000  // Weight polls until the monitor takes over
+#define RFID_BURST_ROTATIONS 5     // Fast reads of every reader once something is placed
+#define RFID_BURST_CYCLE_US 100000
+#define TFT_BRIGHTNESS_FULL 0xFF
+#define TFT_BRIGHTNESS_DIM 0x10
+// Load switch in the reader's supply. Leave undefined when the reader is
+// powered straight from the Qwiic connector
+// #define RFID_POWER_PIN EDGE_P16
+#define RFID_POWER_ON_US 50000 // Reader boot time after power is applied
+#define CLOCK_REPORT_INTERVAL_US 60000000
+#define MARQUEE_STEP_US 120000
+#define BUTTON_DEBOUNCE_TICKS (TICKLESS_TICK_HZ / 5) // 200 ms
+#define CALIBRATE_HOLD_US 3000000 // Holding button A this long calibrates the weight
+#define WEIGHT_CAL_REFERENCE_CENTI_OZ 1600 // Known weight placed to calibrate, 1 lb
+#define TOUCH_HOLD_US 600000 // Holding the logo this long browses back instead
+#define TOUCH_SCAN_INTERVAL_US 50000 // Touch pads measured 20 times a second
+#define TOUCH_BURST_ROUNDS 1
+#define TOUCH_LOGO_PAD 0
+#define SLIDER_FIRST_PAD 1 // Edge P1 and P2, P0 carries the FSR
+#define SLIDER_PADS 2
+#define WEIGHT_SETTLE_UPDATES 4 // Steady polls before the weight monitor takes over
+#define WEIGHT_SETTLE_COUNTS 10 // Raw change still counted as steady
+#define RFID_CONFIRM_READS 3    // Frames that must agree before a tag is accepted
+#define TAG_ARRIVE_HOLD_MS 0    // A tag counts from its first good read
+#define TAG_REMOVE_HOLD_MS 2000 // Four polls without it before it is gone
+#define MS_TO_TICKS(ms) ((uint32_t)((uint64_t)(ms) * TICKLESS_TICK_HZ / 1000))
 #define TFT_WIDTH 240
 #define TFT_HEIGHT 320
 
-typedef struct
-{
-    const char *tag_id; // RFID tag ID
-    const char *type;   // Object type (e.g., "Vinyl", "VHS")
-    const char *person; // Director or Artist
-    const char *title;  // Title
-    const char *field1; // Field 1 (e.g., song/actor)
-    const char *field2; // Field 2
-    const char *field3; // Field 3
-    const char *genre;  // Genre
-    const char *year;   // Year
-    const char *weight; // Weight
-} tag_info_t;
-
-#define MAX_TAGS 10
-
-static tag_info_t tag_info_table[MAX_TAGS] = {
-    {"3A006C84D200", "Vinyl", "Travis Scott", "Utopia", "Meltdown", "Thank God", "Fein", "Rap", "2023", "5"},
-    {"3A006C762F0F", "VHS", "Sonnenfeld", "Men in Black", "Will Smith", "Tommy Lee Jones", "Rip Torn", "Sci-Fi", "1997", "10"},
-    {"00000015C9DC", "Vinyl", "Radiohead", "In Rainbows", "All I Need", "Weird Fishes", "Videotape Garden", "Rock", "2007", "5"},
-    // Add more entries as needed
-};
-static const size_t tag_info_count = sizeof(tag_info_table) / sizeof(tag_info_table[0]);
-
-// TWI Manager instance
+// TWI Manager instance and the Qwiic bus built on it
 NRF_TWI_MNGR_DEF(m_twi_mngr, 1, 0);
-APP_TIMER_DEF(rfid_timer);
+static i2c_bus_t qwiic_bus;
 
 static char last_displayed_tag[13] = "";
-static bool is_displaying_tag = false;
+static const catalog_entry_t *displayed_entry = NULL; // NULL when no tag is shown
+static rfid_reader_t readers[RFID_MAX_READERS];
+static tag_presence_t presence[RFID_MAX_READERS];
+static char pending_tags[RFID_MAX_READERS][13]; // Tags waiting for display_tag_event
+static char removed_tags[RFID_MAX_READERS][13]; // Tags waiting for tag_removed_event
+static uint32_t marquee_timer = 0;  // Scrolls the title while the TFT is off
+static uint32_t weight_timer = 0;   // Polls the weight until it settles
+static uint32_t touch_hold_timer = 0;
+static uint32_t touch_scan_timer = 0; // Starts a burst of touch rounds
+static volatile uint8_t touch_rounds_left = 0; // Rounds until TIMER0 stops, for the clock report
+static uint32_t calibrate_timer = 0;
+static touch_slider_t slider;
+static const uint32_t touch_pins[] = {TOUCH_LOGO, TOUCH_RING1, TOUCH_RING2};
+static int8_t browse_index = -1;    // Catalog entry last browsed to with the logo
+static int32_t shown_ounces = 0;    // Weight on the plate after hysteresis
+static bool weight_stale = false;   // Screen was redrawn without the weight
+static int32_t settle_raw = 0;
+static uint8_t settle_count = 0;
+
+// Pad gate: the RFID readers only run while the weight says something is on
+// the pad
+static bool pad_occupied = false;
+static uint32_t occupied_since = 0;
+static uint32_t gate_fills = 0;
+static uint32_t gate_occupied_ticks = 0;
+static uint32_t gate_stats_start = 0;
 
 // Function prototypes
-void rfid_timer_callback(void *context);
-void process_rfid_tag(const char *tag_id);
-
-// SAADC callback (empty)
-void saadc_callback(nrf_drv_saadc_evt_t const *p_event) {}
-
-void saadc_init(void)
-{
-    nrf_drv_saadc_config_t saadc_config = NRF_DRV_SAADC_DEFAULT_CONFIG;
-    saadc_config.resolution = NRF_SAADC_RESOLUTION_12BIT;
-    nrf_drv_saadc_init(&saadc_config, saadc_callback);
-
-    nrf_saadc_channel_config_t channel_config = NRF_DRV_SAADC_DEFAULT_CHANNEL_CONFIG_SE(NRF_SAADC_INPUT_AIN0);
-    nrf_drv_saadc_channel_init(0, &channel_config);
-}
-
-float read_fsr_weight(void)
-{
-    nrf_saadc_value_t saadc_value;
-    ret_code_t err_code = nrf_drv_saadc_sample_convert(0, &saadc_value);
-    APP_ERROR_CHECK(err_code);
-
-    // Convert SAADC value to weight in ounces
-    float weight = (float)saadc_value * 0.01 + 2;
-
-    if (weight < 2.9)
-    {
-        return 0;
-    }
-    return weight;
-}
+void clock_report_callback(void *context);
+void rfid_scan_callback(uint8_t index, rfid_reader_t *reader, const rfid_data_t *tag_data);
+void display_tag_event(void *context);
+void journal_flush_event(void *context);
+void tag_removed_event(void *context);
+void weight_event(void *context);
+void report_event(void *context);
+void marquee_timer_callback(void *context);
+void marquee_event(void *context);
+void display_toggle_event(void *context);
+void journal_export_event(void *context);
+void calibrate_event(void *context);
+void touch_pressed_event(void *context);
+void touch_released_event(void *context);
+void touch_hold_event(void *context);
+void touch_scan_event(void *context);
+void start_touch_scanning(void);
+void stop_touch_scanning(void);
+void swipe_event(void *context);
+void browse_catalog(int8_t step);
+void weight_change_event(void *context);
+void rfid_burst_event(void *context);
+void stop_title_marquee(void);
+void show_welcome_screen(void);
+void show_entry(const catalog_entry_t *entry);
 
 // Function to calculate the center-aligned X coordinate
 uint16_t calculate_center_aligned_x(const char *text, uint8_t scale)
@@ -116,7 +152,7 @@ uint16_t calculate_right_aligned_x(const char *text, uint8_t scale)
 void display_header(const char *header)
 {
     uint16_t x = calculate_center_aligned_x(header, 1);
-    ili9341_draw_string(x, 20, header, 1, 0xFF, 0x00, 0x00);
+    ili9341_draw_string(x, 40, header, 1, 0xFF, 0x00, 0x00);
 }
 
 void display_weight(float weight)
@@ -147,202 +183,828 @@ void display_weight(float weight)
     }
 }
 
-void display_vinyl_record(const char *artist, const char *title, const char *song1, const char *song2, const char *song3, const char *genre, const char *year, const char *vinyl_weight, uint8_t r, uint8_t g, uint8_t b)
+// Runs after the scheduler read one reader, queue work only when that
+// reader's tag presence changed
+void rfid_scan_callback(uint8_t index, rfid_reader_t *reader, const rfid_data_t *tag_data)
+{
+    // Empty, corrupt and unconfirmed frames all count as no tag
+    const char *tag = tag_data->status == RFID_FRAME_OK ? tag_data->tag : NULL;
+
+    const char *previous = tag_presence_current(&presence[index]);
+    if (previous != NULL)
+    {
+        strcpy(removed_tags[index], previous);
+    }
+
+    tag_event_t event = tag_presence_update(&presence[index], tag, tickless_timer_now());
+    if (event == TAG_EVENT_ARRIVED || event == TAG_EVENT_SWAPPED)
+    {
+        printf("%s: tag %s: %s, Timestamp: %lu ms\n", reader->device.name, tag_event_name(event), tag, tag_data->time);
+        strcpy(pending_tags[index], tag);
+        scan_trace_keep(pending_tags[index]);
+        if (scan_journal_append(tag, index, tag_data->time, tickless_timer_now(), weight_sensor_centi_oz()))
+        {
+            event_post(EVENT_PRIORITY_LOW, journal_flush_event, NULL);
+        }
+        event_post(EVENT_PRIORITY_NORMAL, display_tag_event, pending_tags[index]);
+    }
+    else if (event == TAG_EVENT_REMOVED)
+    {
+        printf("%s: tag removed\n", reader->device.name);
+        event_post(EVENT_PRIORITY_NORMAL, tag_removed_event, removed_tags[index]);
+    }
+
+    // Nothing to clear from the reader's buffer after an empty read
+    if (tag != NULL)
+    {
+        rfid_reader_clear_tags(reader);
+    }
+}
+
+// A full batch of scans goes to flash once the reads and the screen are done
+void journal_flush_event(void *context)
+{
+    scan_journal_flush();
+}
+
+void display_tag_event(void *context)
+{
+    const char *tag_id = (const char *)context;
+    scan_trace_render_begin(context);
+    scan_trace_mark(SCAN_STAGE_LOOKUP_START);
+    const catalog_entry_t *entry = catalog_find(tag_id);
+    scan_trace_mark(SCAN_STAGE_LOOKUP_END);
+    if (entry)
+    {
+        scan_history_add(entry->title);
+    }
+    else
+    {
+        char line[24];
+        snprintf(line, sizeof(line), "Unknown %s", tag_id);
+        scan_history_add(line);
+    }
+
+    show_entry(entry);
+    scan_trace_end();
+}
+
+// An item was taken off a reader. If it is the one on screen, go back to the
+// welcome screen
+void tag_removed_event(void *context)
 {
-    ili9341_fill_screen(r, g, b);
-    ili9341_fill_screen(0xFF, 0xFF, 0xFF);
+    const char *tag_id = (const char *)context;
+    if (strcmp(tag_id, last_displayed_tag) != 0)
+    {
+        return;
+    }
 
-    // Display the header in blue
-    display_header("Record Info");
+    displayed_entry = NULL;
+    last_displayed_tag[0] = '\0';
+    stop_title_marquee();
+    if (ili9341_is_display_on())
+    {
+        show_welcome_screen();
+    }
+}
 
-    char buffer[64];
+// Whether the plate reading has held still for WEIGHT_SETTLE_UPDATES polls
+bool weight_settled(void)
+{
+    int32_t raw = weight_sensor_raw();
+    int32_t change = raw - settle_raw;
+    settle_raw = raw;
+    if (change > WEIGHT_SETTLE_COUNTS || change < -WEIGHT_SETTLE_COUNTS)
+    {
+        settle_count = 0;
+        return false;
+    }
+    return ++settle_count >= WEIGHT_SETTLE_UPDATES;
+}
+
+void weight_timer_callback(void *context)
+{
+    event_post(EVENT_PRIORITY_LOW, weight_event, NULL);
+}
 
-    // Display Artist
-    snprintf(buffer, sizeof(buffer), "Artist: %s", artist);
-    uint16_t x = calculate_right_aligned_x(buffer, 1);
-    ili9341_draw_string(x, 60, buffer, 1, 0x00, 0x00, 0x00); // Black color
+void start_weight_polling(void)
+{
+    if (weight_timer == 0)
+    {
+        weight_timer = tickless_timer_start(WEIGHT_INTERVAL_US, true, TICKLESS_COARSE, weight_timer_callback, NULL);
+    }
+}
 
-    // Display Title
-    snprintf(buffer, sizeof(buffer), "Title: %s", title);
-    x = calculate_right_aligned_x(buffer, 1);
-    ili9341_draw_string(x, 90, buffer, 1, 0x00, 0x00, 0x00);
+void stop_weight_polling(void)
+{
+    if (weight_timer != 0)
+    {
+        tickless_timer_cancel(weight_timer);
+        weight_timer = 0;
+    }
+}
 
-    // Display Songs
-    snprintf(buffer, sizeof(buffer), "Song: %s", song1);
-    x = calculate_right_aligned_x(buffer, 1);
-    ili9341_draw_string(x, 120, buffer, 1, 0x00, 0x00, 0x00);
+void rfid_power(bool on)
+{
+#ifdef RFID_POWER_PIN
+    if (on)
+    {
+        nrf_gpio_pin_set(RFID_POWER_PIN);
+    }
+    else
+    {
+        nrf_gpio_pin_clear(RFID_POWER_PIN);
+    }
+#endif
+}
 
-    snprintf(buffer, sizeof(buffer), "Song: %s", song2);
-    x = calculate_right_aligned_x(buffer, 1);
-    ili9341_draw_string(x, 150, buffer, 1, 0x00, 0x00, 0x00);
+void rfid_power_timer_callback(void *context)
+{
+    event_post(EVENT_PRIORITY_HIGH, rfid_burst_event, NULL);
+}
 
-    snprintf(buffer, sizeof(buffer), "Song: %s", song3);
-    x = calculate_right_aligned_x(buffer, 1);
-    ili9341_draw_string(x, 180, buffer, 1, 0x00, 0x00, 0x00);
+// Read every reader quickly so the tag shows up right after the item lands,
+// then carry on at the normal polling interval
+void rfid_burst_event(void *context)
+{
+    if (pad_occupied)
+    {
+        rfid_scheduler_burst(RFID_BURST_ROTATIONS, RFID_BURST_CYCLE_US);
+    }
+}
 
-    // Display Genre
-    snprintf(buffer, sizeof(buffer), "Genre: %s", genre);
-    x = calculate_right_aligned_x(buffer, 1);
-    ili9341_draw_string(x, 210, buffer, 1, 0x00, 0x00, 0x00);
+// Something heavier than the empty pad arrived: power the reader and scan
+void pad_filled(void)
+{
+    pad_occupied = true;
+    occupied_since = tickless_timer_now();
+    gate_fills++;
+    printf("Pad occupied, scanning\n");
+
+    ili9341_set_brightness(TFT_BRIGHTNESS_FULL);
+    rfid_power(true);
+#ifdef RFID_POWER_PIN
+    tickless_timer_start(RFID_POWER_ON_US, false, TICKLESS_COARSE, rfid_power_timer_callback, NULL);
+#else
+    rfid_burst_event(NULL);
+#endif
+}
 
-    // Display Year
-    snprintf(buffer, sizeof(buffer), "Year: %s", year);
-    x = calculate_right_aligned_x(buffer, 1);
-    ili9341_draw_string(x, 240, buffer, 1, 0x00, 0x00, 0x00);
+// The pad is empty again: whatever was on it is gone, no need to wait for the
+// remove hold on a reader that is about to stop
+void pad_emptied(void)
+{
+    pad_occupied = false;
+    gate_occupied_ticks += tickless_timer_now() - occupied_since;
+    printf("Pad empty, scanning stopped\n");
 
-    // Draw vinyl icon in the bottom right
-    draw_vinyl_icon(TFT_WIDTH - 30, TFT_HEIGHT - 30);
+    rfid_scheduler_stop();
+    for (uint8_t i = 0; i < rfid_scheduler_count(); i++)
+    {
+        const char *tag = tag_presence_current(&presence[i]);
+        if (tag != NULL)
+        {
+            strcpy(removed_tags[i], tag);
+            tag_presence_clear(&presence[i]);
+            event_post(EVENT_PRIORITY_NORMAL, tag_removed_event, removed_tags[i]);
+        }
+    }
+    rfid_power(false);
+    ili9341_set_brightness(TFT_BRIGHTNESS_DIM);
 }
 
-void display_vhs_movie(const char *director, const char *title, const char *actor1, const char *actor2, const char *actor3, const char *genre, const char *year, const char *vhs_weight)
+// Read the weight, and draw it only when it changed or the screen was redrawn
+// Once it stops changing the SAADC limit monitor watches the plate instead
+// The weight also gates the RFID readers, they only run while it is above the
+// empty pad
+void weight_event(void *context)
 {
-    ili9341_fill_screen(0x00, 0x00, 0xFF);
-    ili9341_fill_screen(0xFF, 0xFF, 0xFF);
+    if (!weight_monitor_active())
+    {
+        if (weight_sensor_update(&shown_ounces))
+        {
+            weight_stale = true;
+        }
+        if (weight_settled())
+        {
+            settle_count = 0;
+            stop_weight_polling();
+            weight_monitor_start(settle_raw);
+        }
+    }
 
-    // Display the header in blue
-    display_header("VHS Info");
+    bool occupied = shown_ounces > 0;
+    if (occupied && !pad_occupied)
+    {
+        pad_filled();
+    }
+    else if (!occupied && pad_occupied)
+    {
+        pad_emptied();
+    }
 
-    char buffer[64];
+    if (weight_stale && ili9341_is_display_on() && shown_ounces > 0)
+    {
+        display_weight(shown_ounces);
+        weight_stale = false;
+    }
+}
 
-    // Display Director
-    snprintf(buffer, sizeof(buffer), "Director: %s", director);
-    uint16_t x = calculate_right_aligned_x(buffer, 1);
-    ili9341_draw_string(x, 60, buffer, 1, 0x00, 0x00, 0x00); // Black color
+// Runs from the EGU interrupt when the reading leaves the monitor's window
+void weight_monitor_callback(bool placed)
+{
+    event_post(EVENT_PRIORITY_HIGH, weight_change_event, (void *)(placed ? "placed" : "lifted"));
+}
 
-    // Display Title
-    snprintf(buffer, sizeof(buffer), "Title: %s", title);
-    x = calculate_right_aligned_x(buffer, 1);
-    ili9341_draw_string(x, 90, buffer, 1, 0x00, 0x00, 0x00);
+// Something was placed or lifted: sample the weight again, which starts or
+// stops the readers, and wake the TFT
+void weight_change_event(void *context)
+{
+    printf("Weight: item %s\n", (const char *)context);
+    weight_monitor_stop();
+    settle_count = 0;
+    start_weight_polling();
+    event_post(EVENT_PRIORITY_LOW, weight_event, NULL);
 
-    // Display Actors
-    snprintf(buffer, sizeof(buffer), "Actor: %s", actor1);
-    x = calculate_right_aligned_x(buffer, 1);
-    ili9341_draw_string(x, 120, buffer, 1, 0x00, 0x00, 0x00);
+    if (!ili9341_is_display_on())
+    {
+        ili9341_set_display_on(true);
+        stop_title_marquee();
+        start_touch_scanning();
+        if (displayed_entry)
+        {
+            show_entry(displayed_entry);
+        }
+    }
+}
 
-    snprintf(buffer, sizeof(buffer), "Actor: %s", actor2);
-    x = calculate_right_aligned_x(buffer, 1);
-    ili9341_draw_string(x, 150, buffer, 1, 0x00, 0x00, 0x00);
+// How long the pad was occupied and how many reads the gate saved
+void print_gate_stats(void)
+{
+    uint32_t now = tickless_timer_now();
+    uint32_t elapsed = now - gate_stats_start;
+    uint32_t occupied = gate_occupied_ticks;
+    if (pad_occupied)
+    {
+        occupied += now - occupied_since;
+        occupied_since = now;
+    }
+    if (elapsed == 0)
+    {
+        return;
+    }
 
-    snprintf(buffer, sizeof(buffer), "Actor: %s", actor3);
-    x = calculate_right_aligned_x(buffer, 1);
-    ili9341_draw_string(x, 180, buffer, 1, 0x00, 0x00, 0x00);
+    // Without the gate every reader is read once per polling interval
+    uint64_t idle_us = (uint64_t)(elapsed - occupied) * 1000000 / TICKLESS_TICK_HZ;
+    uint32_t skipped = (uint32_t)(idle_us / POLLING_INTERVAL_US) * rfid_scheduler_count();
+    printf("Pad gate: %lu fills, occupied %lu%% of %lu s, %lu reads skipped, readers %s\n", gate_fills,
+           (uint32_t)((uint64_t)occupied * 100 / elapsed), elapsed / TICKLESS_TICK_HZ, skipped,
+           rfid_scheduler_running() ? "on" : "off");
 
-    // Display Genre
-    snprintf(buffer, sizeof(buffer), "Genre: %s", genre);
-    x = calculate_right_aligned_x(buffer, 1);
-    ili9341_draw_string(x, 210, buffer, 1, 0x00, 0x00, 0x00);
+    gate_fills = 0;
+    gate_occupied_ticks = 0;
+    gate_stats_start = now;
+}
 
-    // Display Year
-    snprintf(buffer, sizeof(buffer), "Year: %s", year);
-    x = calculate_right_aligned_x(buffer, 1);
-    ili9341_draw_string(x, 240, buffer, 1, 0x00, 0x00, 0x00);
+void report_event(void *context)
+{
+    tickless_timer_print_report();
+    event_queue_print_stats();
+    i2c_bus_print_stats(&qwiic_bus);
+    for (uint8_t i = 0; i < rfid_scheduler_count(); i++)
+    {
+        rfid_reader_print_stats(&readers[i]);
+        tag_presence_print_stats(&presence[i]);
+    }
+    rfid_scheduler_print_stats();
+    print_gate_stats();
+    marquee_print_stats();
+    weight_sensor_print_stats();
+    weight_monitor_print_stats();
+    screen_template_print_stats();
+    display_list_print_stats();
+    tft_font_print_stats();
+    scan_history_print_stats();
+    scan_journal_print_stats();
+    scan_trace_dump();
+    capacitive_touch_print_stats();
+}
 
-    // Draw VHS icon in the bottom right
-    draw_vhs_icon(TFT_WIDTH - 40, TFT_HEIGHT - 20);
+void clock_report_callback(void *context)
+{
+    event_post(EVENT_PRIORITY_LOW, report_event, NULL);
 }
 
-void rfid_timer_callback(void *context)
+void marquee_timer_callback(void *context)
 {
-    rfid_data_t tag_data;
+    event_post(EVENT_PRIORITY_NORMAL, marquee_event, NULL);
+}
 
-    tag_data = rfid_read_tag(&m_twi_mngr);
+void marquee_event(void *context)
+{
+    marquee_step();
+}
 
-    if (strcmp(last_displayed_tag, tag_data.tag) != 0)
+// Scroll <title> across the LED matrix
+void start_title_marquee(const char *title)
+{
+    marquee_set_text(title, LED_MATRIX_MAX_BRIGHTNESS);
+    if (marquee_timer == 0)
     {
-        printf("Tag Detected: %s, Timestamp: %lu ms\n", tag_data.tag, tag_data.time);
-        strcpy(last_displayed_tag, tag_data.tag);
-        process_rfid_tag(tag_data.tag);
+        led_matrix_init();
+        tickless_timer_hf_begin(TICKLESS_HF_TIMER3);
+        marquee_timer = tickless_timer_start(MARQUEE_STEP_US, true, TICKLESS_COARSE, marquee_timer_callback, NULL);
     }
-    else if (!is_displaying_tag)
+}
+
+void stop_title_marquee(void)
+{
+    if (marquee_timer != 0)
     {
-        printf("No tag detected or read failed.\n");
+        tickless_timer_cancel(marquee_timer);
+        marquee_timer = 0;
+        marquee_clear();
+        led_matrix_stop();
+        tickless_timer_hf_end(TICKLESS_HF_TIMER3);
     }
+}
 
-    // Read and display the weight
-    float weight = read_fsr_weight();
-    if (weight > 2.9)
+// Button A exports the scan journal, and calibrates the weight when held.
+// Button B switches between the TFT and the LED matrix
+void button_handler(nrfx_gpiote_pin_t pin, nrf_gpiote_polarity_t action)
+{
+    if (pin == BTN_A)
+    {
+        event_post(EVENT_PRIORITY_LOW, journal_export_event, NULL);
+    }
+    else
     {
-        display_weight(weight);
+        event_post(EVENT_PRIORITY_NORMAL, display_toggle_event, NULL);
     }
+}
 
-    rfid_clear_tags(&m_twi_mngr);
+void calibrate_timer_callback(void *context)
+{
+    event_post(EVENT_PRIORITY_LOW, calibrate_event, NULL);
 }
 
-const tag_info_t *get_tag_info(const char *tag_id)
+void journal_export_event(void *context)
 {
-    for (size_t i = 0; i < tag_info_count; i++)
+    static uint32_t last_press = 0;
+    uint32_t now = tickless_timer_now();
+    if (now - last_press < BUTTON_DEBOUNCE_TICKS)
     {
-        if (strcmp(tag_info_table[i].tag_id, tag_id) == 0)
-        {
-            return &tag_info_table[i];
-        }
+        return;
+    }
+    last_press = now;
+
+    printf("Exporting %lu journal records\n", scan_journal_count());
+    scan_journal_export();
+
+    if (calibrate_timer == 0)
+    {
+        calibrate_timer = tickless_timer_start(CALIBRATE_HOLD_US, false, TICKLESS_COARSE, calibrate_timer_callback, NULL);
     }
-    return NULL;
 }
 
-void process_rfid_tag(const char *tag_id)
+// Button A still down after CALIBRATE_HOLD_US. With the reference weight on
+// the plate its reading becomes a calibration point, with the plate empty the
+// calibration goes back to the defaults. Both are saved to flash
+void calibrate_event(void *context)
 {
-    const tag_info_t *tag_info = get_tag_info(tag_id);
+    calibrate_timer = 0;
+    if (nrf_gpio_pin_read(BTN_A) != 0)
+    {
+        return;
+    }
 
-    if (tag_info)
+    if (shown_ounces == 0)
+    {
+        weight_sensor_reset_calibration();
+        printf("Weight: calibration reset to defaults\n");
+    }
+    else if (!weight_sensor_calibrate(WEIGHT_CAL_REFERENCE_CENTI_OZ))
     {
+        printf("Weight: calibration not saved, table full or flash busy or unavailable\n");
+    }
 
-        if (strncmp(tag_id, ABBEY_ROAD, strlen(ABBEY_ROAD)) == 0)
-        {
-            display_vinyl_record(tag_info->person, tag_info->title, tag_info->field1, tag_info->field2, tag_info->field3, tag_info->genre, tag_info->year, tag_info->weight, 0xC5, 0xFB, 0xFF);
-        }
-        else if (strncmp(tag_id, PULP_FICTION, strlen(PULP_FICTION)) == 0)
-        {
-            display_vhs_movie(tag_info->person, tag_info->title, tag_info->field1, tag_info->field2, tag_info->field3, tag_info->genre, tag_info->year, tag_info->weight);
-        }
-        else if (strncmp(tag_id, IN_RAINBOWS, strlen(IN_RAINBOWS)) == 0)
-        {
-            display_vinyl_record(tag_info->person, tag_info->title, tag_info->field1, tag_info->field2, tag_info->field3, tag_info->genre, tag_info->year, tag_info->weight, 0xF7, 0xEE, 0x49);
-        }
-        is_displaying_tag = true;
-        strcpy(last_displayed_tag, tag_id);
+    // Sample again so the display follows the new table
+    weight_monitor_stop();
+    settle_count = 0;
+    start_weight_polling();
+}
+
+// Runs from the TIMER0 interrupt once a touch or release is debounced. The
+// slider pads are handled per round instead
+void touch_handler(uint8_t pad, bool touched)
+{
+    if (pad == TOUCH_LOGO_PAD)
+    {
+        event_post(EVENT_PRIORITY_HIGH, touched ? touch_pressed_event : touch_released_event, NULL);
+    }
+}
+
+// Runs from the TIMER0 interrupt after every pad was measured
+void touch_round_handler(void)
+{
+    if (touch_rounds_left > 0 && --touch_rounds_left == 0)
+    {
+        tickless_timer_hf_end(TICKLESS_HF_TIMER0);
+    }
+    touch_gesture_t gesture = touch_slider_update(&slider, capacitive_touch_round_us());
+    if (gesture == TOUCH_GESTURE_SWIPE_FORWARD || gesture == TOUCH_GESTURE_SWIPE_BACK)
+    {
+        int8_t step = gesture == TOUCH_GESTURE_SWIPE_FORWARD ? 1 : -1;
+        event_post(EVENT_PRIORITY_HIGH, swipe_event, (void *)(intptr_t)step);
+    }
+}
+
+// A swipe along the edge pads browses the catalog like the logo does
+void swipe_event(void *context)
+{
+    browse_catalog((int8_t)(intptr_t)context);
+}
+
+void touch_scan_timer_callback(void *context)
+{
+    event_post(EVENT_PRIORITY_HIGH, touch_scan_event, NULL);
+}
+
+// Start a burst. One still running when the next is due carries on, so TIMER0
+// is only reported as started when it was idle
+static void touch_burst(void)
+{
+    CRITICAL_REGION_ENTER();
+    if (touch_rounds_left == 0)
+    {
+        tickless_timer_hf_begin(TICKLESS_HF_TIMER0);
+    }
+    touch_rounds_left = TOUCH_BURST_ROUNDS;
+    CRITICAL_REGION_EXIT();
+    capacitive_touch_burst(TOUCH_BURST_ROUNDS, TOUCH_SCAN_INTERVAL_US);
+}
+
+// TIMER0 only runs for a burst of rounds every TOUCH_SCAN_INTERVAL_US, and
+// HFCLK can stop in between like it does for the rest of the app
+void touch_scan_event(void *context)
+{
+    if (touch_scan_timer != 0)
+    {
+        touch_burst();
+    }
+}
+
+void start_touch_scanning(void)
+{
+    if (touch_scan_timer == 0)
+    {
+        touch_scan_timer = tickless_timer_start(TOUCH_SCAN_INTERVAL_US, true, TICKLESS_COARSE, touch_scan_timer_callback, NULL);
+        touch_burst();
+    }
+}
+
+void stop_touch_scanning(void)
+{
+    if (touch_scan_timer != 0)
+    {
+        tickless_timer_cancel(touch_scan_timer);
+        touch_scan_timer = 0;
+    }
+    capacitive_touch_stop();
+    CRITICAL_REGION_ENTER();
+    if (touch_rounds_left > 0)
+    {
+        touch_rounds_left = 0;
+        tickless_timer_hf_end(TICKLESS_HF_TIMER0);
+    }
+    CRITICAL_REGION_EXIT();
+}
+
+void touch_hold_timer_callback(void *context)
+{
+    event_post(EVENT_PRIORITY_HIGH, touch_hold_event, NULL);
+}
+
+// Show the catalog entry <step> away from the last one browsed to
+void browse_catalog(int8_t step)
+{
+    uint8_t count = catalog_count();
+    if (count == 0)
+    {
+        return;
+    }
+    browse_index = browse_index < 0 ? (step > 0 ? 0 : count - 1) : (browse_index + step + count) % count;
+
+    const catalog_entry_t *entry = catalog_at(browse_index);
+    printf("Browse: %s\n", entry->title);
+    show_entry(entry);
+}
+
+// A tap on the logo shows the next entry, a hold the previous one. The hold
+// is acted on when it reaches TOUCH_HOLD_US rather than on release
+void touch_pressed_event(void *context)
+{
+    if (touch_hold_timer == 0)
+    {
+        touch_hold_timer = tickless_timer_start(TOUCH_HOLD_US, false, TICKLESS_COARSE, touch_hold_timer_callback, NULL);
+    }
+}
+
+void touch_released_event(void *context)
+{
+    if (touch_hold_timer != 0)
+    {
+        tickless_timer_cancel(touch_hold_timer);
+        touch_hold_timer = 0;
+        browse_catalog(1);
+    }
+}
+
+void touch_hold_event(void *context)
+{
+    if (touch_hold_timer != 0)
+    {
+        touch_hold_timer = 0;
+        browse_catalog(-1);
+    }
+}
+
+void display_toggle_event(void *context)
+{
+    static uint32_t last_press = 0;
+    uint32_t now = tickless_timer_now();
+    if (now - last_press < BUTTON_DEBOUNCE_TICKS)
+    {
+        return;
+    }
+    last_press = now;
+
+    bool turn_on = !ili9341_is_display_on();
+    ili9341_set_display_on(turn_on);
+    printf("TFT %s\n", turn_on ? "on" : "off");
+
+    // Redraw with whichever output is now active. The logo only browses
+    // while the TFT is on, so there are no touch bursts in standby
+    if (turn_on)
+    {
+        stop_title_marquee();
+        start_touch_scanning();
     }
     else
     {
-        is_displaying_tag = false;
+        stop_touch_scanning();
+    }
+    if (displayed_entry)
+    {
+        show_entry(displayed_entry);
     }
 }
 
-int main(void)
+void button_init(void)
 {
-    printf("Starting RFID and Display.\n");
+    if (!nrfx_gpiote_is_init())
+    {
+        ret_code_t err_code = nrfx_gpiote_init();
+        APP_ERROR_CHECK(err_code);
+    }
+
+    // Low accuracy uses PORT sense, which keeps working in System ON sleep
+    // without holding a GPIOTE channel and HFCLK
+    nrfx_gpiote_in_config_t config = NRFX_GPIOTE_CONFIG_IN_SENSE_HITOLO(false);
+    config.pull = NRF_GPIO_PIN_PULLUP;
+    ret_code_t err_code = nrfx_gpiote_in_init(BTN_B, &config, button_handler);
+    APP_ERROR_CHECK(err_code);
+    nrfx_gpiote_in_event_enable(BTN_B, true);
 
+    err_code = nrfx_gpiote_in_init(BTN_A, &config, button_handler);
+    APP_ERROR_CHECK(err_code);
+    nrfx_gpiote_in_event_enable(BTN_A, true);
+}
+
+// Show a catalog <entry>, NULL for an unknown tag. Callers look the entry up
+// once, so redrawing the tag on screen skips the catalog
+void show_entry(const catalog_entry_t *entry)
+{
+    displayed_entry = entry;
+    if (entry && !ili9341_is_display_on())
+    {
+        // TFT is off, show the title on the LED matrix instead
+        start_title_marquee(entry->title);
+        strcpy(last_displayed_tag, entry->tag_id);
+    }
+    else if (entry)
+    {
+        screen_template_render(entry);
+        strcpy(last_displayed_tag, entry->tag_id);
+        weight_stale = true;
+    }
+}
+
+// Boot steps, in the order boot_run() tries them. The display goes first so
+// its reset and wake-up delays start as early as possible
+typedef enum
+{
+    BOOT_DISPLAY,
+    BOOT_TIMERS,
+    BOOT_I2C,
+    BOOT_WEIGHT,
+    BOOT_JOURNAL,
+    BOOT_RFID,
+    BOOT_SCREEN,
+    BOOT_BUTTONS,
+    BOOT_POLLING,
+    BOOT_STEP_COUNT,
+} boot_step_id_t;
+
+uint32_t boot_display(void)
+{
+    return ili9341_init_step();
+}
+
+uint32_t boot_timers(void)
+{
+    event_queue_init();
+    tickless_timer_init();
+    return BOOT_STEP_DONE;
+}
+
+// TWIM time for the clock domain report
+static void qwiic_activity_handler(bool busy)
+{
+    if (busy)
+    {
+        tickless_timer_hf_begin(TICKLESS_HF_TWIM);
+    }
+    else
+    {
+        tickless_timer_hf_end(TICKLESS_HF_TWIM);
+    }
+}
+
+uint32_t boot_i2c(void)
+{
     // Initialize TWI manager
     nrf_drv_twi_config_t twi_config = NRF_DRV_TWI_DEFAULT_CONFIG;
     twi_config.scl = I2C_QWIIC_SCL;
     twi_config.sda = I2C_QWIIC_SDA;
-    twi_config.frequency = NRF_TWIM_FREQ_100K;
+    twi_config.frequency = NRF_TWIM_FREQ_100K; // Raised once the reader has been probed
     twi_config.interrupt_priority = APP_IRQ_PRIORITY_HIGH;
 
-    ret_code_t err_code = nrf_twi_mngr_init(&m_twi_mngr, &twi_config);
+    ret_code_t err_code = i2c_bus_init(&qwiic_bus, &m_twi_mngr, &twi_config, "qwiic");
     APP_ERROR_CHECK(err_code);
-    printf("TWI Manager initialized successfully.\n");
+    i2c_bus_set_activity_handler(&qwiic_bus, qwiic_activity_handler);
 
-    saadc_init();
+#ifdef RFID_POWER_PIN
+    // Discovery needs the readers powered, the pad gate switches them off later
+    nrf_gpio_cfg_output(RFID_POWER_PIN);
+    rfid_power(true);
+#endif
 
-    // Initialize RFID
-    rfid_init(&m_twi_mngr);
-    rfid_scan_bus(&m_twi_mngr);
+    // Probe the known Qwiic addresses from the TWI interrupt
+    bus_discovery_start(&qwiic_bus);
+    return BOOT_STEP_DONE;
+}
+
+uint32_t boot_weight(void)
+{
+    static bool started = false;
+    if (!started)
+    {
+        weight_sensor_init();
+        started = true;
+    }
+
+    // The first boot formats the FDS pages before the calibration can load
+    if (!weight_sensor_ready())
+    {
+        return 1000;
+    }
+    weight_monitor_init(weight_monitor_callback);
+    return BOOT_STEP_DONE;
+}
+
+uint32_t boot_journal(void)
+{
+    scan_journal_init();
+    return BOOT_STEP_DONE;
+}
 
-    // Initialize ILI9341 display
-    ili9341_init();
-    ili9341_fill_screen(0xFF, 0xFF, 0xFF);
+uint32_t boot_rfid(void)
+{
+    if (!bus_discovery_done())
+    {
+        return 1000;
+    }
+
+    // One reader for every RFID address that answered
+    bus_discovery_finish();
+    rfid_scheduler_init(POLLING_INTERVAL_US, rfid_scan_callback);
+
+    tag_presence_config_t presence_config = {
+        .arrive_hold = MS_TO_TICKS(TAG_ARRIVE_HOLD_MS),
+        .remove_hold = MS_TO_TICKS(TAG_REMOVE_HOLD_MS),
+    };
+    for (discovery_device_t device = DISCOVERY_RFID; device <= DISCOVERY_RFID_LAST; device++)
+    {
+        if (!bus_discovery_found(device))
+        {
+            continue;
+        }
+        int index = rfid_scheduler_count();
+        rfid_reader_init(&readers[index], &qwiic_bus, bus_discovery_address(device), bus_discovery_name(device));
+        rfid_reader_set_confirm_reads(&readers[index], RFID_CONFIRM_READS);
+        tag_presence_init(&presence[index], &presence_config);
+        rfid_scheduler_add(&readers[index]);
+    }
+
+    // Nothing answered, keep polling the default address so a reader plugged
+    // in later is picked up once the bus marks it online again
+    if (rfid_scheduler_count() == 0)
+    {
+        rfid_reader_init(&readers[0], &qwiic_bus, bus_discovery_address(DISCOVERY_RFID), bus_discovery_name(DISCOVERY_RFID));
+        rfid_reader_set_confirm_reads(&readers[0], RFID_CONFIRM_READS);
+        tag_presence_init(&presence[0], &presence_config);
+        rfid_scheduler_add(&readers[0]);
+    }
+
+    // Warm boots reuse the clock chosen for this topology last time
+    nrf_drv_twi_frequency_t frequency = bus_discovery_cached_frequency();
+    if (frequency != 0)
+    {
+        i2c_bus_set_frequency(&qwiic_bus, frequency);
+    }
+    else
+    {
+        bus_discovery_save_frequency(i2c_bus_select_frequency(&qwiic_bus));
+    }
+    return BOOT_STEP_DONE;
+}
+
+// Everything below the scan history
+void show_welcome_screen(void)
+{
+    ili9341_fill_rows(SCAN_HISTORY_HEIGHT, TFT_HEIGHT - SCAN_HISTORY_HEIGHT, 0xFF, 0xFF, 0xFF);
     display_header("Welcome to RetroScan");
+}
+
+uint32_t boot_screen(void)
+{
+    scan_history_init();
+    show_welcome_screen();
+    return BOOT_STEP_DONE;
+}
+
+uint32_t boot_buttons(void)
+{
+    button_init();
+    capacitive_touch_init(touch_pins, sizeof(touch_pins) / sizeof(touch_pins[0]), touch_handler);
+    touch_slider_init(&slider, SLIDER_FIRST_PAD, SLIDER_PADS);
+    capacitive_touch_set_round_handler(touch_round_handler);
+    start_touch_scanning();
+    return BOOT_STEP_DONE;
+}
+
+uint32_t boot_polling(void)
+{
+    // The readers stay off until the weight says the pad is occupied
+    rfid_power(false);
+    ili9341_set_brightness(TFT_BRIGHTNESS_DIM);
+    gate_stats_start = tickless_timer_now();
+    start_weight_polling();
+    tickless_timer_start(CLOCK_REPORT_INTERVAL_US, true, TICKLESS_COARSE, clock_report_callback, NULL);
+    return BOOT_STEP_DONE;
+}
+
+static const boot_step_t boot_steps[BOOT_STEP_COUNT] = {
+    [BOOT_DISPLAY] = {"display", 0, boot_display},
+    [BOOT_TIMERS] = {"timers", 0, boot_timers},
+    [BOOT_I2C] = {"i2c", 0, boot_i2c},
+    [BOOT_WEIGHT] = {"weight", 0, boot_weight},
+    [BOOT_JOURNAL] = {"journal", 0, boot_journal},
+    [BOOT_RFID] = {"rfid", BOOT_DEPENDS(BOOT_I2C), boot_rfid},
+    [BOOT_SCREEN] = {"first screen", BOOT_DEPENDS(BOOT_DISPLAY), boot_screen},
+    [BOOT_BUTTONS] = {"buttons", BOOT_DEPENDS(BOOT_TIMERS) | BOOT_DEPENDS(BOOT_DISPLAY), boot_buttons},
+    [BOOT_POLLING] = {"polling", BOOT_DEPENDS(BOOT_TIMERS) | BOOT_DEPENDS(BOOT_RFID) | BOOT_DEPENDS(BOOT_SCREEN) | BOOT_DEPENDS(BOOT_WEIGHT) | BOOT_DEPENDS(BOOT_JOURNAL), boot_polling},
+};
+
+int main(void)
+{
+    boot_profile_start();
+    printf("Starting RFID and Display.\n");
 
-    // Start RFID polling timer
-    app_timer_init();
-    app_timer_create(&rfid_timer, APP_TIMER_MODE_REPEATED, rfid_timer_callback);
-    app_timer_start(rfid_timer, POLLING_INTERVAL, NULL);
+    // Independent steps overlap, I2C and weight sensor setup run during display delays
+    boot_run(boot_steps, BOOT_STEP_COUNT);
+    boot_profile_print();
+    bus_discovery_print();
 
     // Main loop
+    // Run everything the timers queued up, then sleep until the next interrupt.
+    // A page erase halts the CPU, so it waits until nothing is pending
     while (1)
     {
-        nrf_delay_ms(1000);
+        event_queue_dispatch();
+        scan_journal_prepare();
+        tickless_timer_idle();
     }
 
     return 0;
@@ -1,146 +1,199 @@
 #include "rfid_driver.h"
 #include <stdio.h>
+#include <string.h>
 #include "nrf_delay.h"
-
-// Initialize the I2C address
-uint8_t rfid_address = DEFAULT_ADDR;
-static const nrf_twi_mngr_t *i2c_manager = NULL;
+#include "scan_trace.h"
 
 // Initialize RFID by reading its version and status registers
-void rfid_init(nrf_twi_mngr_t const *twi_mngr)
+// The reader has no register map, reads stream tag data
+void rfid_reader_init(rfid_reader_t *reader, i2c_bus_t *bus, uint8_t address, const char *name)
 {
-    i2c_manager = twi_mngr;
-    rfid_write_register(SPARKFUN_RFID_ADDR, TAG_STATUS_REG, 1);
-    rfid_write_register(SPARKFUN_RFID_ADDR, STATUS_REG, 1);
+    memset(reader, 0, sizeof(*reader));
+    reader->confirm_reads = 1;
+    i2c_device_init(&reader->device, bus, address, 0, NULL, 0, name);
+
+    // Tag reads should not wait behind other traffic on the bus
+    reader->device.priority = I2C_BUS_PRIORITY_HIGH;
+
+    i2c_device_write_reg(&reader->device, TAG_STATUS_REG, 1);
+    i2c_device_write_reg(&reader->device, STATUS_REG, 1);
 }
 
-// Scan I2C bus for devices
-void rfid_scan_bus(nrf_twi_mngr_t const *twi_mngr)
+static const char *status_names[RFID_FRAME_STATUS_COUNT] = {
+    [RFID_FRAME_OK] = "ok",
+    [RFID_FRAME_EMPTY] = "empty",
+    [RFID_FRAME_BUS_ERROR] = "bus error",
+    [RFID_FRAME_FLOATING] = "floating",
+    [RFID_FRAME_CHECKSUM] = "checksum",
+    [RFID_FRAME_NO_MAJORITY] = "no majority",
+};
+
+rfid_frame_status_t rfid_check_frame(const uint8_t *frame)
 {
-    printf("\nScanning I2C bus for devices...\n");
-    printf("   0  1  2  3  4  5  6  7  8  9  A  B  C  D  E  F\n");
+    // A zero ID passes the XOR check whatever the timestamp holds, so a
+    // partial frame with only timestamp bytes set is empty too
+    bool empty_id = true;
+    bool all_ones = true;
+    for (int i = 0; i < TAG_AND_TIME_REQUEST; i++)
+    {
+        if (i <= TAG_CHECKSUM_BYTE)
+        {
+            empty_id &= frame[i] == 0x00;
+        }
+        all_ones &= frame[i] == 0xFF;
+    }
+    if (empty_id)
+    {
+        return RFID_FRAME_EMPTY;
+    }
+    if (all_ones)
+    {
+        return RFID_FRAME_FLOATING;
+    }
 
-    uint8_t dummy_data = 0x1;
+    uint8_t checksum = 0;
+    for (int i = 0; i < TAG_ID_BYTES; i++)
+    {
+        checksum ^= frame[i];
+    }
+    return checksum == frame[TAG_CHECKSUM_BYTE] ? RFID_FRAME_OK : RFID_FRAME_CHECKSUM;
+}
 
-    for (uint8_t address = 0; address < 127; address++)
+// Read one frame into <buffer> and classify it
+static rfid_frame_status_t read_frame(rfid_reader_t *reader, uint8_t *buffer)
+{
+    ret_code_t err_code = i2c_device_read(&reader->device, buffer, TAG_AND_TIME_REQUEST);
+    if (err_code != NRF_SUCCESS)
     {
-        nrf_twi_mngr_transfer_t transfer = NRF_TWI_MNGR_WRITE(address, &dummy_data, 1, 0);
-        ret_code_t err_code = nrf_twi_mngr_perform(twi_mngr, NULL, &transfer, 1, NULL);
+        // Reader offline, the bus report shows it instead of every poll
+        if (err_code != NRF_ERROR_INVALID_STATE)
+        {
+            printf("%s: failed to read tag data. Error: 0x%lX\n", reader->device.name, err_code);
+        }
+        return RFID_FRAME_BUS_ERROR;
+    }
 
-        if (err_code == NRF_SUCCESS)
+    rfid_frame_status_t status = rfid_check_frame(buffer);
+    if (status == RFID_FRAME_CHECKSUM || status == RFID_FRAME_FLOATING)
+    {
+        // Log rejected frames only, a steady empty reader stays quiet
+        printf("%s: rejected frame (%s): ", reader->device.name, status_names[status]);
+        for (int i = 0; i < TAG_AND_TIME_REQUEST; i++)
         {
-            printf(" RFID sensor located at address of %02X\n", address);
+            printf("0x%02X ", buffer[i]);
         }
+        printf("\n");
+    }
+    return status;
+}
+
+// Read <confirm_reads> frames and pick the one a majority agrees on
+// The reader keeps returning the same tag until rfid_clear_tags(), so a
+// healthy reader gives identical frames
+static rfid_frame_status_t read_confirmed(rfid_reader_t *reader, uint8_t *buffer)
+{
+    uint8_t confirm_reads = reader->confirm_reads;
+    uint8_t frames[RFID_CONFIRM_MAX][TAG_AND_TIME_REQUEST];
+    rfid_frame_status_t statuses[RFID_CONFIRM_MAX];
+    for (uint8_t i = 0; i < confirm_reads; i++)
+    {
+        statuses[i] = read_frame(reader, frames[i]);
     }
 
-    printf("\n\nScan complete!\n");
+    // Votes are on the ID bytes and status, the timestamp may tick between reads
+    for (uint8_t i = 0; i < confirm_reads; i++)
+    {
+        uint8_t votes = 0;
+        for (uint8_t j = 0; j < confirm_reads; j++)
+        {
+            if (statuses[j] == statuses[i] && memcmp(frames[j], frames[i], TAG_CHECKSUM_BYTE + 1) == 0)
+            {
+                votes++;
+            }
+        }
+        if (votes * 2 > confirm_reads)
+        {
+            memcpy(buffer, frames[i], TAG_AND_TIME_REQUEST);
+            return statuses[i];
+        }
+    }
+    return RFID_FRAME_NO_MAJORITY;
+}
+
+void rfid_reader_set_confirm_reads(rfid_reader_t *reader, uint8_t count)
+{
+    if (count < 1)
+    {
+        count = 1;
+    }
+    reader->confirm_reads = count < RFID_CONFIRM_MAX ? count : RFID_CONFIRM_MAX;
 }
 
 // Read RFID tag and return tag data structure
-rfid_data_t rfid_read_tag(nrf_twi_mngr_t const *twi_mngr)
+rfid_data_t rfid_reader_read(rfid_reader_t *reader)
 {
     rfid_data_t rfid_data = {.tag = {0}, .time = 0};
-    uint8_t request_bytes = TAG_AND_TIME_REQUEST;
     uint8_t buffer[TAG_AND_TIME_REQUEST] = {0};
 
-    // Request data from the RFID reader
-    nrf_twi_mngr_transfer_t transfer[] = {
-        NRF_TWI_MNGR_READ(rfid_address, &buffer, TAG_AND_TIME_REQUEST, 0),
-    };
-
-    ret_code_t err_code = nrf_twi_mngr_perform(i2c_manager, NULL, transfer, 1, NULL);
-    if (err_code != NRF_SUCCESS)
+    rfid_data.status = read_confirmed(reader, buffer);
+    scan_trace_mark(SCAN_STAGE_I2C_END);
+    reader->frame_counts[rfid_data.status]++;
+    if (rfid_data.status != RFID_FRAME_OK)
     {
-        printf("Failed to read tag data. Error: 0x%lX\n", err_code);
         return rfid_data;
     }
 
-    // Log raw data for debugging
-    printf("Raw RFID Reader Data: ");
-    for (int i = 0; i < TAG_AND_TIME_REQUEST; i++)
-    {
-        printf("0x%02X ", buffer[i]);
-    }
-    printf("\n");
-
     // Decode tag data as hexadecimal
-    char decoded_tag[TAG_AND_TIME_REQUEST * 2 + 1] = {0}; // Buffer for decoded hex string (+1 for null terminator)
-    for (int i = 0; i < 6; i++)
-    { // Adjust based on the tag data length
-        char hex_byte[3];
-        snprintf(hex_byte, sizeof(hex_byte), "%02X", buffer[i]);
-        strcat(decoded_tag, hex_byte);
+    for (int i = 0; i <= TAG_CHECKSUM_BYTE; i++)
+    {
+        snprintf(&rfid_data.tag[i * 2], 3, "%02X", buffer[i]);
     }
 
-    // Store the decoded tag in rfid_data structure
-    strncpy(rfid_data.tag, decoded_tag, sizeof(rfid_data.tag) - 1);
-
     // Parse the timestamp
     rfid_data.time = (buffer[6] << 24) | (buffer[7] << 16) | (buffer[8] << 8) | buffer[9];
 
-    printf("RFID Data: \n");
-    printf("  Tag: %s\n", rfid_data.tag);
-    printf("  Time: %lu\n", rfid_data.time);
-
     return rfid_data;
 }
 
 // Clear RFID tag buffer
-void rfid_clear_tags(nrf_twi_mngr_t const *twi_mngr)
+void rfid_reader_clear_tags(rfid_reader_t *reader)
 {
-    uint8_t request_bytes = TAG_AND_TIME_REQUEST;
     uint8_t buffer[MAX_TAG_STORAGE * TAG_AND_TIME_REQUEST] = {0};
 
-    nrf_twi_mngr_transfer_t transfer[] = {
-        NRF_TWI_MNGR_WRITE(rfid_address, &request_bytes, 1, NRF_TWI_MNGR_NO_STOP),
-        NRF_TWI_MNGR_READ(rfid_address, buffer, sizeof(buffer), 0),
-    };
-
-    ret_code_t err_code = nrf_twi_mngr_perform(i2c_manager, NULL, transfer, 2, NULL);
-    if (err_code != NRF_SUCCESS)
+    // One transaction writes the request byte and reads back every stored tag
+    ret_code_t err_code = i2c_device_read_regs(&reader->device, TAG_AND_TIME_REQUEST, buffer, sizeof(buffer));
+    if (err_code == NRF_ERROR_INVALID_STATE)
     {
-        printf("Failed to clear tags. Error: 0x%lX\n", err_code);
+        // Reader offline, already visible in the bus report
     }
-    else
+    else if (err_code != NRF_SUCCESS)
     {
-        printf("Tag buffer cleared.\n");
+        printf("%s: failed to clear tags. Error: 0x%lX\n", reader->device.name, err_code);
     }
 }
 
-// Read a single byte from a register
-static uint8_t rfid_read_register(uint8_t i2c_addr, uint8_t reg_addr)
+// Function to check if a tag is present
+void rfid_reader_check_tag_present(rfid_reader_t *reader)
 {
-    uint8_t rx_buf = 0;
-
-    nrf_twi_mngr_transfer_t const read_transfer[] = {
-        NRF_TWI_MNGR_WRITE(i2c_addr, &reg_addr, 1, NRF_TWI_MNGR_NO_STOP),
-        NRF_TWI_MNGR_READ(i2c_addr, &rx_buf, 1, 0),
-    };
-
-    ret_code_t result = nrf_twi_mngr_perform(i2c_manager, NULL, read_transfer, 2, NULL);
-    if (result != NRF_SUCCESS)
-    {
-        printf("I2C transaction failed! Error: %lX\n", result);
-    }
-    return rx_buf;
+    uint8_t tag_present = i2c_device_read_reg(&reader->device, TAG_DATA_REG);
+    printf("tag presence value of %x\n", tag_present);
 }
 
-// Write a single byte to a register
-static void rfid_write_register(uint8_t i2c_addr, uint8_t reg_addr, uint8_t data)
+void rfid_reader_print_stats(rfid_reader_t *reader)
 {
-    uint8_t buffer[2] = {reg_addr, data};
-    nrf_twi_mngr_transfer_t const write_transfer[] = {NRF_TWI_MNGR_WRITE(i2c_addr, buffer, sizeof(buffer), 0)};
-
-    ret_code_t result = nrf_twi_mngr_perform(i2c_manager, NULL, write_transfer, 1, NULL);
-    if (result != NRF_SUCCESS)
+    uint32_t *frame_counts = reader->frame_counts;
+    uint32_t total = 0;
+    for (int i = 0; i < RFID_FRAME_STATUS_COUNT; i++)
     {
-        printf("I2C write failed! Error: %lX\n", result);
+        total += frame_counts[i];
     }
-}
-
-// Function to check if a tag is present
-void rfid_check_tag_present(nrf_twi_mngr_t const *twi_mngr)
-{
-    uint8_t tag_present = rfid_read_register(SPARKFUN_RFID_ADDR, TAG_DATA_REG);
-    printf("tag presence value of %x\n", tag_present);
+    uint32_t rejected = frame_counts[RFID_FRAME_FLOATING] + frame_counts[RFID_FRAME_CHECKSUM] +
+                        frame_counts[RFID_FRAME_NO_MAJORITY];
+    printf("%s frames: %lu read, %lu rejected, %u confirm reads\n", reader->device.name, total, rejected,
+           reader->confirm_reads);
+    for (int i = 0; i < RFID_FRAME_STATUS_COUNT; i++)
+    {
+        printf("  %-12s %lu\n", status_names[i], frame_counts[i]);
+    }
+    memset(reader->frame_counts, 0, sizeof(reader->frame_counts));
 }
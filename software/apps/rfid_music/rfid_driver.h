@@ -1,7 +1,7 @@
 #ifndef RFID_DRIVER_H
 #define RFID_DRIVER_H
 
-#include "nrf_twi_mngr.h"
+#include "i2c_bus.h"
 #include <stdint.h>
 #include <stddef.h>
 #include <stdbool.h>
@@ -24,20 +24,60 @@
 #define MAX_TAG_STORAGE 20
 #define BYTES_IN_BUFFER 4
 
+// A frame is 5 ID bytes, their XOR checksum and a 4-byte timestamp. The
+// reader board checks the ID-12LA's ASCII checksum and strips STX/ETX before
+// storing the tag, so the XOR byte is all that is left to check over I2C
+#define TAG_ID_BYTES 5
+#define TAG_CHECKSUM_BYTE 5
+
+// Frames read per rfid_reader_read() call at most in confirmation mode
+#define RFID_CONFIRM_MAX 5
+
+typedef enum
+{
+    RFID_FRAME_OK,
+    RFID_FRAME_EMPTY,        // Zero ID and checksum, no tag in the buffer
+    RFID_FRAME_BUS_ERROR,    // Transaction failed or reader offline
+    RFID_FRAME_FLOATING,     // All 0xFF, nothing drove the bus
+    RFID_FRAME_CHECKSUM,     // ID bytes don't match their checksum
+    RFID_FRAME_NO_MAJORITY,  // Confirmation reads disagreed
+    RFID_FRAME_STATUS_COUNT,
+} rfid_frame_status_t;
+
 typedef struct
 {
-    char tag[13];  // 6-character tag + null terminator
+    char tag[13];  // 6-character tag + null terminator, empty unless status is OK
     uint32_t time; // Timestamp in milliseconds
+    rfid_frame_status_t status;
 } rfid_data_t;
 
+// One Qwiic RFID reader. Several can share a bus at different addresses
+typedef struct
+{
+    i2c_device_t device;
+    uint8_t confirm_reads;
+    uint32_t frame_counts[RFID_FRAME_STATUS_COUNT];
+} rfid_reader_t;
+
 // Function declarations
-void rfid_init(nrf_twi_mngr_t const *twi_mngr);
-void rfid_scan_bus(nrf_twi_mngr_t const *twi_mngr);
-bool rfid_begin(nrf_twi_mngr_t const *twi_mngr);
-rfid_data_t rfid_read_tag(nrf_twi_mngr_t const *twi_mngr);
-void rfid_clear_tags(nrf_twi_mngr_t const *twi_mngr);
-static uint8_t rfid_read_register(uint8_t i2c_addr, uint8_t reg_addr);
-static void rfid_write_register(uint8_t i2c_addr, uint8_t reg_addr, uint8_t data);
-void rfid_check_tag_present(nrf_twi_mngr_t const *twi_mngr);
+// The reader is reached through the shared I2C bus passed to rfid_reader_init
+void rfid_reader_init(rfid_reader_t *reader, i2c_bus_t *bus, uint8_t address, const char *name);
+
+// Read and validate a frame. Anything but a valid tag comes back with an
+// empty tag string and the reason in status
+rfid_data_t rfid_reader_read(rfid_reader_t *reader);
+
+// Read <count> frames per rfid_reader_read() and only accept a tag that more
+// than half of them agree on. 1 turns confirmation off
+void rfid_reader_set_confirm_reads(rfid_reader_t *reader, uint8_t count);
+
+// Classify one raw frame of TAG_AND_TIME_REQUEST bytes
+rfid_frame_status_t rfid_check_frame(const uint8_t *frame);
+
+void rfid_reader_clear_tags(rfid_reader_t *reader);
+void rfid_reader_check_tag_present(rfid_reader_t *reader);
+
+// Print and reset frame counts by status
+void rfid_reader_print_stats(rfid_reader_t *reader);
 
 #endif
@@ -0,0 +1,218 @@
+// Round-robin polling of every RFID reader on the bus
+//
+// Read times come from DWT CYCCNT, which only counts while the CPU runs, so
+// intervals between reads and the utilization window use the RTC through
+// tickless_timer_now() instead.
+
+#include "rfid_scheduler.h"
+#include <stdio.h>
+#include <string.h>
+#include "nrf.h"
+#include "cycle_counter.h"
+#include "event_queue.h"
+#include "tickless_timer.h"
+#include "scan_trace.h"
+
+typedef struct
+{
+    rfid_reader_t *reader;
+    uint32_t reads;
+    uint64_t read_cycles;
+    uint32_t max_read_cycles;
+    uint32_t last_tick;
+    uint32_t max_interval_ticks;
+    bool read_once;
+} reader_slot_t;
+
+static reader_slot_t slots[RFID_MAX_READERS];
+static uint8_t slot_count = 0;
+static uint8_t next_slot = 0;
+static uint32_t cycle_us = 0;
+static rfid_scan_callback_t scan_callback = NULL;
+static uint32_t timer_id = 0;
+static uint16_t burst_slots = 0; // Slots left at the burst rate
+static uint32_t stats_start = 0;
+
+void rfid_scheduler_init(uint32_t cycle, rfid_scan_callback_t callback)
+{
+    memset(slots, 0, sizeof(slots));
+    slot_count = 0;
+    next_slot = 0;
+    cycle_us = cycle;
+    scan_callback = callback;
+}
+
+int rfid_scheduler_add(rfid_reader_t *reader)
+{
+    if (slot_count == RFID_MAX_READERS)
+    {
+        return -1;
+    }
+    slots[slot_count].reader = reader;
+    return slot_count++;
+}
+
+uint8_t rfid_scheduler_count(void)
+{
+    return slot_count;
+}
+
+static void read_slot(uint8_t index)
+{
+    reader_slot_t *slot = &slots[index];
+    uint32_t now = tickless_timer_now();
+    if (slot->read_once && now - slot->last_tick > slot->max_interval_ticks)
+    {
+        slot->max_interval_ticks = now - slot->last_tick;
+    }
+    slot->last_tick = now;
+    slot->read_once = true;
+
+    scan_trace_begin(index);
+    uint32_t start = DWT->CYCCNT;
+    rfid_data_t data = rfid_reader_read(slot->reader);
+    uint32_t cycles = DWT->CYCCNT - start;
+    scan_trace_mark(SCAN_STAGE_DECODED);
+
+    slot->reads++;
+    slot->read_cycles += cycles;
+    if (cycles > slot->max_read_cycles)
+    {
+        slot->max_read_cycles = cycles;
+    }
+
+    if (scan_callback)
+    {
+        scan_callback(index, slot->reader, &data);
+    }
+}
+
+static void start_timer(uint32_t cycle);
+
+// One slot: read the next reader in turn
+static void slot_event(void *context)
+{
+    // Posted just before the scheduler was stopped
+    if (timer_id == 0 || slot_count == 0)
+    {
+        return;
+    }
+    uint8_t index = next_slot;
+    next_slot = (next_slot + 1) % slot_count;
+    read_slot(index);
+
+    if (burst_slots > 0 && --burst_slots == 0)
+    {
+        tickless_timer_cancel(timer_id);
+        start_timer(cycle_us);
+    }
+}
+
+// Timer callbacks run in interrupt context, so they only post events
+static void slot_timer_callback(void *context)
+{
+    event_post(EVENT_PRIORITY_HIGH, slot_event, NULL);
+}
+
+static void start_timer(uint32_t cycle)
+{
+    // Polling only needs RTC resolution, so HFCLK stays off between slots
+    timer_id = tickless_timer_start(cycle / slot_count, true, TICKLESS_COARSE, slot_timer_callback, NULL);
+}
+
+// Intervals only count while polling, a stopped scheduler is not latency
+static void restart_intervals(void)
+{
+    for (uint8_t i = 0; i < slot_count; i++)
+    {
+        slots[i].read_once = false;
+    }
+}
+
+void rfid_scheduler_stop(void)
+{
+    if (timer_id != 0)
+    {
+        tickless_timer_cancel(timer_id);
+        timer_id = 0;
+    }
+    burst_slots = 0;
+}
+
+bool rfid_scheduler_running(void)
+{
+    return timer_id != 0;
+}
+
+void rfid_scheduler_burst(uint8_t rotations, uint32_t cycle)
+{
+    if (slot_count == 0)
+    {
+        return;
+    }
+    if (stats_start == 0)
+    {
+        stats_start = tickless_timer_now();
+    }
+    rfid_scheduler_stop();
+    restart_intervals();
+    burst_slots = rotations * slot_count;
+    start_timer(cycle);
+}
+
+void rfid_scheduler_print_stats(void)
+{
+    uint32_t elapsed_ticks = tickless_timer_now() - stats_start;
+    uint64_t elapsed_us = (uint64_t)elapsed_ticks * 1000000 / TICKLESS_TICK_HZ;
+    uint64_t busy_cycles = 0;
+    uint32_t reads = 0;
+    uint32_t worst_latency_us = 0;
+    uint32_t max_read_us = 0;
+
+    printf("RFID scheduler: %u readers, %lu ms cycle\n", slot_count, cycle_us / 1000);
+    for (uint8_t i = 0; i < slot_count; i++)
+    {
+        reader_slot_t *slot = &slots[i];
+        uint32_t avg_us = slot->reads ? (uint32_t)(slot->read_cycles / slot->reads / CYCLES_PER_US) : 0;
+        uint32_t interval_us = (uint32_t)((uint64_t)slot->max_interval_ticks * 1000000 / TICKLESS_TICK_HZ);
+
+        // Worst case a tag lands just after its reader was read
+        uint32_t latency_us = interval_us + slot->max_read_cycles / CYCLES_PER_US;
+        printf("  %-18s %lu reads, avg %lu us, max %lu us, max interval %lu ms, scan latency <= %lu ms\n",
+               slot->reader->device.name, slot->reads, avg_us, slot->max_read_cycles / CYCLES_PER_US,
+               interval_us / 1000, latency_us / 1000);
+        if (slot->reads > 0 && latency_us > worst_latency_us)
+        {
+            worst_latency_us = latency_us;
+        }
+        if (slot->max_read_cycles / CYCLES_PER_US > max_read_us)
+        {
+            max_read_us = slot->max_read_cycles / CYCLES_PER_US;
+        }
+
+        busy_cycles += slot->read_cycles;
+        reads += slot->reads;
+        slot->reads = 0;
+        slot->read_cycles = 0;
+        slot->max_read_cycles = 0;
+        slot->max_interval_ticks = 0;
+    }
+
+    if (reads > 0 && elapsed_us > 0)
+    {
+        uint32_t busy_us = (uint32_t)(busy_cycles / CYCLES_PER_US);
+        printf("  Bus utilization %lu.%02lu%%\n",
+               (uint32_t)(busy_us * 100ULL / elapsed_us), (uint32_t)(busy_us * 10000ULL / elapsed_us % 100));
+
+        // The most readers a cycle can hold and still come round within the
+        // target: the cycle shrunk to the target, filled with worst-case reads
+        uint32_t max_readers = max_read_us ? RFID_LATENCY_TARGET_US / max_read_us : 0;
+        printf("  Within %lu ms: at most %lu readers with a %lu ms cycle (max read %lu us)\n",
+               RFID_LATENCY_TARGET_US / 1000UL, max_readers, RFID_LATENCY_TARGET_US / 1000UL, max_read_us);
+
+        // What the configured cycle gives today
+        printf("  Measured with the %lu ms cycle: worst scan latency %lu ms\n", cycle_us / 1000,
+               worst_latency_us / 1000);
+    }
+    stats_start = tickless_timer_now();
+}
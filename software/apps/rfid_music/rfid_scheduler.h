@@ -0,0 +1,45 @@
+#ifndef RFID_SCHEDULER_H
+#define RFID_SCHEDULER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "rfid_driver.h"
+
+// Round-robin polling of every RFID reader on the bus
+//
+// The poll cycle is split into one slot per reader and each slot reads the
+// next reader in turn, so the bus load is spread evenly over the cycle and
+// every reader is read once per cycle however many there are. A tag waits at
+// most one cycle plus one read before it is seen.
+
+#define RFID_MAX_READERS 3
+#define RFID_LATENCY_TARGET_US 100000 // Scan latency the stats measure against
+
+// Runs as an event after each read. <index> is the reader's slot, in the order
+// rfid_scheduler_add() was called
+typedef void (*rfid_scan_callback_t)(uint8_t index, rfid_reader_t *reader, const rfid_data_t *data);
+
+void rfid_scheduler_init(uint32_t cycle_us, rfid_scan_callback_t callback);
+
+// Add a reader to the rotation. Returns its index, or -1 if the table is full
+int rfid_scheduler_add(rfid_reader_t *reader);
+
+uint8_t rfid_scheduler_count(void);
+
+// Stop polling. A slot already queued is skipped
+void rfid_scheduler_stop(void);
+
+// Whether the slot timer is running
+bool rfid_scheduler_running(void);
+
+// Read every reader <rotations> times with a <cycle_us> cycle, then carry on
+// at the normal cycle. This starts polling, and needs the tickless timer and
+// the event queue
+void rfid_scheduler_burst(uint8_t rotations, uint32_t cycle_us);
+
+// Print per-reader read time and interval, bus utilization, how many readers
+// a cycle of RFID_LATENCY_TARGET_US could hold and the worst scan latency
+// measured with the configured cycle, then reset the counters
+void rfid_scheduler_print_stats(void);
+
+#endif
@@ -0,0 +1,82 @@
+// Recent scans ticker across the top of the TFT
+//
+// The scroll area holds exactly SCAN_HISTORY_LINES lines and wraps around in
+// frame memory. The line at the scroll pointer is shown at the top, so it is
+// always the oldest. A new entry is drawn over it, then the pointer moves one
+// line down, which shows the new entry at the bottom and everything else one
+// line higher. Only the new line is ever drawn, and the scroll itself is one
+// VSCRSADD command however long the history is.
+
+#include "scan_history.h"
+#include <stdio.h>
+#include "ili9341.h"
+#include "nrf.h"
+#include "cycle_counter.h"
+
+#define TFT_WIDTH 240
+#define TEXT_MARGIN 8
+
+// Slot shown at the top of the ticker
+static uint8_t top_slot = 0;
+
+// Statistics
+static uint32_t steps = 0;
+static uint32_t draw_cycles = 0;
+static uint32_t scroll_cycles = 0;
+
+// Draw <text> into a slot of frame memory, left-aligned as seen on screen
+static void draw_line(uint8_t slot, const char *text)
+{
+    uint16_t y = slot * SCAN_HISTORY_LINE_HEIGHT;
+    ili9341_fill_rows(y, SCAN_HISTORY_LINE_HEIGHT, 0xE0, 0xE0, 0xE0);
+
+    // Drop characters that would run off the right edge. The panel is
+    // mirrored, so text starts TEXT_MARGIN from the right end of memory
+    char line[(TFT_WIDTH - 2 * TEXT_MARGIN) / 8 + 1];
+    uint8_t length = 0;
+    while (text[length] != '\0' && length < sizeof(line) - 1)
+    {
+        line[length] = text[length];
+        length++;
+    }
+    line[length] = '\0';
+    uint16_t width = tft_font_text_width(&font_8x8, line, 1);
+
+    uint16_t x = TFT_WIDTH - TEXT_MARGIN - width;
+    ili9341_draw_text(x, y + (SCAN_HISTORY_LINE_HEIGHT - font_8x8.height) / 2, line, &font_8x8, 1, 0x30, 0x30, 0x30);
+}
+
+void scan_history_init(void)
+{
+    ili9341_set_scroll_area(0, SCAN_HISTORY_HEIGHT);
+    top_slot = 0;
+    ili9341_scroll_to(0);
+    ili9341_fill_rows(0, SCAN_HISTORY_HEIGHT, 0xE0, 0xE0, 0xE0);
+}
+
+void scan_history_add(const char *text)
+{
+    uint32_t start = DWT->CYCCNT;
+    draw_line(top_slot, text);
+    uint32_t drawn = DWT->CYCCNT;
+
+    top_slot = (top_slot + 1) % SCAN_HISTORY_LINES;
+    ili9341_scroll_to(top_slot * SCAN_HISTORY_LINE_HEIGHT);
+
+    draw_cycles += drawn - start;
+    scroll_cycles += DWT->CYCCNT - drawn;
+    steps++;
+}
+
+void scan_history_print_stats(void)
+{
+    if (steps == 0)
+    {
+        return;
+    }
+    printf("Scan history: %lu scroll steps, line draw avg %lu us, scroll avg %lu us\n",
+           steps, draw_cycles / steps / CYCLES_PER_US, scroll_cycles / steps / CYCLES_PER_US);
+    steps = 0;
+    draw_cycles = 0;
+    scroll_cycles = 0;
+}
@@ -0,0 +1,25 @@
+#ifndef SCAN_HISTORY_H
+#define SCAN_HISTORY_H
+
+#include <stdint.h>
+
+// Recent scans ticker across the top of the TFT
+//
+// The top SCAN_HISTORY_HEIGHT rows are the ILI9341's vertical scroll area and
+// the rest of the screen is a fixed area, so info screens leave the ticker
+// alone as long as they only fill rows below it.
+
+#define SCAN_HISTORY_LINES 3
+#define SCAN_HISTORY_LINE_HEIGHT 12
+#define SCAN_HISTORY_HEIGHT (SCAN_HISTORY_LINES * SCAN_HISTORY_LINE_HEIGHT)
+
+// Set up the scroll area and clear the ticker. Call once the display is up
+void scan_history_init(void);
+
+// Scroll <text> in as the newest line, pushing the oldest one out
+void scan_history_add(const char *text);
+
+// Print scroll steps and their cost since the last call
+void scan_history_print_stats(void);
+
+#endif
@@ -0,0 +1,390 @@
+// Append-only scan journal in flash
+//
+// Flash is memory mapped, so the journal is read straight from its address
+// and only writes and erases go through fstorage. The NVMC backend halts the
+// CPU while it programs or erases, which is what the stall statistics
+// measure: roughly 41 us per word written and 85 ms per page erased. Batching
+// keeps the number of write calls down, and an erase only happens once per
+// SCAN_JOURNAL_PAGE_SIZE of records. Neither runs from the scan itself: the
+// app flushes from a low priority event and erases the next page while the
+// queue is idle, long before the head page fills up.
+//
+// Sequence numbers are assigned when a batch is written, so the records on a
+// page are consecutive and the page header's first_record locates them all.
+
+#include "scan_journal.h"
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include "app_error.h"
+#include "crc16.h"
+#include "nrf.h"
+#include "cycle_counter.h"
+#include "nrf_fstorage.h"
+#include "nrf_fstorage_nvmc.h"
+
+#define PAGE_MAGIC 0x4C4E4A53 // "SJNL"
+#define PAGE_COUNT ((SCAN_JOURNAL_END - SCAN_JOURNAL_START) / SCAN_JOURNAL_PAGE_SIZE)
+#define RECORDS_PER_PAGE ((SCAN_JOURNAL_PAGE_SIZE - sizeof(page_header_t)) / sizeof(scan_record_t))
+#define FORMAT_VERSION 1
+#define EXPORT_CHUNK 8 // Records per UART write, the retarget layer sends at most 255 bytes
+
+typedef struct
+{
+    uint32_t magic;
+    uint32_t page_sequence; // Counts up each time a page is started
+    uint32_t erase_count;   // Times this page has been erased by the journal
+    uint32_t first_record;  // Sequence of the page's first record
+} page_header_t;
+
+static void fstorage_handler(nrf_fstorage_evt_t *p_evt);
+
+NRF_FSTORAGE_DEF(nrf_fstorage_t journal_fs) = {
+    .evt_handler = fstorage_handler,
+    .start_addr = SCAN_JOURNAL_START,
+    .end_addr = SCAN_JOURNAL_END,
+};
+
+static uint8_t head_page = 0;
+static uint16_t head_slot = 0; // Next free slot on head_page
+static uint32_t page_sequence = 0;
+static uint32_t next_sequence = 0;
+
+// Scans not written yet. fstorage reads from here while it writes. Room for
+// a second batch while the first one waits for its flush event
+static scan_record_t buffer[SCAN_JOURNAL_BATCH * 2] __attribute__((aligned(4)));
+static uint8_t buffered = 0;
+static page_header_t header_buffer __attribute__((aligned(4)));
+
+// Page erased ahead of the head, and the erase count its header had
+static bool erased_ahead = false;
+static uint32_t erased_ahead_count = 0;
+
+// Statistics
+static uint32_t appends = 0;
+static uint32_t batches = 0;
+static uint32_t erases = 0;
+static uint32_t flash_errors = 0;
+static uint64_t stall_cycles = 0;
+static uint32_t max_stall_cycles = 0;
+
+static void fstorage_handler(nrf_fstorage_evt_t *p_evt)
+{
+    if (p_evt->result != NRF_SUCCESS)
+    {
+        flash_errors++;
+    }
+}
+
+static uint32_t page_address(uint8_t page)
+{
+    return SCAN_JOURNAL_START + (uint32_t)page * SCAN_JOURNAL_PAGE_SIZE;
+}
+
+static const page_header_t *page_header(uint8_t page)
+{
+    return (const page_header_t *)page_address(page);
+}
+
+static uint32_t slot_address(uint8_t page, uint16_t slot)
+{
+    return page_address(page) + sizeof(page_header_t) + (uint32_t)slot * sizeof(scan_record_t);
+}
+
+static bool page_valid(uint8_t page)
+{
+    return page_header(page)->magic == PAGE_MAGIC;
+}
+
+static bool blank(uint32_t address, uint32_t length)
+{
+    const uint32_t *words = (const uint32_t *)address;
+    for (uint32_t i = 0; i < length / 4; i++)
+    {
+        if (words[i] != 0xFFFFFFFF)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Slots in use on <page>. A record torn by a reset still takes its slot
+static uint16_t used_slots(uint8_t page)
+{
+    uint16_t used = 0;
+    for (uint16_t slot = 0; slot < RECORDS_PER_PAGE; slot++)
+    {
+        if (!blank(slot_address(page, slot), sizeof(scan_record_t)))
+        {
+            used = slot + 1;
+        }
+    }
+    return used;
+}
+
+// Wait for fstorage, then charge the time to the stall statistics
+static void wait_for_flash(uint32_t start)
+{
+    while (nrf_fstorage_is_busy(&journal_fs))
+    {
+    }
+    uint32_t cycles = DWT->CYCCNT - start;
+    stall_cycles += cycles;
+    if (cycles > max_stall_cycles)
+    {
+        max_stall_cycles = cycles;
+    }
+}
+
+static void flash_write(uint32_t address, const void *data, uint32_t length)
+{
+    uint32_t start = DWT->CYCCNT;
+    if (nrf_fstorage_write(&journal_fs, address, data, length, NULL) != NRF_SUCCESS)
+    {
+        flash_errors++;
+        return;
+    }
+    wait_for_flash(start);
+}
+
+// Erase <page> if needed and make it the head, carrying its erase count over
+static void start_page(uint8_t page)
+{
+    const page_header_t *old = page_header(page);
+    uint32_t erase_count = page_valid(page) ? old->erase_count : 0;
+    if (erased_ahead)
+    {
+        erase_count = erased_ahead_count;
+        erased_ahead = false;
+    }
+
+    if (!blank(page_address(page), SCAN_JOURNAL_PAGE_SIZE))
+    {
+        uint32_t start = DWT->CYCCNT;
+        if (nrf_fstorage_erase(&journal_fs, page_address(page), 1, NULL) == NRF_SUCCESS)
+        {
+            wait_for_flash(start);
+            erases++;
+            erase_count++;
+        }
+        else
+        {
+            flash_errors++;
+        }
+    }
+
+    header_buffer.magic = PAGE_MAGIC;
+    header_buffer.page_sequence = ++page_sequence;
+    header_buffer.erase_count = erase_count;
+    header_buffer.first_record = next_sequence;
+    flash_write(page_address(page), &header_buffer, sizeof(header_buffer));
+
+    head_page = page;
+    head_slot = 0;
+}
+
+void scan_journal_init(void)
+{
+    ret_code_t err_code = nrf_fstorage_init(&journal_fs, &nrf_fstorage_nvmc, NULL);
+    APP_ERROR_CHECK(err_code);
+
+    // The head is the page started most recently
+    bool found = false;
+    for (uint8_t page = 0; page < PAGE_COUNT; page++)
+    {
+        const page_header_t *header = page_header(page);
+        if (page_valid(page) && (!found || (int32_t)(header->page_sequence - page_sequence) > 0))
+        {
+            found = true;
+            head_page = page;
+            page_sequence = header->page_sequence;
+        }
+    }
+
+    if (!found)
+    {
+        next_sequence = 0;
+        start_page(0);
+        printf("Scan journal: new journal at 0x%05X\n", SCAN_JOURNAL_START);
+        return;
+    }
+
+    head_slot = used_slots(head_page);
+    next_sequence = page_header(head_page)->first_record + head_slot;
+    printf("Scan journal: %lu records, next is #%lu on page %u\n", scan_journal_count(), next_sequence, head_page);
+}
+
+void scan_journal_flush(void)
+{
+    uint8_t written = 0;
+    while (written < buffered)
+    {
+        if (head_slot == RECORDS_PER_PAGE)
+        {
+            start_page((head_page + 1) % PAGE_COUNT);
+        }
+
+        // Never past the end of the page
+        uint8_t count = buffered - written;
+        if (count > RECORDS_PER_PAGE - head_slot)
+        {
+            count = RECORDS_PER_PAGE - head_slot;
+        }
+        for (uint8_t i = written; i < written + count; i++)
+        {
+            buffer[i].sequence = next_sequence++;
+            buffer[i].crc = crc16_compute((const uint8_t *)&buffer[i], offsetof(scan_record_t, crc), NULL);
+        }
+        flash_write(slot_address(head_page, head_slot), &buffer[written], count * sizeof(scan_record_t));
+        head_slot += count;
+        written += count;
+    }
+
+    if (buffered > 0)
+    {
+        batches++;
+    }
+    buffered = 0;
+}
+
+void scan_journal_prepare(void)
+{
+    if (erased_ahead || head_slot < RECORDS_PER_PAGE / 2)
+    {
+        return;
+    }
+
+    uint8_t page = (head_page + 1) % PAGE_COUNT;
+    erased_ahead_count = page_valid(page) ? page_header(page)->erase_count : 0;
+    if (!blank(page_address(page), SCAN_JOURNAL_PAGE_SIZE))
+    {
+        uint32_t start = DWT->CYCCNT;
+        if (nrf_fstorage_erase(&journal_fs, page_address(page), 1, NULL) != NRF_SUCCESS)
+        {
+            flash_errors++;
+            return;
+        }
+        wait_for_flash(start);
+        erases++;
+        erased_ahead_count++;
+    }
+    erased_ahead = true;
+}
+
+static uint8_t hex_digit(char c)
+{
+    if (c >= '0' && c <= '9')
+    {
+        return c - '0';
+    }
+    if (c >= 'A' && c <= 'F')
+    {
+        return c - 'A' + 10;
+    }
+    return 0;
+}
+
+bool scan_journal_append(const char *tag, uint8_t reader, uint32_t reader_time, uint32_t rtc_ticks,
+                         int32_t centi_oz)
+{
+    // The flush event never got to run, write out the oldest batch now
+    if (buffered == sizeof(buffer) / sizeof(buffer[0]))
+    {
+        scan_journal_flush();
+    }
+
+    scan_record_t *record = &buffer[buffered];
+    memset(record, 0xFF, sizeof(*record));
+    for (int i = 0; i < (int)sizeof(record->tag) && tag[i * 2] && tag[i * 2 + 1]; i++)
+    {
+        record->tag[i] = (hex_digit(tag[i * 2]) << 4) | hex_digit(tag[i * 2 + 1]);
+    }
+    record->reader = reader;
+    record->reader_time = reader_time;
+    record->rtc_ticks = rtc_ticks;
+    record->centi_oz = centi_oz > INT16_MAX ? INT16_MAX : (centi_oz < INT16_MIN ? INT16_MIN : centi_oz);
+    appends++;
+
+    return ++buffered == SCAN_JOURNAL_BATCH;
+}
+
+uint32_t scan_journal_count(void)
+{
+    uint32_t count = buffered;
+    for (uint8_t page = 0; page < PAGE_COUNT; page++)
+    {
+        if (page_valid(page))
+        {
+            count += page == head_page ? head_slot : used_slots(page);
+        }
+    }
+    return count;
+}
+
+static void export_write(const void *data, size_t length)
+{
+    fwrite(data, 1, length, stdout);
+}
+
+void scan_journal_export(void)
+{
+    scan_journal_flush();
+    fflush(stdout);
+
+    struct __attribute__((packed))
+    {
+        char magic[8];
+        uint32_t count;
+        uint16_t record_size;
+        uint16_t version;
+    } header = {{'R', 'S', 'J', 'O', 'U', 'R', 'N', 'L'}, scan_journal_count(), sizeof(scan_record_t), FORMAT_VERSION};
+    export_write(&header, sizeof(header));
+
+    // Oldest page first, which is the one after the head round the ring.
+    // UARTE sends with EasyDMA, so records go through RAM on their way out
+    static scan_record_t chunk[EXPORT_CHUNK];
+    uint16_t crc = 0xFFFF;
+    for (uint8_t i = 1; i <= PAGE_COUNT; i++)
+    {
+        uint8_t page = (head_page + i) % PAGE_COUNT;
+        if (!page_valid(page))
+        {
+            continue;
+        }
+        uint16_t used = page == head_page ? head_slot : used_slots(page);
+        for (uint16_t slot = 0; slot < used; slot += EXPORT_CHUNK)
+        {
+            uint16_t count = used - slot < EXPORT_CHUNK ? used - slot : EXPORT_CHUNK;
+            memcpy(chunk, (const void *)slot_address(page, slot), count * sizeof(scan_record_t));
+            crc = crc16_compute((const uint8_t *)chunk, count * sizeof(scan_record_t), &crc);
+            export_write(chunk, count * sizeof(scan_record_t));
+        }
+    }
+    export_write(&crc, sizeof(crc));
+    fflush(stdout);
+}
+
+void scan_journal_print_stats(void)
+{
+    uint32_t min_wear = UINT32_MAX;
+    uint32_t max_wear = 0;
+    for (uint8_t page = 0; page < PAGE_COUNT; page++)
+    {
+        uint32_t wear = page_valid(page) ? page_header(page)->erase_count : 0;
+        min_wear = wear < min_wear ? wear : min_wear;
+        max_wear = wear > max_wear ? wear : max_wear;
+    }
+
+    printf("Scan journal: %lu appends, %lu batches, %lu erases, %lu errors, %u buffered\n", appends, batches, erases,
+           flash_errors, buffered);
+    printf("  Flash stall %lu us total, %lu us max, page erases %lu-%lu\n",
+           (uint32_t)(stall_cycles / CYCLES_PER_US), max_stall_cycles / CYCLES_PER_US, min_wear, max_wear);
+
+    appends = 0;
+    batches = 0;
+    erases = 0;
+    flash_errors = 0;
+    stall_cycles = 0;
+    max_stall_cycles = 0;
+}
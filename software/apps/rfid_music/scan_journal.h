@@ -0,0 +1,71 @@
+#ifndef SCAN_JOURNAL_H
+#define SCAN_JOURNAL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Append-only scan journal in flash
+//
+// A reserved flash region, just below the FDS pages, is used as a ring of
+// pages. Each page starts with a header and is then filled with fixed-size
+// records in order. Scans are buffered in RAM and written in batches, and a
+// batch never straddles a page, so each page is erased once per trip round
+// the ring and every page wears at the same rate. When the ring is full the
+// oldest page is erased to make room, ahead of time once the head page is
+// half full, so its records go half a page early.
+//
+// The region must lie above the application image and below FDS, which uses
+// the last FDS_VIRTUAL_PAGES pages of flash.
+
+#define SCAN_JOURNAL_START 0x6E000
+#define SCAN_JOURNAL_END 0x76000 // 8 pages of 4 kB
+#define SCAN_JOURNAL_PAGE_SIZE 4096
+#define SCAN_JOURNAL_BATCH 10 // Records buffered before a flash write
+
+// One scan, 24 bytes. Flash reads back all ones where nothing was written, so
+// a sequence of 0xFFFFFFFF marks a free slot
+typedef struct
+{
+    uint32_t sequence;    // Counts up across the whole journal
+    uint8_t tag[6];       // 5 ID bytes and their checksum
+    uint8_t reader;       // Scheduler slot of the reader that saw it
+    uint8_t flags;        // Reserved, 0xFF
+    uint32_t reader_time; // Timestamp from the reader, ms
+    uint32_t rtc_ticks;   // tickless_timer_now() at the scan
+    int16_t centi_oz;     // Weight on the plate
+    uint16_t crc;         // CRC-16-CCITT of everything above
+} scan_record_t;
+
+// Find the end of the journal in flash. Erases the first page if the region
+// holds no journal yet
+void scan_journal_init(void);
+
+// Buffer one scan. <tag> is the 12 hex digit tag string
+// Returns true when SCAN_JOURNAL_BATCH records are waiting, the caller then
+// runs scan_journal_flush() once time allows. Only if a second batch fills
+// up before that does an append write to flash itself
+bool scan_journal_append(const char *tag, uint8_t reader, uint32_t reader_time, uint32_t rtc_ticks,
+                         int32_t centi_oz);
+
+// Write out any buffered records now
+void scan_journal_flush(void);
+
+// Erase the page after the head once the head is half full, so no flush has
+// to wait ~85 ms for an erase. Call when nothing else is pending, it returns
+// at once when there is nothing to do
+void scan_journal_prepare(void);
+
+// Records in flash, oldest first, and buffered ones not yet written
+uint32_t scan_journal_count(void);
+
+// Flush, then send every record over the serial port, oldest first
+//
+// Binary frame: "RSJOURNL", record count (uint32), record size (uint16),
+// format version (uint16), the records, then the CRC-16-CCITT of the records.
+// All fields are little-endian. software/tools/scan_journal.py decodes it
+void scan_journal_export(void);
+
+// Print appends, flash writes, erases, CPU stall time and page wear
+void scan_journal_print_stats(void);
+
+#endif
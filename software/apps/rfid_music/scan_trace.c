@@ -0,0 +1,150 @@
+// Stage timestamps along the scan pipeline
+//
+// Reads that find nothing come every poll, so the open scan lives outside the
+// ring and only a finished scan is copied in.
+//
+// Slot reads run at a higher event priority than the render, so more reads
+// can come between keeping a scan and ending it. Those reads get no open
+// scan. Other redraws, such as a browse or a wake, can also come in between,
+// so the display stages only reach the kept scan while its own render runs.
+
+#include "scan_trace.h"
+#include <stdio.h>
+#include <string.h>
+#include "nrf.h"
+#include "cycle_counter.h"
+#include "tickless_timer.h"
+
+static const char *stage_names[SCAN_STAGE_COUNT] = {
+    [SCAN_STAGE_I2C_START] = "i2c_start",
+    [SCAN_STAGE_I2C_END] = "i2c_end",
+    [SCAN_STAGE_DECODED] = "decoded",
+    [SCAN_STAGE_LOOKUP_START] = "lookup_start",
+    [SCAN_STAGE_LOOKUP_END] = "lookup_end",
+    [SCAN_STAGE_LAYOUT] = "layout",
+    [SCAN_STAGE_SPI_FIRST] = "spi_first",
+    [SCAN_STAGE_SPI_LAST] = "spi_last",
+};
+
+static scan_trace_t ring[SCAN_TRACE_SIZE];
+static uint8_t head = 0;  // Slot of the next scan
+static uint8_t count = 0; // Kept scans not yet dumped
+static scan_trace_t working;
+static scan_trace_t *open = NULL; // Scan the read stages go to
+static bool kept = false;
+static bool rendering = false; // The kept scan's display event is running
+static const void *kept_key = NULL;
+static uint32_t next_id = 1;
+static uint32_t dropped = 0;
+
+void scan_trace_begin(uint8_t reader)
+{
+    if (kept)
+    {
+        open = NULL;
+        return;
+    }
+    open = &working;
+    memset(open, 0, sizeof(*open));
+    open->reader = reader;
+    open->start_ticks = tickless_timer_now();
+    scan_trace_mark(SCAN_STAGE_I2C_START);
+}
+
+void scan_trace_mark(scan_stage_t stage)
+{
+    scan_trace_t *scan = open;
+    if (stage >= SCAN_STAGE_LOOKUP_START)
+    {
+        scan = rendering ? &working : NULL;
+    }
+    if (scan != NULL)
+    {
+        scan->cycles[stage] = DWT->CYCCNT;
+        scan->stamped |= 1 << stage;
+    }
+}
+
+void scan_trace_keep(const void *key)
+{
+    // A second tag in the same cycle leaves the first one's scan alone
+    if (open != NULL && !kept)
+    {
+        open->id = next_id++;
+        kept = true;
+        kept_key = key;
+    }
+}
+
+void scan_trace_render_begin(const void *key)
+{
+    rendering = kept && key == kept_key;
+}
+
+void scan_trace_end(void)
+{
+    if (!rendering)
+    {
+        return;
+    }
+    ring[head] = working;
+    head = (head + 1) % SCAN_TRACE_SIZE;
+    if (count == SCAN_TRACE_SIZE)
+    {
+        dropped++;
+    }
+    else
+    {
+        count++;
+    }
+    open = NULL;
+    kept = false;
+    rendering = false;
+}
+
+void scan_trace_spi(bool done)
+{
+    // Only the render of a kept scan, not the reads that found nothing or
+    // other redraws
+    if (!rendering)
+    {
+        return;
+    }
+    if (done)
+    {
+        scan_trace_mark(SCAN_STAGE_SPI_LAST);
+    }
+    else if (!(working.stamped & (1 << SCAN_STAGE_SPI_FIRST)))
+    {
+        scan_trace_mark(SCAN_STAGE_SPI_FIRST);
+    }
+}
+
+void scan_trace_dump(void)
+{
+    if (count == 0 && dropped == 0)
+    {
+        return;
+    }
+    printf("Scan trace: %u scans, %lu dropped\n", count, dropped);
+
+    // Oldest first: id, reader, uptime in ms, then each stage in microseconds
+    // after the read started
+    for (uint8_t n = 0; n < count; n++)
+    {
+        const scan_trace_t *scan = &ring[(head + SCAN_TRACE_SIZE - count + n) % SCAN_TRACE_SIZE];
+        uint32_t start_ms = (uint32_t)((uint64_t)scan->start_ticks * 1000 / TICKLESS_TICK_HZ);
+        printf("TRACE %lu %u %lu", scan->id, scan->reader, start_ms);
+        for (int stage = 0; stage < SCAN_STAGE_COUNT; stage++)
+        {
+            if (scan->stamped & (1 << stage))
+            {
+                uint32_t cycles = scan->cycles[stage] - scan->cycles[SCAN_STAGE_I2C_START];
+                printf(" %s=%lu", stage_names[stage], cycles / CYCLES_PER_US);
+            }
+        }
+        printf("\n");
+    }
+    count = 0;
+    dropped = 0;
+}
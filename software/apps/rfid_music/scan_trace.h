@@ -0,0 +1,68 @@
+#ifndef SCAN_TRACE_H
+#define SCAN_TRACE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Stage timestamps along the scan pipeline, from the RFID read to the last
+// byte of the screen on the SPI bus
+//
+// Every read opens a tentative scan. If the read turned up a new tag the scan
+// is kept and the display side carries on stamping it, otherwise the next read
+// reuses its slot. Kept scans go into a ring of SCAN_TRACE_SIZE, the oldest
+// dropped first, and scan_trace_dump() prints them for tools/scan_trace.py.
+//
+// Stamps come from DWT CYCCNT, which stops while the CPU sleeps. A scan runs
+// from the read to the render without the event queue going idle, so the
+// stages of one scan are never split by a sleep.
+
+#define SCAN_TRACE_SIZE 16 // Scans kept between dumps
+
+typedef enum
+{
+    SCAN_STAGE_I2C_START,    // Read request goes out on the bus
+    SCAN_STAGE_I2C_END,      // Frames read and checked
+    SCAN_STAGE_DECODED,      // Tag ID formatted
+    SCAN_STAGE_LOOKUP_START, // Display event picked up from the queue
+    SCAN_STAGE_LOOKUP_END,   // Catalog entry found
+    SCAN_STAGE_LAYOUT,       // Template chosen, drawing starts
+    SCAN_STAGE_SPI_FIRST,    // First SPIM transfer starts
+    SCAN_STAGE_SPI_LAST,     // Last SPIM transfer done
+    SCAN_STAGE_COUNT,
+} scan_stage_t;
+
+typedef struct
+{
+    uint32_t id;
+    uint32_t start_ticks; // tickless_timer_now() at SCAN_STAGE_I2C_START
+    uint32_t cycles[SCAN_STAGE_COUNT];
+    uint16_t stamped;     // Bit per stage that has a stamp
+    uint8_t reader;
+} scan_trace_t;
+
+// Open a tentative scan for a read of <reader> and stamp SCAN_STAGE_I2C_START
+// Does nothing while a kept scan is still being rendered
+void scan_trace_begin(uint8_t reader);
+
+// Stamp <stage>. Read stages go to the open scan, display stages from
+// SCAN_STAGE_LOOKUP_START on to the kept one while its render runs
+void scan_trace_mark(scan_stage_t stage);
+
+// The read found a new tag, keep the open scan. <key> identifies the display
+// event that will render it. Does nothing while another scan is kept
+void scan_trace_keep(const void *key);
+
+// A display event for <key> starts. Only the one for the kept scan is traced,
+// display stages and SPI transfers from other redraws are ignored
+void scan_trace_render_begin(const void *key);
+
+// The screen is done, close the kept scan if this render was its own
+void scan_trace_end(void);
+
+// Called by the display driver around each SPIM transfer
+void scan_trace_spi(bool done);
+
+// Print the scans kept since the last dump, one TRACE line each, then clear
+void scan_trace_dump(void);
+
+#endif
@@ -0,0 +1,187 @@
+// Info screens described as data
+//
+// Label positions are constants, so drawing a row costs one length scan of
+// its value instead of an snprintf and a scan of the combined string. Render
+// time is measured with the DWT cycle counter and is dominated by the SPI
+// transfers, not by the layout.
+//
+// The first render of an entry is captured into a display list. Scanning the
+// same entry again while its list is cached replays that instead.
+
+#include "screen_template.h"
+#include <stdio.h>
+#include <string.h>
+#include "display_list.h"
+#include "ili9341.h"
+#include "scan_history.h"
+#include "scan_trace.h"
+#include "nrf.h"
+#include "cycle_counter.h"
+
+#define ROW_Y(i) (60 + 30 * (i))
+#define HEADER_Y 40
+
+// Everything below the scan history ticker
+#define CONTENT_Y SCAN_HISTORY_HEIGHT
+#define CONTENT_HEIGHT (TEMPLATE_TFT_HEIGHT - SCAN_HISTORY_HEIGHT)
+
+static const screen_template_t templates[MEDIA_TYPE_COUNT] = {
+    [MEDIA_VINYL] = {
+        TEMPLATE_HEADER("Record Info"),
+        draw_vinyl_icon, 35, TEMPLATE_TFT_HEIGHT - 30,
+        7,
+        {
+            TEMPLATE_ROW("Artist: ", ROW_Y(0), person),
+            TEMPLATE_ROW("Title: ", ROW_Y(1), title),
+            TEMPLATE_ROW("Song: ", ROW_Y(2), field1),
+            TEMPLATE_ROW("Song: ", ROW_Y(3), field2),
+            TEMPLATE_ROW("Song: ", ROW_Y(4), field3),
+            TEMPLATE_ROW("Genre: ", ROW_Y(5), genre),
+            TEMPLATE_ROW("Year: ", ROW_Y(6), year),
+        },
+    },
+    [MEDIA_VHS] = {
+        TEMPLATE_HEADER("VHS Info"),
+        draw_vhs_icon, 20, TEMPLATE_TFT_HEIGHT - 40,
+        7,
+        {
+            TEMPLATE_ROW("Director: ", ROW_Y(0), person),
+            TEMPLATE_ROW("Title: ", ROW_Y(1), title),
+            TEMPLATE_ROW("Actor: ", ROW_Y(2), field1),
+            TEMPLATE_ROW("Actor: ", ROW_Y(3), field2),
+            TEMPLATE_ROW("Actor: ", ROW_Y(4), field3),
+            TEMPLATE_ROW("Genre: ", ROW_Y(5), genre),
+            TEMPLATE_ROW("Year: ", ROW_Y(6), year),
+        },
+    },
+    [MEDIA_CASSETTE] = {
+        TEMPLATE_HEADER("Cassette Info"),
+        draw_cassette_icon, 10, TEMPLATE_TFT_HEIGHT - 44,
+        7,
+        {
+            TEMPLATE_ROW("Artist: ", ROW_Y(0), person),
+            TEMPLATE_ROW("Title: ", ROW_Y(1), title),
+            TEMPLATE_ROW("Side A: ", ROW_Y(2), field1),
+            TEMPLATE_ROW("Side B: ", ROW_Y(3), field2),
+            TEMPLATE_ROW("Length: ", ROW_Y(4), field3),
+            TEMPLATE_ROW("Genre: ", ROW_Y(5), genre),
+            TEMPLATE_ROW("Year: ", ROW_Y(6), year),
+        },
+    },
+    [MEDIA_CD] = {
+        TEMPLATE_HEADER("CD Info"),
+        draw_cd_icon, 35, TEMPLATE_TFT_HEIGHT - 30,
+        7,
+        {
+            TEMPLATE_ROW("Artist: ", ROW_Y(0), person),
+            TEMPLATE_ROW("Album: ", ROW_Y(1), title),
+            TEMPLATE_ROW("Track: ", ROW_Y(2), field1),
+            TEMPLATE_ROW("Track: ", ROW_Y(3), field2),
+            TEMPLATE_ROW("Track: ", ROW_Y(4), field3),
+            TEMPLATE_ROW("Genre: ", ROW_Y(5), genre),
+            TEMPLATE_ROW("Year: ", ROW_Y(6), year),
+        },
+    },
+    [MEDIA_CARTRIDGE] = {
+        TEMPLATE_HEADER("Game Info"),
+        draw_cartridge_icon, 15, TEMPLATE_TFT_HEIGHT - 46,
+        7,
+        {
+            TEMPLATE_ROW("Studio: ", ROW_Y(0), person),
+            TEMPLATE_ROW("Title: ", ROW_Y(1), title),
+            TEMPLATE_ROW("System: ", ROW_Y(2), field1),
+            TEMPLATE_ROW("Players: ", ROW_Y(3), field2),
+            TEMPLATE_ROW("Rating: ", ROW_Y(4), field3),
+            TEMPLATE_ROW("Genre: ", ROW_Y(5), genre),
+            TEMPLATE_ROW("Year: ", ROW_Y(6), year),
+        },
+    },
+};
+
+typedef struct
+{
+    uint32_t renders;
+    uint64_t cycles; // Two full-screen fills take tens of millions
+    uint32_t max_cycles;
+} template_stats_t;
+
+static template_stats_t stats[MEDIA_TYPE_COUNT];
+
+static void draw_row(const template_row_t *row, const catalog_entry_t *entry)
+{
+    const char *value = *(const char *const *)((const char *)entry + row->field);
+    if (value == NULL)
+    {
+        value = "";
+    }
+
+    // Cut the value off at the left edge of the screen
+    char text[TEMPLATE_TFT_WIDTH / TEMPLATE_CHAR_WIDTH + 1];
+    size_t max_length = row->label_x / TEMPLATE_CHAR_WIDTH;
+    size_t length = strnlen(value, max_length);
+    memcpy(text, value, length);
+    text[length] = '\0';
+
+    ili9341_draw_string(row->label_x, row->y, row->label, 1, 0x00, 0x00, 0x00);
+    ili9341_draw_string(row->label_x - length * TEMPLATE_CHAR_WIDTH, row->y, text, 1, 0x00, 0x00, 0x00);
+}
+
+void screen_template_render(const catalog_entry_t *entry)
+{
+    if (entry->media >= MEDIA_TYPE_COUNT)
+    {
+        return;
+    }
+    const screen_template_t *template = &templates[entry->media];
+    scan_trace_mark(SCAN_STAGE_LAYOUT);
+    uint32_t start = DWT->CYCCNT;
+
+    if (!display_list_replay(entry))
+    {
+        display_list_capture_begin(entry);
+
+        ili9341_fill_rows(CONTENT_Y, CONTENT_HEIGHT, entry->accent[0], entry->accent[1], entry->accent[2]);
+        ili9341_fill_rows(CONTENT_Y, CONTENT_HEIGHT, 0xFF, 0xFF, 0xFF);
+        ili9341_draw_string(template->header_x, HEADER_Y, template->header, 1, 0xFF, 0x00, 0x00);
+
+        for (uint8_t i = 0; i < template->row_count; i++)
+        {
+            draw_row(&template->rows[i], entry);
+        }
+
+        if (template->icon != NULL)
+        {
+            template->icon(template->icon_x, template->icon_y);
+        }
+
+        display_list_capture_end(DWT->CYCCNT - start);
+    }
+
+    uint32_t cycles = DWT->CYCCNT - start;
+    template_stats_t *s = &stats[entry->media];
+    s->renders++;
+    s->cycles += cycles;
+    if (cycles > s->max_cycles)
+    {
+        s->max_cycles = cycles;
+    }
+}
+
+void screen_template_print_stats(void)
+{
+    for (int media = 0; media < MEDIA_TYPE_COUNT; media++)
+    {
+        template_stats_t *s = &stats[media];
+        if (s->renders == 0)
+        {
+            continue;
+        }
+        printf("Template %s: %lu renders, avg %lu ms, max %lu ms\n",
+               templates[media].header, s->renders,
+               (uint32_t)(s->cycles / s->renders / (CYCLES_PER_US * 1000)),
+               s->max_cycles / (CYCLES_PER_US * 1000));
+        s->renders = 0;
+        s->cycles = 0;
+        s->max_cycles = 0;
+    }
+}
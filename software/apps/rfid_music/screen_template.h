@@ -0,0 +1,61 @@
+#ifndef SCREEN_TEMPLATE_H
+#define SCREEN_TEMPLATE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "catalog.h"
+
+// Info screens described as data
+//
+// Each media type has a template: a header, an icon, and rows that pair a
+// static label with one catalog_entry_t field. One renderer draws any entry.
+// Adding a media type means adding a template, not draw code.
+
+#define TEMPLATE_MAX_ROWS 8
+
+#define TEMPLATE_TFT_WIDTH 240
+#define TEMPLATE_TFT_HEIGHT 320
+#define TEMPLATE_CHAR_WIDTH 8
+#define TEMPLATE_RIGHT_MARGIN 35
+
+// The panel is mirrored, so text is drawn last character first and the first
+// character ends up furthest right. A label of <length> characters drawn at
+// this x starts TEMPLATE_RIGHT_MARGIN from the edge, wherever its value ends
+#define TEMPLATE_LABEL_X(length) (TEMPLATE_TFT_WIDTH - TEMPLATE_RIGHT_MARGIN - (length) * TEMPLATE_CHAR_WIDTH)
+#define TEMPLATE_CENTER_X(length) ((TEMPLATE_TFT_WIDTH - (length) * TEMPLATE_CHAR_WIDTH) / 2)
+
+typedef struct
+{
+    const char *label;
+    uint8_t label_length;
+    uint16_t label_x; // Precomputed from the label length
+    uint16_t y;
+    uint16_t field;   // Offset of the const char * field in catalog_entry_t
+} template_row_t;
+
+// Right-aligned row showing <field> of the catalog entry after <label>
+#define TEMPLATE_ROW(label, row_y, field_name) \
+    {label, sizeof(label) - 1, TEMPLATE_LABEL_X(sizeof(label) - 1), row_y, offsetof(catalog_entry_t, field_name)}
+
+typedef void (*template_icon_t)(uint16_t x, uint16_t y);
+
+typedef struct
+{
+    const char *header;
+    uint16_t header_x;
+    template_icon_t icon;
+    uint16_t icon_x;
+    uint16_t icon_y;
+    uint8_t row_count;
+    template_row_t rows[TEMPLATE_MAX_ROWS];
+} screen_template_t;
+
+#define TEMPLATE_HEADER(text) text, TEMPLATE_CENTER_X(sizeof(text) - 1)
+
+// Clear the screen below the scan history and draw <entry> with its media type's template
+void screen_template_render(const catalog_entry_t *entry);
+
+// Print render counts and times per media type since the last call
+void screen_template_print_stats(void);
+
+#endif
@@ -0,0 +1,124 @@
+// Debounced tag presence
+//
+// Elapsed times are unsigned differences, so they stay correct when <now>
+// wraps around.
+
+#include "tag_presence.h"
+#include <stdio.h>
+#include <string.h>
+
+static const char *event_names[TAG_EVENT_COUNT] = {
+    [TAG_EVENT_NONE] = "none",
+    [TAG_EVENT_PRESENT] = "present",
+    [TAG_EVENT_ARRIVED] = "arrived",
+    [TAG_EVENT_REMOVED] = "removed",
+    [TAG_EVENT_SWAPPED] = "swapped",
+};
+
+void tag_presence_init(tag_presence_t *presence, const tag_presence_config_t *config)
+{
+    memset(presence, 0, sizeof(*presence));
+    presence->config = *config;
+}
+
+static tag_event_t steady(const tag_presence_t *presence)
+{
+    return presence->present ? TAG_EVENT_PRESENT : TAG_EVENT_NONE;
+}
+
+static tag_event_t record(tag_presence_t *presence, tag_event_t event)
+{
+    presence->events[event]++;
+    return event;
+}
+
+// <tag> was read and differs from the confirmed tag
+static tag_event_t candidate_read(tag_presence_t *presence, const char *tag, uint32_t now)
+{
+    if (!presence->pending || strcmp(presence->candidate, tag) != 0)
+    {
+        presence->pending = true;
+        strncpy(presence->candidate, tag, TAG_PRESENCE_ID_SIZE - 1);
+        presence->candidate[TAG_PRESENCE_ID_SIZE - 1] = '\0';
+        presence->candidate_since = now;
+    }
+    presence->candidate_seen = now;
+
+    if (now - presence->candidate_since < presence->config.arrive_hold)
+    {
+        return steady(presence);
+    }
+
+    // Confirmed
+    tag_event_t event = presence->present ? TAG_EVENT_SWAPPED : TAG_EVENT_ARRIVED;
+    memcpy(presence->current, presence->candidate, TAG_PRESENCE_ID_SIZE);
+    presence->present = true;
+    presence->last_seen = now;
+    presence->pending = false;
+    return event;
+}
+
+tag_event_t tag_presence_update(tag_presence_t *presence, const char *tag, uint32_t now)
+{
+    presence->updates++;
+
+    if (tag != NULL && tag[0] != '\0')
+    {
+        if (presence->present && strcmp(presence->current, tag) == 0)
+        {
+            // A stray read of another tag doesn't survive the confirmed one
+            presence->last_seen = now;
+            presence->pending = false;
+            return record(presence, TAG_EVENT_PRESENT);
+        }
+        return record(presence, candidate_read(presence, tag, now));
+    }
+
+    // Nothing read. A candidate that stopped reading is dropped
+    if (presence->pending && now - presence->candidate_seen >= presence->config.remove_hold)
+    {
+        presence->pending = false;
+    }
+
+    if (presence->present && now - presence->last_seen >= presence->config.remove_hold)
+    {
+        presence->present = false;
+        presence->current[0] = '\0';
+        return record(presence, TAG_EVENT_REMOVED);
+    }
+    return record(presence, steady(presence));
+}
+
+tag_event_t tag_presence_clear(tag_presence_t *presence)
+{
+    presence->pending = false;
+    if (!presence->present)
+    {
+        return TAG_EVENT_NONE;
+    }
+    presence->present = false;
+    presence->current[0] = '\0';
+    return record(presence, TAG_EVENT_REMOVED);
+}
+
+const char *tag_presence_current(const tag_presence_t *presence)
+{
+    return presence->present ? presence->current : NULL;
+}
+
+const char *tag_event_name(tag_event_t event)
+{
+    return event < TAG_EVENT_COUNT ? event_names[event] : "?";
+}
+
+void tag_presence_print_stats(tag_presence_t *presence)
+{
+    uint32_t transitions = presence->events[TAG_EVENT_ARRIVED] + presence->events[TAG_EVENT_REMOVED] +
+                           presence->events[TAG_EVENT_SWAPPED];
+    printf("Tag presence: %lu polls, %lu transitions (%lu arrived, %lu removed, %lu swapped), now %s\n",
+           presence->updates, transitions, presence->events[TAG_EVENT_ARRIVED], presence->events[TAG_EVENT_REMOVED],
+           presence->events[TAG_EVENT_SWAPPED], presence->present ? presence->current : "empty");
+
+    presence->updates = 0;
+    memset(presence->events, 0, sizeof(presence->events));
+}
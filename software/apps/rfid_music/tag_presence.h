@@ -0,0 +1,71 @@
+#ifndef TAG_PRESENCE_H
+#define TAG_PRESENCE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Debounced tag presence
+//
+// Turns the stream of poll results, a tag ID or nothing, into state changes.
+// A new tag only counts once it has been read for the arrive hold time, and a
+// tag only counts as gone once nothing has matched it for the remove hold
+// time, so one failed read neither clears the screen nor redraws it.
+//
+// Plain C with no hardware access. Times are in whatever unit the caller
+// passes as <now>, RetroScan uses tickless_timer_now() ticks.
+
+#define TAG_PRESENCE_ID_SIZE 13 // Same as rfid_data_t.tag
+
+typedef enum
+{
+    TAG_EVENT_NONE,    // No tag, and there wasn't one before
+    TAG_EVENT_PRESENT, // The same tag is still there, nothing to redo
+    TAG_EVENT_ARRIVED, // A tag appeared on an empty reader
+    TAG_EVENT_REMOVED, // The tag has not been read for the remove hold time
+    TAG_EVENT_SWAPPED, // A different tag replaced the one present
+    TAG_EVENT_COUNT,
+} tag_event_t;
+
+typedef struct
+{
+    uint32_t arrive_hold; // A new tag must keep reading this long, 0 for the first read
+    uint32_t remove_hold; // Time without a matching read before the tag is gone
+} tag_presence_config_t;
+
+typedef struct
+{
+    tag_presence_config_t config;
+
+    bool present;
+    char current[TAG_PRESENCE_ID_SIZE]; // Confirmed tag, empty when absent
+    uint32_t last_seen;
+
+    // Tag read but not yet confirmed
+    bool pending;
+    char candidate[TAG_PRESENCE_ID_SIZE];
+    uint32_t candidate_since;
+    uint32_t candidate_seen;
+
+    uint32_t updates;
+    uint32_t events[TAG_EVENT_COUNT];
+} tag_presence_t;
+
+void tag_presence_init(tag_presence_t *presence, const tag_presence_config_t *config);
+
+// Feed one poll result. <tag> is NULL or empty when nothing was read
+// Returns the event to act on, only ARRIVED, REMOVED and SWAPPED need work
+tag_event_t tag_presence_update(tag_presence_t *presence, const char *tag, uint32_t now);
+
+// Drop the tag at once, e.g. when the pad was emptied and the reader stopped
+// Returns REMOVED if a tag was present, NONE otherwise
+tag_event_t tag_presence_clear(tag_presence_t *presence);
+
+// The confirmed tag, or NULL when the reader is empty
+const char *tag_presence_current(const tag_presence_t *presence);
+
+const char *tag_event_name(tag_event_t event);
+
+// Print poll and event counts since the last call
+void tag_presence_print_stats(tag_presence_t *presence);
+
+#endif
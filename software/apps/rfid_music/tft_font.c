@@ -0,0 +1,86 @@
+// Bitmap fonts for the TFT
+//
+// A lookup walks the font's ranges, a handful at most, so fetching a glyph
+// costs a few dozen cycles next to the thousands its SPI transfer takes.
+
+#include "tft_font.h"
+#include <stdio.h>
+#include "font_data.h"
+#include "nrf.h"
+
+// Statistics
+static uint32_t fetches = 0;
+static uint32_t fetch_cycles = 0;
+static uint32_t misses = 0;
+
+static const uint8_t *find_glyph(const tft_font_t *font, uint8_t code, uint8_t *width)
+{
+    for (uint8_t i = 0; i < font->range_count; i++)
+    {
+        const tft_font_range_t *range = &font->ranges[i];
+        if (code >= range->first && code <= range->last)
+        {
+            uint16_t glyph = range->glyph + (code - range->first);
+            *width = font->widths ? font->widths[glyph] : font->advance;
+            return &font->rows[glyph * font->height];
+        }
+    }
+    return NULL;
+}
+
+const uint8_t *tft_font_glyph(const tft_font_t *font, char c, uint8_t *width)
+{
+    uint32_t start = DWT->CYCCNT;
+
+    const uint8_t *rows = find_glyph(font, (uint8_t)c, width);
+    if (rows == NULL)
+    {
+        misses++;
+        rows = find_glyph(font, ' ', width);
+    }
+
+    fetch_cycles += DWT->CYCCNT - start;
+    fetches++;
+    return rows;
+}
+
+uint16_t tft_font_text_width(const tft_font_t *font, const char *text, uint8_t scale)
+{
+    uint16_t width = 0;
+    for (; *text != '\0'; text++)
+    {
+        uint8_t glyph_width = font->advance;
+        if (font->widths != NULL)
+        {
+            find_glyph(font, (uint8_t)*text, &glyph_width);
+        }
+        width += (glyph_width + font->spacing) * scale;
+    }
+    return width;
+}
+
+uint32_t tft_font_flash_bytes(const tft_font_t *font)
+{
+    uint32_t bytes = font->glyph_count * font->height + font->range_count * sizeof(tft_font_range_t);
+    if (font->widths != NULL)
+    {
+        bytes += font->glyph_count;
+    }
+    return bytes;
+}
+
+void tft_font_print_stats(void)
+{
+    for (int i = 0; i < TFT_FONT_COUNT; i++)
+    {
+        const tft_font_t *font = tft_fonts[i];
+        printf("Font %s: %u glyphs in %u ranges, %lu bytes flash\n",
+               font->name, font->glyph_count, font->range_count, tft_font_flash_bytes(font));
+    }
+    printf("Font: %lu glyph fetches, avg %lu cycles, %lu missing\n",
+           fetches, fetches ? fetch_cycles / fetches : 0, misses);
+
+    fetches = 0;
+    fetch_cycles = 0;
+    misses = 0;
+}
@@ -0,0 +1,47 @@
+#ifndef TFT_FONT_H
+#define TFT_FONT_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Bitmap fonts for the TFT
+//
+// The glyph tables are generated by software/tools/font_gen.py into
+// font_data.c, one shared copy per font. Only the characters a font defines
+// are stored, as ranges of code points.
+
+// Code points first..last are glyphs glyph..glyph + (last - first)
+typedef struct
+{
+    uint8_t first;
+    uint8_t last;
+    uint16_t glyph;
+} tft_font_range_t;
+
+typedef struct
+{
+    const char *name;
+    uint8_t height;
+    uint8_t advance; // Width of every glyph, 0 for proportional fonts
+    uint8_t spacing; // Blank columns after each glyph
+    uint8_t range_count;
+    uint16_t glyph_count;
+    const tft_font_range_t *ranges;
+    const uint8_t *widths; // Per glyph, NULL when every glyph is <advance> wide
+    const uint8_t *rows;   // <height> bytes per glyph, MSB drawn first
+} tft_font_t;
+
+// Rows of the glyph for <c>, and its width in <width>
+// Characters the font lacks come back as its space
+const uint8_t *tft_font_glyph(const tft_font_t *font, char c, uint8_t *width);
+
+// Width of <text> in pixels, spacing included
+uint16_t tft_font_text_width(const tft_font_t *font, const char *text, uint8_t scale);
+
+// Bytes of flash taken by <font>'s tables
+uint32_t tft_font_flash_bytes(const tft_font_t *font);
+
+// Print flash use per font, and glyph lookups and their cost since the last call
+void tft_font_print_stats(void);
+
+#endif
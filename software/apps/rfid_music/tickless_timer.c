@@ -0,0 +1,476 @@
+// Tickless timer service
+//
+// Keeps a small table of deadlines and arms exactly one RTC wakeup for the
+// earliest of them. Precise deadlines are handed to TIMER4 shortly
+// before they expire; HFCLK is requested only while TIMER4 is running.
+// The other peripherals that run on HFCLK request it themselves and only
+// report their busy spans here, so the report covers every HFCLK user.
+
+#include "tickless_timer.h"
+#include <stdio.h>
+#include "nrf.h"
+#include "app_timer.h"
+#include "app_util_platform.h"
+#include "nrf_drv_clock.h"
+#include "nrf_pwr_mgmt.h"
+
+// Longest single RTC sleep. Keeps the 24-bit RTC counter from wrapping
+// between two reads, so tickless_timer_now() never loses time
+#define MAX_SLEEP_TICKS 0x7FFFFF
+
+#define TIMER4_IRQ_PRIORITY APP_TIMER_CONFIG_IRQ_PRIORITY
+
+typedef struct
+{
+    bool active;
+    bool repeated;
+    bool on_timer4;               // Final window is being timed by TIMER4
+    tickless_precision_t precision;
+    uint8_t generation;           // Makes IDs of reused slots unique
+    uint32_t deadline;            // RTC ticks
+    uint32_t timer4_deadline;     // TIMER4 microseconds, valid when on_timer4
+    uint32_t period_us;
+    tickless_timer_callback_t cb;
+    void *context;
+} tickless_slot_t;
+
+static tickless_slot_t slots[TICKLESS_MAX_TIMERS];
+
+APP_TIMER_DEF(rtc_wake_timer);
+
+// Extended RTC time
+static uint32_t last_rtc_count = 0;
+static uint32_t now_ticks = 0;
+
+// Clock domain accounting. Each HFCLK user is timed on its own, and the
+// time any of them was running is kept apart since they overlap
+typedef struct
+{
+    uint8_t nesting;
+    uint32_t on_since;
+    uint32_t ticks;
+} hf_usage_t;
+
+static const char *hf_user_names[TICKLESS_HF_USER_COUNT] = {
+    [TICKLESS_HF_TIMER4] = "TIMER4",
+    [TICKLESS_HF_SPIM3] = "SPIM3",
+    [TICKLESS_HF_TWIM] = "TWIM",
+    [TICKLESS_HF_TIMER0] = "TIMER0",
+    [TICKLESS_HF_TIMER3] = "TIMER3",
+    [TICKLESS_HF_SAADC] = "SAADC",
+};
+
+static bool initialized = false;
+static bool hfclk_on = false; // TIMER4 is running and holds an HFCLK request
+static hf_usage_t hf_users[TICKLESS_HF_USER_COUNT];
+static hf_usage_t hf_any;
+static uint32_t sleep_ticks = 0;
+static uint32_t rtc_wakeups = 0;
+static uint32_t timer4_handoffs = 0;
+
+static void schedule(void);
+
+static uint32_t us_to_ticks(uint32_t microseconds)
+{
+    return (uint32_t)(((uint64_t)microseconds * TICKLESS_TICK_HZ + 999999) / 1000000);
+}
+
+static uint32_t ticks_to_us(uint32_t ticks)
+{
+    return (uint32_t)(((uint64_t)ticks * 1000000) / TICKLESS_TICK_HZ);
+}
+
+static uint32_t ticks_to_ms(uint32_t ticks)
+{
+    return (uint32_t)(((uint64_t)ticks * 1000) / TICKLESS_TICK_HZ);
+}
+
+// True if time <a> is at or before time <b>, safe across counter wrap
+static bool time_reached(uint32_t a, uint32_t b)
+{
+    return (int32_t)(a - b) <= 0;
+}
+
+uint32_t tickless_timer_now(void)
+{
+    uint32_t now;
+
+    CRITICAL_REGION_ENTER();
+    uint32_t count = app_timer_cnt_get();
+    now_ticks += app_timer_cnt_diff_compute(count, last_rtc_count);
+    last_rtc_count = count;
+    now = now_ticks;
+    CRITICAL_REGION_EXIT();
+    return now;
+}
+
+static uint32_t timer4_now(void)
+{
+    NRF_TIMER4->TASKS_CAPTURE[1] = 1;
+    return NRF_TIMER4->CC[1];
+}
+
+// Start TIMER4 and request HFCLK if nothing is using it yet
+static void timer4_acquire(void)
+{
+    if (hfclk_on)
+    {
+        return;
+    }
+    nrf_drv_clock_hfclk_request(NULL);
+    NRF_TIMER4->TASKS_CLEAR = 1;
+    NRF_TIMER4->TASKS_START = 1;
+    hfclk_on = true;
+    tickless_timer_hf_begin(TICKLESS_HF_TIMER4);
+}
+
+// Stop TIMER4 and let HFCLK turn off again
+static void timer4_release(void)
+{
+    if (!hfclk_on)
+    {
+        return;
+    }
+    NRF_TIMER4->TASKS_STOP = 1;
+    NRF_TIMER4->EVENTS_COMPARE[0] = 0;
+    nrf_drv_clock_hfclk_release();
+    hfclk_on = false;
+    tickless_timer_hf_end(TICKLESS_HF_TIMER4);
+}
+
+// Start or stop timing <usage>, nested calls count once
+static void hf_usage_begin(hf_usage_t *usage, uint32_t now)
+{
+    if (usage->nesting++ == 0)
+    {
+        usage->on_since = now;
+    }
+}
+
+static void hf_usage_end(hf_usage_t *usage, uint32_t now)
+{
+    if (usage->nesting > 0 && --usage->nesting == 0)
+    {
+        usage->ticks += now - usage->on_since;
+    }
+}
+
+static uint32_t hf_usage_ticks(const hf_usage_t *usage, uint32_t now)
+{
+    return usage->ticks + (usage->nesting ? now - usage->on_since : 0);
+}
+
+void tickless_timer_hf_begin(tickless_hf_user_t user)
+{
+    if (!initialized || user >= TICKLESS_HF_USER_COUNT)
+    {
+        return;
+    }
+    CRITICAL_REGION_ENTER();
+    uint32_t now = tickless_timer_now();
+    if (hf_users[user].nesting == 0)
+    {
+        hf_usage_begin(&hf_any, now);
+    }
+    hf_usage_begin(&hf_users[user], now);
+    CRITICAL_REGION_EXIT();
+}
+
+void tickless_timer_hf_end(tickless_hf_user_t user)
+{
+    if (!initialized || user >= TICKLESS_HF_USER_COUNT)
+    {
+        return;
+    }
+    CRITICAL_REGION_ENTER();
+    uint32_t now = tickless_timer_now();
+    if (hf_users[user].nesting == 1)
+    {
+        hf_usage_end(&hf_any, now);
+    }
+    hf_usage_end(&hf_users[user], now);
+    CRITICAL_REGION_EXIT();
+}
+
+static void fire(tickless_slot_t *slot)
+{
+    tickless_timer_callback_t cb = slot->cb;
+    void *context = slot->context;
+
+    if (slot->repeated)
+    {
+        slot->deadline += us_to_ticks(slot->period_us);
+        if (slot->on_timer4 && slot->period_us <= TICKLESS_PRECISE_WINDOW_US)
+        {
+            // Short precise periods stay on TIMER4
+            slot->timer4_deadline += slot->period_us;
+        }
+        else
+        {
+            slot->on_timer4 = false;
+        }
+    }
+    else
+    {
+        slot->active = false;
+    }
+
+    cb(context);
+}
+
+// Move precise deadlines that are inside the window onto TIMER4
+static void handoff_precise(uint32_t now)
+{
+    uint32_t window = us_to_ticks(TICKLESS_PRECISE_WINDOW_US);
+
+    for (int i = 0; i < TICKLESS_MAX_TIMERS; i++)
+    {
+        tickless_slot_t *slot = &slots[i];
+        if (slot->active && slot->precision == TICKLESS_PRECISE && !slot->on_timer4 &&
+            time_reached(slot->deadline, now + window))
+        {
+            timer4_acquire();
+            uint32_t remaining = time_reached(slot->deadline, now) ? 0 : slot->deadline - now;
+            slot->timer4_deadline = timer4_now() + ticks_to_us(remaining);
+            slot->on_timer4 = true;
+            timer4_handoffs++;
+        }
+    }
+}
+
+static void rtc_wake_handler(void *context)
+{
+    uint32_t now = tickless_timer_now();
+    rtc_wakeups++;
+
+    for (int i = 0; i < TICKLESS_MAX_TIMERS; i++)
+    {
+        tickless_slot_t *slot = &slots[i];
+        if (slot->active && slot->precision == TICKLESS_COARSE && time_reached(slot->deadline, now))
+        {
+            fire(slot);
+        }
+    }
+
+    handoff_precise(now);
+    schedule();
+}
+
+void TIMER4_IRQHandler(void)
+{
+    NRF_TIMER4->EVENTS_COMPARE[0] = 0;
+
+    uint32_t now_us = timer4_now();
+    for (int i = 0; i < TICKLESS_MAX_TIMERS; i++)
+    {
+        tickless_slot_t *slot = &slots[i];
+        if (slot->active && slot->on_timer4 && time_reached(slot->timer4_deadline, now_us))
+        {
+            fire(slot);
+        }
+    }
+
+    schedule();
+}
+
+// Arm the RTC for the earliest coarse deadline (or precise handoff) and
+// TIMER4 for the earliest deadline inside the precise window
+static void schedule(void)
+{
+    uint32_t now = tickless_timer_now();
+    uint32_t window = us_to_ticks(TICKLESS_PRECISE_WINDOW_US);
+    uint32_t rtc_sleep = MAX_SLEEP_TICKS;
+    bool timer4_needed = false;
+    uint32_t timer4_deadline = 0;
+
+    for (int i = 0; i < TICKLESS_MAX_TIMERS; i++)
+    {
+        tickless_slot_t *slot = &slots[i];
+        if (!slot->active)
+        {
+            continue;
+        }
+
+        if (slot->on_timer4)
+        {
+            if (!timer4_needed || time_reached(slot->timer4_deadline, timer4_deadline))
+            {
+                timer4_deadline = slot->timer4_deadline;
+            }
+            timer4_needed = true;
+            continue;
+        }
+
+        uint32_t wake_at = slot->deadline;
+        if (slot->precision == TICKLESS_PRECISE)
+        {
+            wake_at -= window;
+        }
+        uint32_t sleep = time_reached(wake_at, now) ? 0 : wake_at - now;
+        if (sleep < rtc_sleep)
+        {
+            rtc_sleep = sleep;
+        }
+    }
+
+    if (timer4_needed)
+    {
+        NRF_TIMER4->CC[0] = timer4_deadline;
+        if (time_reached(timer4_deadline, timer4_now()))
+        {
+            // Already late, run the handler right away
+            NVIC_SetPendingIRQ(TIMER4_IRQn);
+        }
+    }
+    else
+    {
+        timer4_release();
+    }
+
+    if (rtc_sleep < APP_TIMER_MIN_TIMEOUT_TICKS)
+    {
+        rtc_sleep = APP_TIMER_MIN_TIMEOUT_TICKS;
+    }
+    app_timer_stop(rtc_wake_timer);
+    app_timer_start(rtc_wake_timer, rtc_sleep, NULL);
+}
+
+void tickless_timer_init(void)
+{
+    ret_code_t err_code = nrf_drv_clock_init();
+    if (err_code != NRF_ERROR_MODULE_ALREADY_INITIALIZED)
+    {
+        APP_ERROR_CHECK(err_code);
+    }
+    nrf_drv_clock_lfclk_request(NULL);
+
+    err_code = app_timer_init();
+    APP_ERROR_CHECK(err_code);
+    err_code = app_timer_create(&rtc_wake_timer, APP_TIMER_MODE_SINGLE_SHOT, rtc_wake_handler);
+    APP_ERROR_CHECK(err_code);
+
+    err_code = nrf_pwr_mgmt_init();
+    APP_ERROR_CHECK(err_code);
+
+    // TIMER4: 32-bit, 1 MHz, stopped until a precise deadline needs it
+    NRF_TIMER4->MODE = TIMER_MODE_MODE_Timer;
+    NRF_TIMER4->BITMODE = TIMER_BITMODE_BITMODE_32Bit;
+    NRF_TIMER4->PRESCALER = 4;
+    NRF_TIMER4->INTENSET = 1 << TIMER_INTENSET_COMPARE0_Pos;
+
+    // Same priority as app_timer so the two handlers never preempt each other
+    NVIC_ClearPendingIRQ(TIMER4_IRQn);
+    NVIC_SetPriority(TIMER4_IRQn, TIMER4_IRQ_PRIORITY);
+    NVIC_EnableIRQ(TIMER4_IRQn);
+
+    last_rtc_count = app_timer_cnt_get();
+    now_ticks = 0;
+    initialized = true;
+}
+
+uint32_t tickless_timer_start(uint32_t microseconds, bool repeated, tickless_precision_t precision,
+                              tickless_timer_callback_t cb, void *context)
+{
+    uint32_t timer_id = 0;
+
+    CRITICAL_REGION_ENTER();
+    for (int i = 0; i < TICKLESS_MAX_TIMERS; i++)
+    {
+        tickless_slot_t *slot = &slots[i];
+        if (!slot->active)
+        {
+            slot->active = true;
+            slot->repeated = repeated;
+            slot->on_timer4 = false;
+            slot->precision = precision;
+            slot->generation++;
+            slot->deadline = tickless_timer_now() + us_to_ticks(microseconds);
+            slot->period_us = microseconds;
+            slot->cb = cb;
+            slot->context = context;
+
+            if (precision == TICKLESS_PRECISE && microseconds <= TICKLESS_PRECISE_WINDOW_US)
+            {
+                // Short precise deadlines skip the RTC entirely
+                timer4_acquire();
+                slot->timer4_deadline = timer4_now() + microseconds;
+                slot->on_timer4 = true;
+                timer4_handoffs++;
+            }
+
+            timer_id = ((uint32_t)slot->generation << 8) | (i + 1);
+            schedule();
+            break;
+        }
+    }
+    CRITICAL_REGION_EXIT();
+
+    return timer_id;
+}
+
+void tickless_timer_cancel(uint32_t timer_id)
+{
+    uint32_t index = (timer_id & 0xFF) - 1;
+    if (index >= TICKLESS_MAX_TIMERS)
+    {
+        return;
+    }
+
+    CRITICAL_REGION_ENTER();
+    tickless_slot_t *slot = &slots[index];
+    if (slot->active && slot->generation == (uint8_t)(timer_id >> 8))
+    {
+        slot->active = false;
+        schedule();
+    }
+    CRITICAL_REGION_EXIT();
+}
+
+void tickless_timer_idle(void)
+{
+    uint32_t start = tickless_timer_now();
+    nrf_pwr_mgmt_run();
+    sleep_ticks += tickless_timer_now() - start;
+}
+
+static void print_share(const char *name, uint32_t ticks, uint32_t total)
+{
+    printf("  %-12s: %lu ms (%lu.%02lu%%)", name, ticks_to_ms(ticks),
+           (uint32_t)((uint64_t)ticks * 100 / total), (uint32_t)((uint64_t)ticks * 10000 / total % 100));
+}
+
+void tickless_timer_print_report(void)
+{
+    uint32_t now = tickless_timer_now();
+    uint32_t total = now ? now : 1;
+
+    printf("Clock domain report (%lu ms since init):\n", ticks_to_ms(now));
+    printf("  LFCLK/RTC   : %lu ms (100%%), %lu wakeups\n", ticks_to_ms(now), rtc_wakeups);
+
+    // The users overlap, so the HFCLK line is the union and not their sum
+    uint32_t any;
+    uint32_t user_ticks[TICKLESS_HF_USER_COUNT];
+    CRITICAL_REGION_ENTER();
+    any = hf_usage_ticks(&hf_any, now);
+    for (int user = 0; user < TICKLESS_HF_USER_COUNT; user++)
+    {
+        user_ticks[user] = hf_usage_ticks(&hf_users[user], now);
+    }
+    CRITICAL_REGION_EXIT();
+
+    print_share("HFCLK", any, total);
+    printf(", any user\n");
+    for (int user = 0; user < TICKLESS_HF_USER_COUNT; user++)
+    {
+        char name[16];
+        snprintf(name, sizeof(name), " %s", hf_user_names[user]);
+        print_share(name, user_ticks[user], total);
+        if (user == TICKLESS_HF_TIMER4)
+        {
+            printf(", %lu handoffs", timer4_handoffs);
+        }
+        printf("\n");
+    }
+    printf("  CPU asleep  : %lu ms (%lu%%)\n", ticks_to_ms(sleep_ticks),
+           (uint32_t)((uint64_t)sleep_ticks * 100 / total));
+}
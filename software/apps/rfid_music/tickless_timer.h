@@ -0,0 +1,66 @@
+#ifndef TICKLESS_TIMER_H
+#define TICKLESS_TIMER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Tickless timer service
+//
+// Every deadline is kept on the 32.768 kHz RTC (through app_timer), so the
+// high-frequency clock can stay off while the CPU sleeps. Only precise
+// deadlines are moved onto TIMER4 (1 MHz, needs HFCLK), and only for the last
+// TICKLESS_PRECISE_WINDOW_US before they expire.
+
+#define TICKLESS_MAX_TIMERS 8
+#define TICKLESS_PRECISE_WINDOW_US 2000 // How early a precise deadline is handed to TIMER4
+#define TICKLESS_TICK_HZ 32768          // RTC tick rate used by tickless_timer_now()
+
+typedef void (*tickless_timer_callback_t)(void *context);
+
+typedef enum
+{
+    TICKLESS_COARSE,  // RTC resolution (~30.5 us), HFCLK stays off
+    TICKLESS_PRECISE, // 1 us resolution, HFCLK runs for the final window
+} tickless_precision_t;
+
+// Peripherals that keep HFCLK running while they work
+typedef enum
+{
+    TICKLESS_HF_TIMER4, // Precise deadlines, requested by this service
+    TICKLESS_HF_SPIM3,  // Display transfers
+    TICKLESS_HF_TWIM,   // Qwiic bus transactions
+    TICKLESS_HF_TIMER0, // Touch bursts
+    TICKLESS_HF_TIMER3, // LED matrix refresh
+    TICKLESS_HF_SAADC,  // Weight sample bursts
+    TICKLESS_HF_USER_COUNT,
+} tickless_hf_user_t;
+
+// Initialize the timer service, app_timer (RTC1) and power management
+// app_timer_init() and nrf_drv_clock_init() are called here
+void tickless_timer_init(void);
+
+// Start a timer that calls <cb> with <context> <microseconds> in the future
+// Returns a timer ID, or 0 if no timer slot was free
+uint32_t tickless_timer_start(uint32_t microseconds, bool repeated, tickless_precision_t precision,
+                              tickless_timer_callback_t cb, void *context);
+
+// Stop a timer so that it no longer fires. Unknown or expired IDs are ignored
+void tickless_timer_cancel(uint32_t timer_id);
+
+// RTC ticks since tickless_timer_init(), extended to 32 bits
+uint32_t tickless_timer_now(void);
+
+// Sleep until the next interrupt. Call this from the main loop
+void tickless_timer_idle(void);
+
+// Mark when <user> starts and stops running on HFCLK. For the report only,
+// the peripheral still requests the clock itself. Safe from interrupts,
+// nested calls count once and calls before init are ignored
+void tickless_timer_hf_begin(tickless_hf_user_t user);
+void tickless_timer_hf_end(tickless_hf_user_t user);
+
+// Print how long each clock domain has been active since init, with HFCLK
+// broken down by user
+void tickless_timer_print_report(void);
+
+#endif
@@ -0,0 +1,171 @@
+// Weight filtering and calibration
+//
+// The IIR state keeps 8 fractional bits so the 1/4 step doesn't stall a few
+// counts short of a new weight. Calibration interpolates in 64 bits, since a
+// 12-bit reading times a span of several pounds in hundredths overflows 32.
+
+#include "weight_filter.h"
+#include <string.h>
+
+#define IIR_FRACTION_BITS 8
+
+const weight_calibration_t weight_default_calibration = {
+    .count = 2,
+    .points = {
+        {0, 200},
+        {4095, 4295},
+    },
+};
+
+void weight_filter_init(weight_filter_t *filter)
+{
+    filter->state = 0;
+    filter->primed = false;
+}
+
+static int32_t median(const int16_t *samples, uint8_t count)
+{
+    int16_t sorted[WEIGHT_FILTER_MAX_SAMPLES];
+    if (count > WEIGHT_FILTER_MAX_SAMPLES)
+    {
+        count = WEIGHT_FILTER_MAX_SAMPLES;
+    }
+
+    // Insertion sort, the burst is only a handful of readings
+    for (uint8_t i = 0; i < count; i++)
+    {
+        int16_t value = samples[i];
+        uint8_t j = i;
+        while (j > 0 && sorted[j - 1] > value)
+        {
+            sorted[j] = sorted[j - 1];
+            j--;
+        }
+        sorted[j] = value;
+    }
+    return sorted[count / 2];
+}
+
+int32_t weight_filter_update(weight_filter_t *filter, const int16_t *samples, uint8_t count)
+{
+    if (count == 0)
+    {
+        return filter->state >> IIR_FRACTION_BITS;
+    }
+
+    int32_t input = median(samples, count) << IIR_FRACTION_BITS;
+    if (!filter->primed)
+    {
+        // Start from the first reading rather than ramping up from zero
+        filter->state = input;
+        filter->primed = true;
+    }
+    else
+    {
+        filter->state += (input - filter->state) >> WEIGHT_FILTER_IIR_SHIFT;
+    }
+    return (filter->state + (1 << (IIR_FRACTION_BITS - 1))) >> IIR_FRACTION_BITS;
+}
+
+int32_t weight_calibrate(const weight_calibration_t *calibration, int32_t raw)
+{
+    const weight_cal_point_t *points = calibration->points;
+    if (calibration->count < 2)
+    {
+        return calibration->count ? points[0].centi_oz : 0;
+    }
+
+    // Segment containing raw, or the first or last one to extend
+    uint32_t i = 0;
+    while (i + 2 < calibration->count && raw > points[i + 1].raw)
+    {
+        i++;
+    }
+
+    const weight_cal_point_t *low = &points[i];
+    const weight_cal_point_t *high = &points[i + 1];
+    int64_t span = (int64_t)(high->centi_oz - low->centi_oz) * (raw - low->raw);
+    return low->centi_oz + (int32_t)(span / (high->raw - low->raw));
+}
+
+bool weight_calibration_valid(const weight_calibration_t *calibration)
+{
+    if (calibration->count < 2 || calibration->count > WEIGHT_CAL_MAX_POINTS)
+    {
+        return false;
+    }
+    for (uint32_t i = 1; i < calibration->count; i++)
+    {
+        if (calibration->points[i].raw <= calibration->points[i - 1].raw)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool weight_calibration_insert(weight_calibration_t *calibration, int32_t raw, int32_t centi_oz)
+{
+    weight_cal_point_t *points = calibration->points;
+    uint32_t i = 0;
+    while (i < calibration->count && points[i].raw < raw)
+    {
+        i++;
+    }
+
+    if (i < calibration->count && points[i].raw == raw)
+    {
+        points[i].centi_oz = centi_oz;
+        return true;
+    }
+    if (calibration->count == WEIGHT_CAL_MAX_POINTS)
+    {
+        return false;
+    }
+
+    memmove(&points[i + 1], &points[i], (calibration->count - i) * sizeof(points[0]));
+    points[i].raw = raw;
+    points[i].centi_oz = centi_oz;
+    calibration->count++;
+    return true;
+}
+
+void weight_hysteresis_init(weight_hysteresis_t *hysteresis)
+{
+    hysteresis->shown = 0;
+    hysteresis->present = false;
+}
+
+bool weight_hysteresis_update(weight_hysteresis_t *hysteresis, int32_t centi_oz)
+{
+    if (!hysteresis->present)
+    {
+        if (centi_oz < WEIGHT_PRESENT_CENTI_OZ)
+        {
+            return false;
+        }
+        hysteresis->present = true;
+        hysteresis->shown = centi_oz / 100;
+        return true;
+    }
+
+    if (centi_oz < WEIGHT_ABSENT_CENTI_OZ)
+    {
+        hysteresis->present = false;
+        hysteresis->shown = 0;
+        return true;
+    }
+
+    // Keep the shown ounce until the weight is clearly outside it
+    int32_t low = hysteresis->shown * 100 - WEIGHT_HYSTERESIS_CENTI_OZ;
+    int32_t high = (hysteresis->shown + 1) * 100 + WEIGHT_HYSTERESIS_CENTI_OZ;
+    if (centi_oz >= low && centi_oz < high)
+    {
+        return false;
+    }
+
+    int32_t shown = centi_oz / 100;
+    bool changed = shown != hysteresis->shown;
+    hysteresis->shown = shown;
+    return changed;
+}
@@ -0,0 +1,80 @@
+#ifndef WEIGHT_FILTER_H
+#define WEIGHT_FILTER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Weight filtering and calibration
+//
+// Plain integer C with no hardware access, so recorded ADC traces can be
+// replayed through it on a PC. Weights are in hundredths of an ounce.
+//
+// Each update takes a short burst of oversampled ADC readings, keeps their
+// median to drop single spikes, then smooths successive medians with a first
+// order IIR filter. The result goes through a piecewise-linear calibration
+// table and a hysteresis stage that only reports a change once the weight has
+// moved clearly past the displayed whole ounce.
+
+#define WEIGHT_FILTER_MAX_SAMPLES 9
+#define WEIGHT_FILTER_IIR_SHIFT 2 // New median weighs 1/4
+#define WEIGHT_CAL_MAX_POINTS 8
+
+// Below this the plate is treated as empty (2.9 oz)
+#define WEIGHT_PRESENT_CENTI_OZ 290
+#define WEIGHT_ABSENT_CENTI_OZ 260
+
+// Distance past a whole ounce boundary before the displayed value changes
+#define WEIGHT_HYSTERESIS_CENTI_OZ 20
+
+typedef struct
+{
+    int32_t raw;     // Filtered ADC reading
+    int32_t centi_oz;
+} weight_cal_point_t;
+
+// Points sorted by raw reading, at least two
+typedef struct
+{
+    uint32_t count;
+    weight_cal_point_t points[WEIGHT_CAL_MAX_POINTS];
+} weight_calibration_t;
+
+typedef struct
+{
+    int32_t state; // IIR output, 8 fractional bits
+    bool primed;
+} weight_filter_t;
+
+typedef struct
+{
+    int32_t shown;  // Whole ounces last reported, 0 when empty
+    bool present;
+} weight_hysteresis_t;
+
+// Calibration equivalent to the original fit, weight = raw * 0.01 + 2 oz
+extern const weight_calibration_t weight_default_calibration;
+
+void weight_filter_init(weight_filter_t *filter);
+
+// Median of <count> readings, fed into the IIR filter
+// Returns the filtered reading
+int32_t weight_filter_update(weight_filter_t *filter, const int16_t *samples, uint8_t count);
+
+// Convert a filtered reading with the calibration table
+// Readings outside the table extend its first or last segment
+int32_t weight_calibrate(const weight_calibration_t *calibration, int32_t raw);
+
+// Whether <calibration> is sorted, non-empty and fits the table
+bool weight_calibration_valid(const weight_calibration_t *calibration);
+
+// Add or replace the point at <raw>, keeping the table sorted
+// Returns false if the table is full
+bool weight_calibration_insert(weight_calibration_t *calibration, int32_t raw, int32_t centi_oz);
+
+void weight_hysteresis_init(weight_hysteresis_t *hysteresis);
+
+// Feed a calibrated weight. Returns true when the whole ounces to display
+// changed, including to and from an empty plate
+bool weight_hysteresis_update(weight_hysteresis_t *hysteresis, int32_t centi_oz);
+
+#endif
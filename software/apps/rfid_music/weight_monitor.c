@@ -0,0 +1,183 @@
+// Low-power watch for a change on the item plate
+//
+// PPI wiring while armed:
+//   RTC2 TICK           -> SAADC SAMPLE   (16 conversions averaged, in burst)
+//   SAADC END           -> SAADC START    (re-arm the one-word result buffer)
+//   SAADC CH0 LIMITH    -> EGU3 TRIGGER0  (something was placed)
+//   SAADC CH0 LIMITL    -> EGU3 TRIGGER1  (something was lifted)
+//
+// The nrfx SAADC driver owns the SAADC interrupt, so the driver is shut down
+// while armed and the limit events are routed to EGU3 to get an interrupt of
+// our own. RTC2 runs from the LFCLK the app timer already keeps on, and its
+// counter doubles as a count of samples taken. HFCLK is only requested by the
+// SAADC for the ~200 us each reading takes.
+
+#include "weight_monitor.h"
+#include <stdio.h>
+#include "app_error.h"
+#include "nrf.h"
+#include "nrfx_ppi.h"
+#include "weight_sensor.h"
+
+// RTC2 TICK rate is 32768 / (PRESCALER + 1)
+#define RTC_PRESCALER ((32768 * WEIGHT_MONITOR_INTERVAL_MS) / 1000 - 1)
+
+// Below the event queue's timers, it only posts an event
+#define EGU_IRQ_PRIORITY 6
+
+// Same channel setup as weight_sensor: AIN0, gain 1/6, internal reference,
+// 10 us acquisition, burst on
+#define CHANNEL_CONFIG ((0UL << SAADC_CH_CONFIG_GAIN_Pos) | \
+                        (2UL << SAADC_CH_CONFIG_TACQ_Pos) | \
+                        (1UL << SAADC_CH_CONFIG_BURST_Pos))
+
+typedef enum
+{
+    PPI_TICK_SAMPLE,
+    PPI_END_START,
+    PPI_LIMIT_HIGH,
+    PPI_LIMIT_LOW,
+    PPI_COUNT,
+} monitor_ppi_t;
+
+static nrf_ppi_channel_t channels[PPI_COUNT];
+static weight_monitor_callback_t monitor_callback = NULL;
+static volatile bool armed = false;
+static int16_t result; // Written by SAADC EasyDMA, never read
+
+// Statistics
+static uint32_t samples = 0;
+static uint32_t counter_base = 0; // RTC2 counter already added to samples
+static uint32_t wakeups = 0;
+static uint32_t arms = 0;
+
+void SWI3_EGU3_IRQHandler(void)
+{
+    bool placed = NRF_EGU3->EVENTS_TRIGGERED[0];
+    NRF_EGU3->EVENTS_TRIGGERED[0] = 0;
+    NRF_EGU3->EVENTS_TRIGGERED[1] = 0;
+
+    // Every reading past the window would fire again, report just the first
+    nrfx_ppi_channel_disable(channels[PPI_LIMIT_HIGH]);
+    nrfx_ppi_channel_disable(channels[PPI_LIMIT_LOW]);
+    wakeups++;
+
+    if (monitor_callback != NULL)
+    {
+        monitor_callback(placed);
+    }
+}
+
+void weight_monitor_init(weight_monitor_callback_t callback)
+{
+    monitor_callback = callback;
+
+    for (int i = 0; i < PPI_COUNT; i++)
+    {
+        ret_code_t err_code = nrfx_ppi_channel_alloc(&channels[i]);
+        APP_ERROR_CHECK(err_code);
+    }
+    nrfx_ppi_channel_assign(channels[PPI_TICK_SAMPLE],
+                            (uint32_t)&NRF_RTC2->EVENTS_TICK, (uint32_t)&NRF_SAADC->TASKS_SAMPLE);
+    nrfx_ppi_channel_assign(channels[PPI_END_START],
+                            (uint32_t)&NRF_SAADC->EVENTS_END, (uint32_t)&NRF_SAADC->TASKS_START);
+    nrfx_ppi_channel_assign(channels[PPI_LIMIT_HIGH],
+                            (uint32_t)&NRF_SAADC->EVENTS_CH[0].LIMITH, (uint32_t)&NRF_EGU3->TASKS_TRIGGER[0]);
+    nrfx_ppi_channel_assign(channels[PPI_LIMIT_LOW],
+                            (uint32_t)&NRF_SAADC->EVENTS_CH[0].LIMITL, (uint32_t)&NRF_EGU3->TASKS_TRIGGER[1]);
+
+    NRF_RTC2->TASKS_STOP = 1;
+    NRF_RTC2->PRESCALER = RTC_PRESCALER;
+    NRF_RTC2->EVTENSET = RTC_EVTEN_TICK_Msk;
+
+    NRF_EGU3->INTENSET = 0x3;
+    NVIC_ClearPendingIRQ(SWI3_EGU3_IRQn);
+    NVIC_SetPriority(SWI3_EGU3_IRQn, EGU_IRQ_PRIORITY);
+    NVIC_EnableIRQ(SWI3_EGU3_IRQn);
+}
+
+void weight_monitor_start(int32_t baseline)
+{
+    if (armed)
+    {
+        return;
+    }
+    weight_sensor_suspend();
+
+    int32_t low = baseline - WEIGHT_MONITOR_MARGIN;
+    int32_t high = baseline + WEIGHT_MONITOR_MARGIN;
+    NRF_SAADC->INTENCLR = 0xFFFFFFFF;
+    NRF_SAADC->RESOLUTION = SAADC_RESOLUTION_VAL_12bit;
+    NRF_SAADC->OVERSAMPLE = SAADC_OVERSAMPLE_OVERSAMPLE_Over16x;
+    NRF_SAADC->SAMPLERATE = SAADC_SAMPLERATE_MODE_Task;
+    NRF_SAADC->CH[0].PSELP = SAADC_CH_PSELP_PSELP_AnalogInput0;
+    NRF_SAADC->CH[0].CONFIG = CHANNEL_CONFIG;
+    NRF_SAADC->CH[0].LIMIT = ((uint32_t)(uint16_t)high << SAADC_CH_LIMIT_HIGH_Pos) |
+                             ((uint32_t)(uint16_t)low << SAADC_CH_LIMIT_LOW_Pos);
+    NRF_SAADC->RESULT.PTR = (uint32_t)&result;
+    NRF_SAADC->RESULT.MAXCNT = 1;
+    NRF_SAADC->EVENTS_CH[0].LIMITH = 0;
+    NRF_SAADC->EVENTS_CH[0].LIMITL = 0;
+    NRF_SAADC->EVENTS_END = 0;
+    NRF_SAADC->ENABLE = SAADC_ENABLE_ENABLE_Enabled;
+    NRF_SAADC->TASKS_START = 1;
+
+    NRF_EGU3->EVENTS_TRIGGERED[0] = 0;
+    NRF_EGU3->EVENTS_TRIGGERED[1] = 0;
+    for (int i = 0; i < PPI_COUNT; i++)
+    {
+        nrfx_ppi_channel_enable(channels[i]);
+    }
+
+    NRF_RTC2->TASKS_CLEAR = 1;
+    NRF_RTC2->TASKS_START = 1;
+    counter_base = 0;
+    armed = true;
+    arms++;
+}
+
+void weight_monitor_stop(void)
+{
+    if (!armed)
+    {
+        return;
+    }
+    NRF_RTC2->TASKS_STOP = 1;
+    samples += NRF_RTC2->COUNTER - counter_base;
+    for (int i = 0; i < PPI_COUNT; i++)
+    {
+        nrfx_ppi_channel_disable(channels[i]);
+    }
+
+    NRF_SAADC->EVENTS_STOPPED = 0;
+    NRF_SAADC->TASKS_STOP = 1;
+    while (!NRF_SAADC->EVENTS_STOPPED)
+    {
+    }
+    NRF_SAADC->EVENTS_STOPPED = 0;
+    NRF_SAADC->ENABLE = SAADC_ENABLE_ENABLE_Disabled;
+    armed = false;
+
+    weight_sensor_resume();
+}
+
+bool weight_monitor_active(void)
+{
+    return armed;
+}
+
+void weight_monitor_print_stats(void)
+{
+    if (armed)
+    {
+        uint32_t counter = NRF_RTC2->COUNTER;
+        samples += counter - counter_base;
+        counter_base = counter;
+    }
+    printf("Weight monitor: %s, armed %lu times, %lu samples without CPU, %lu wakeups\n",
+           armed ? "armed" : "sampling", arms, samples, wakeups);
+
+    samples = 0;
+    wakeups = 0;
+    arms = 0;
+}
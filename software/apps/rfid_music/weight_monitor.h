@@ -0,0 +1,39 @@
+#ifndef WEIGHT_MONITOR_H
+#define WEIGHT_MONITOR_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Low-power watch for a change on the item plate
+//
+// While armed, RTC2 triggers one oversampled SAADC reading every
+// WEIGHT_MONITOR_INTERVAL_MS through PPI, with no CPU involvement. The
+// SAADC's own limit comparator checks each result against a window around
+// the baseline, and only a reading outside it wakes the CPU.
+
+#define WEIGHT_MONITOR_INTERVAL_MS 100
+
+// Half-width of the window around the baseline, in raw counts (~0.4 oz)
+#define WEIGHT_MONITOR_MARGIN 40
+
+// Runs in interrupt context. <placed> is true when the reading went above
+// the window, false when it dropped below
+typedef void (*weight_monitor_callback_t)(bool placed);
+
+// Claim RTC2, the PPI channels and EGU3. Call after weight_sensor_init()
+void weight_monitor_init(weight_monitor_callback_t callback);
+
+// Take the SAADC from weight_sensor and watch for readings outside
+// <baseline> +/- WEIGHT_MONITOR_MARGIN
+void weight_monitor_start(int32_t baseline);
+
+// Stop watching and hand the SAADC back to weight_sensor
+// Call from thread context, usually after the callback has run
+void weight_monitor_stop(void);
+
+bool weight_monitor_active(void);
+
+// Print samples taken and wakeups since the last call
+void weight_monitor_print_stats(void);
+
+#endif
@@ -0,0 +1,317 @@
+// Force sensor under the item plate
+//
+// The SAADC averages 16 conversions per SAMPLE task in hardware. Burst mode
+// runs all of them back to back from a single task, so one blocking
+// nrf_drv_saadc_sample_convert() call returns the averaged value. A full
+// update is WEIGHT_SENSOR_BURST of those, around a millisecond at the default
+// 10 us acquisition time.
+//
+// The calibration record is rewritten in place with fds_record_update(). FDS
+// appends the new copy and marks the old one dirty, so a full flash is
+// garbage collected once and the write retried.
+
+#include "weight_sensor.h"
+#include <stdio.h>
+#include <string.h>
+#include "app_error.h"
+#include "fds.h"
+#include "nrf.h"
+#include "cycle_counter.h"
+#include "nrf_drv_saadc.h"
+#include "tickless_timer.h"
+#include "weight_filter.h"
+
+// Print every burst of readings, for replay with software/tools/weight_replay
+// #define WEIGHT_TRACE
+
+// FDS file and record for the calibration table
+#define CALIBRATION_FILE_ID 0x5743 // "WC"
+#define CALIBRATION_RECORD_KEY 0x0001
+
+static weight_filter_t filter;
+static weight_hysteresis_t hysteresis;
+static int32_t last_raw = 0;
+static int32_t last_centi_oz = 0;
+
+// Table in use, and the copy handed to FDS which must stay put until written
+static weight_calibration_t calibration;
+static weight_calibration_t stored __attribute__((aligned(4)));
+
+// FDS init finishing and succeeding are tracked apart, so a failed init
+// still lets boot carry on with the default calibration
+static volatile bool fds_done = false;
+static volatile bool fds_ready = false;
+static volatile ret_code_t fds_result = NRF_SUCCESS;
+static volatile bool write_pending = false;
+static volatile bool gc_pending = false;
+static bool loaded = false;
+
+// Statistics
+static uint32_t updates = 0;
+static uint32_t sample_cycles = 0;
+static uint32_t max_sample_cycles = 0;
+static uint32_t display_changes = 0;
+static uint32_t flash_writes = 0;
+
+static void saadc_callback(nrf_drv_saadc_evt_t const *p_event) {}
+
+static void saadc_init(void)
+{
+    nrf_drv_saadc_config_t saadc_config = NRF_DRV_SAADC_DEFAULT_CONFIG;
+    saadc_config.resolution = NRF_SAADC_RESOLUTION_12BIT;
+    saadc_config.oversample = NRF_SAADC_OVERSAMPLE_16X;
+    ret_code_t err_code = nrf_drv_saadc_init(&saadc_config, saadc_callback);
+    APP_ERROR_CHECK(err_code);
+
+    // Oversampling needs burst mode, or each SAMPLE task only does one of the 16
+    nrf_saadc_channel_config_t channel_config = NRF_DRV_SAADC_DEFAULT_CHANNEL_CONFIG_SE(NRF_SAADC_INPUT_AIN0);
+    channel_config.burst = NRF_SAADC_BURST_ENABLED;
+    err_code = nrf_drv_saadc_channel_init(0, &channel_config);
+    APP_ERROR_CHECK(err_code);
+}
+
+static ret_code_t write_calibration(void)
+{
+    fds_record_t record = {
+        .file_id = CALIBRATION_FILE_ID,
+        .key = CALIBRATION_RECORD_KEY,
+        .data.p_data = &stored,
+        .data.length_words = (sizeof(stored) + 3) / 4,
+    };
+
+    fds_record_desc_t desc = {0};
+    fds_find_token_t token = {0};
+    ret_code_t err_code;
+    if (fds_record_find(CALIBRATION_FILE_ID, CALIBRATION_RECORD_KEY, &desc, &token) == NRF_SUCCESS)
+    {
+        err_code = fds_record_update(&desc, &record);
+    }
+    else
+    {
+        err_code = fds_record_write(NULL, &record);
+    }
+
+    if (err_code == FDS_ERR_NO_SPACE_IN_FLASH && !gc_pending)
+    {
+        // Reclaim the pages taken by old copies, then try again
+        gc_pending = true;
+        err_code = fds_gc();
+    }
+    return err_code;
+}
+
+static void fds_handler(fds_evt_t const *p_evt)
+{
+    switch (p_evt->id)
+    {
+    case FDS_EVT_INIT:
+        fds_result = p_evt->result;
+        fds_ready = (p_evt->result == NRF_SUCCESS);
+        fds_done = true;
+        break;
+    case FDS_EVT_WRITE:
+    case FDS_EVT_UPDATE:
+        if (p_evt->write.file_id == CALIBRATION_FILE_ID)
+        {
+            write_pending = false;
+            if (p_evt->result == NRF_SUCCESS)
+            {
+                flash_writes++;
+            }
+        }
+        break;
+    case FDS_EVT_GC:
+        if (gc_pending)
+        {
+            gc_pending = false;
+            if (write_pending && write_calibration() != NRF_SUCCESS)
+            {
+                write_pending = false;
+            }
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+static void load_calibration(void)
+{
+    calibration = weight_default_calibration;
+
+    fds_record_desc_t desc = {0};
+    fds_find_token_t token = {0};
+    if (fds_record_find(CALIBRATION_FILE_ID, CALIBRATION_RECORD_KEY, &desc, &token) != NRF_SUCCESS)
+    {
+        printf("Weight: no saved calibration, using defaults\n");
+        return;
+    }
+
+    fds_flash_record_t record;
+    if (fds_record_open(&desc, &record) != NRF_SUCCESS)
+    {
+        return;
+    }
+    const weight_calibration_t *saved = record.p_data;
+    if (record.p_header->length_words * 4 >= sizeof(calibration) && weight_calibration_valid(saved))
+    {
+        calibration = *saved;
+        printf("Weight: loaded %lu point calibration\n", calibration.count);
+    }
+    fds_record_close(&desc);
+}
+
+static bool save_calibration(void)
+{
+    if (write_pending || !fds_ready)
+    {
+        return false;
+    }
+    stored = calibration;
+    write_pending = true;
+    if (write_calibration() != NRF_SUCCESS)
+    {
+        write_pending = false;
+        return false;
+    }
+    return true;
+}
+
+void weight_sensor_init(void)
+{
+    saadc_init();
+    weight_filter_init(&filter);
+    weight_hysteresis_init(&hysteresis);
+    calibration = weight_default_calibration;
+
+    ret_code_t err_code = fds_register(fds_handler);
+    if (err_code == NRF_SUCCESS)
+    {
+        err_code = fds_init();
+    }
+    if (err_code != NRF_SUCCESS)
+    {
+        fds_result = err_code;
+        fds_done = true;
+    }
+}
+
+bool weight_sensor_ready(void)
+{
+    if (!loaded && fds_done)
+    {
+        if (fds_ready)
+        {
+            load_calibration();
+        }
+        else
+        {
+            // Corrupt pages or no space: weigh with the defaults, never save
+            printf("Weight: flash storage failed (0x%lX), default calibration, saving disabled\n", fds_result);
+        }
+        loaded = true;
+    }
+    return loaded;
+}
+
+bool weight_sensor_update(int32_t *ounces)
+{
+    int16_t samples[WEIGHT_SENSOR_BURST];
+
+    tickless_timer_hf_begin(TICKLESS_HF_SAADC);
+    uint32_t start = DWT->CYCCNT;
+    for (uint8_t i = 0; i < WEIGHT_SENSOR_BURST; i++)
+    {
+        nrf_saadc_value_t value;
+        ret_code_t err_code = nrf_drv_saadc_sample_convert(0, &value);
+        APP_ERROR_CHECK(err_code);
+        samples[i] = value;
+    }
+    uint32_t cycles = DWT->CYCCNT - start;
+    tickless_timer_hf_end(TICKLESS_HF_SAADC);
+    sample_cycles += cycles;
+    if (cycles > max_sample_cycles)
+    {
+        max_sample_cycles = cycles;
+    }
+    updates++;
+
+#ifdef WEIGHT_TRACE
+    printf("WEIGHT_BURST");
+    for (uint8_t i = 0; i < WEIGHT_SENSOR_BURST; i++)
+    {
+        printf(" %d", samples[i]);
+    }
+    printf("\n");
+#endif
+
+    last_raw = weight_filter_update(&filter, samples, WEIGHT_SENSOR_BURST);
+    last_centi_oz = weight_calibrate(&calibration, last_raw);
+    if (!weight_hysteresis_update(&hysteresis, last_centi_oz))
+    {
+        return false;
+    }
+
+    display_changes++;
+    *ounces = hysteresis.shown;
+    return true;
+}
+
+int32_t weight_sensor_centi_oz(void)
+{
+    return last_centi_oz;
+}
+
+int32_t weight_sensor_raw(void)
+{
+    return last_raw;
+}
+
+void weight_sensor_suspend(void)
+{
+    nrf_drv_saadc_uninit();
+}
+
+void weight_sensor_resume(void)
+{
+    saadc_init();
+
+    // Something was placed or lifted, follow it at once instead of easing
+    // the IIR filter over from the old weight
+    weight_filter_init(&filter);
+#ifdef WEIGHT_TRACE
+    printf("WEIGHT_RESUME\n");
+#endif
+}
+
+bool weight_sensor_calibrate(int32_t centi_oz)
+{
+    if (!weight_calibration_insert(&calibration, last_raw, centi_oz))
+    {
+        return false;
+    }
+    printf("Weight: raw %ld is %ld.%02ld oz\n", last_raw, centi_oz / 100, centi_oz % 100);
+    return save_calibration();
+}
+
+void weight_sensor_reset_calibration(void)
+{
+    calibration = weight_default_calibration;
+    save_calibration();
+}
+
+void weight_sensor_print_stats(void)
+{
+    printf("Weight: %lu updates, sampling avg %lu us max %lu us, %lu display changes, %lu flash writes\n",
+           updates,
+           updates ? sample_cycles / updates / CYCLES_PER_US : 0,
+           max_sample_cycles / CYCLES_PER_US,
+           display_changes, flash_writes);
+    printf("Weight: raw %ld, %ld.%02ld oz, %lu calibration points\n",
+           last_raw, last_centi_oz / 100, last_centi_oz % 100, calibration.count);
+
+    updates = 0;
+    sample_cycles = 0;
+    max_sample_cycles = 0;
+    display_changes = 0;
+}
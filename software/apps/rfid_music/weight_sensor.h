@@ -0,0 +1,50 @@
+#ifndef WEIGHT_SENSOR_H
+#define WEIGHT_SENSOR_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Force sensor under the item plate
+//
+// Each reading is a burst of SAADC conversions averaged in hardware, several
+// of which go through weight_filter. The calibration table is kept in flash
+// with FDS and falls back to the original linear fit until one is saved.
+
+// Oversampled readings per update, median filtered
+#define WEIGHT_SENSOR_BURST 5
+
+// Set up the SAADC and start loading the calibration from flash
+void weight_sensor_init(void);
+
+// Whether the calibration has been loaded. FDS formats its pages on the
+// first boot, so this can take a while once. If FDS fails to start this still
+// turns true, with the default calibration and saving disabled
+bool weight_sensor_ready(void);
+
+// Take a burst of readings and run them through the filter
+// Returns true when the whole ounces to display changed. <ounces> is set to
+// the new value, 0 for an empty plate
+bool weight_sensor_update(int32_t *ounces);
+
+// Latest calibrated weight in hundredths of an ounce, without hysteresis
+int32_t weight_sensor_centi_oz(void);
+
+// Latest filtered reading in raw counts
+int32_t weight_sensor_raw(void);
+
+// Release the SAADC driver so weight_monitor can drive the SAADC directly,
+// and take it back. No updates in between
+void weight_sensor_suspend(void);
+void weight_sensor_resume(void);
+
+// Record the current filtered reading as <centi_oz> and save the table
+// Returns false if the table is full or flash is busy
+bool weight_sensor_calibrate(int32_t centi_oz);
+
+// Go back to the default calibration and save it
+void weight_sensor_reset_calibration(void);
+
+// Print sampling cost and calibration since the last call
+void weight_sensor_print_stats(void);
+
+#endif
@@ -38,9 +38,13 @@
 #define NRFX_SPI_ENABLED 1
 #define SPI_ENABLED 1
 #define SPI2_ENABLED 1
+#define SPI3_ENABLED 1 // Display, the only SPIM that runs at 16/32 MHz
+#define SPI3_USE_EASY_DMA 1
 
 #define APP_SDCARD_ENABLED 1
 
+#define NRFX_PPI_ENABLED 1
+
 #define NRF_CLOCK_ENABLED 1
 #define NRFX_CLOCK_ENABLED 1
 
@@ -82,6 +86,7 @@
 #define FDS_ENABLED 1
 #define FDS_VIRTUAL_PAGES 10
 #define FDS_OP_QUEUE_SIZE 10
+#define FDS_BACKEND 1 // NRF_FSTORAGE_NVMC, no SoftDevice on these boards
 
 #define MEM_MANAGER_ENABLED 1
 
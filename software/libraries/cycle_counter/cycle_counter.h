@@ -0,0 +1,19 @@
+// DWT cycle counter
+//
+// Drivers and apps time their work in CPU cycles with DWT->CYCCNT. The
+// counter runs at the core clock and stops while the CPU sleeps.
+
+#pragma once
+
+#include <stdint.h>
+
+#include "nrf.h"
+
+// Core clock cycles per microsecond, 64 on the nRF52833
+#define CYCLES_PER_US (SystemCoreClock / 1000000)
+
+// Start the cycle counter. Safe to call more than once, the count carries on
+static inline void cycle_counter_init(void) {
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
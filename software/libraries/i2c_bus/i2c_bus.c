@@ -0,0 +1,655 @@
+// Shared I2C register access layer
+//
+// Jobs wait in per-priority FIFO lists until the bus is free. Exactly one job
+// is handed to nrf_twi_mngr_schedule() at a time, and its completion callback
+// starts the next, so priorities apply across every driver on the bus.
+
+#include <stdio.h>
+#include <string.h>
+
+#include "app_error.h"
+#include "app_util_platform.h"
+#include "nrf.h"
+#include "nrf_delay.h"
+#include "nrf_gpio.h"
+
+#include "cycle_counter.h"
+#include "i2c_bus.h"
+
+// Allowance on top of the wire time before a transaction counts as stuck
+#define TIMEOUT_MARGIN_US 2000
+
+// Clock rates tried by i2c_bus_select_frequency(), fastest first
+static const nrf_drv_twi_frequency_t frequencies[] = {
+  NRF_DRV_TWI_FREQ_400K,
+  NRF_DRV_TWI_FREQ_250K,
+  NRF_DRV_TWI_FREQ_100K,
+};
+#define FREQUENCY_COUNT (sizeof(frequencies) / sizeof(frequencies[0]))
+
+static uint32_t frequency_khz(nrf_drv_twi_frequency_t frequency) {
+  switch (frequency) {
+    case NRF_DRV_TWI_FREQ_400K: return 400;
+    case NRF_DRV_TWI_FREQ_250K: return 250;
+    default: return 100;
+  }
+}
+
+static bool bit_get(const uint32_t* bits, uint8_t index) {
+  return (bits[index / 32] >> (index % 32)) & 1;
+}
+
+static void bit_set(uint32_t* bits, uint8_t index) {
+  bits[index / 32] |= 1UL << (index % 32);
+}
+
+static void bit_clear(uint32_t* bits, uint8_t index) {
+  bits[index / 32] &= ~(1UL << (index % 32));
+}
+
+ret_code_t i2c_bus_init(i2c_bus_t* bus, const nrf_twi_mngr_t* mngr,
+    const nrf_drv_twi_config_t* config, const char* name) {
+  memset(bus, 0, sizeof(*bus));
+  bus->mngr = mngr;
+  bus->config = *config;
+  bus->name = name;
+
+  // cycle counter for bus time
+  cycle_counter_init();
+  bus->stats_start = DWT->CYCCNT;
+
+  return nrf_twi_mngr_init(mngr, &bus->config);
+}
+
+static void device_setup(i2c_device_t* device, i2c_bus_t* bus, uint8_t address,
+    uint8_t auto_increment, uint8_t* shadow, uint16_t shadow_size, const char* name) {
+  memset(device, 0, sizeof(*device));
+  device->bus = bus;
+  device->address = address;
+  device->auto_increment = auto_increment;
+  device->priority = I2C_BUS_PRIORITY_NORMAL;
+  device->name = name;
+  device->shadow = shadow;
+  device->shadow_size = (shadow != NULL) ? shadow_size : 0;
+  if (device->shadow_size > I2C_BUS_REGISTER_COUNT) {
+    device->shadow_size = I2C_BUS_REGISTER_COUNT;
+  }
+  device->max_frequency = bus->config.frequency;
+  device->online = true;
+}
+
+void i2c_device_init(i2c_device_t* device, i2c_bus_t* bus, uint8_t address,
+    uint8_t auto_increment, uint8_t* shadow, uint16_t shadow_size, const char* name) {
+  device_setup(device, bus, address, auto_increment, shadow, shadow_size, name);
+
+  for (uint8_t i = 0; i < bus->device_count; i++) {
+    if (bus->devices[i] == device) {
+      return;
+    }
+  }
+  if (bus->device_count < I2C_BUS_MAX_DEVICES) {
+    bus->devices[bus->device_count++] = device;
+  }
+}
+
+void i2c_device_set_id(i2c_device_t* device, uint8_t reg, uint8_t value) {
+  device->has_id = true;
+  device->id_reg = reg;
+  device->id_value = value;
+}
+
+// Common job fields
+static void job_reset(i2c_bus_job_t* job, i2c_device_t* device, uint8_t count) {
+  job->device = device;
+  job->rx = NULL;
+  job->rx_length = 0;
+  job->tx_length = 0;
+  job->transaction.p_transfers = job->transfers;
+  job->transaction.number_of_transfers = count;
+  job->transaction.p_required_twi_cfg = NULL;
+}
+
+void i2c_job_read_regs(i2c_bus_job_t* job, i2c_device_t* device, uint8_t reg, uint8_t* data, uint8_t len) {
+  job_reset(job, device, 2);
+  job->tx[0] = (len > 1) ? (reg | device->auto_increment) : reg;
+  job->transfers[0] = (nrf_twi_mngr_transfer_t)NRF_TWI_MNGR_WRITE(device->address, job->tx, 1, NRF_TWI_MNGR_NO_STOP);
+  job->transfers[1] = (nrf_twi_mngr_transfer_t)NRF_TWI_MNGR_READ(device->address, data, len, 0);
+  job->reg = reg;
+  job->rx = data;
+  job->rx_length = len;
+}
+
+void i2c_job_write_regs(i2c_bus_job_t* job, i2c_device_t* device, uint8_t reg, const uint8_t* data, uint8_t len) {
+  APP_ERROR_CHECK_BOOL(len <= I2C_BUS_MAX_WRITE);
+
+  // Register address and data must be one buffer to go out as one write
+  job_reset(job, device, 1);
+  job->tx[0] = (len > 1) ? (reg | device->auto_increment) : reg;
+  memcpy(&job->tx[1], data, len);
+  job->transfers[0] = (nrf_twi_mngr_transfer_t)NRF_TWI_MNGR_WRITE(device->address, job->tx, len + 1, 0);
+  job->reg = reg;
+  job->tx_length = len;
+}
+
+void i2c_job_read(i2c_bus_job_t* job, i2c_device_t* device, uint8_t* data, uint8_t len) {
+  job_reset(job, device, 1);
+  job->transfers[0] = (nrf_twi_mngr_transfer_t)NRF_TWI_MNGR_READ(device->address, data, len, 0);
+}
+
+static void job_finish(i2c_bus_job_t* job, ret_code_t result, bool on_bus);
+
+static void job_complete(ret_code_t result, void* p_user_data) {
+  job_finish(p_user_data, result, true);
+}
+
+// Generous upper bound on how long a job should hold the bus
+static uint32_t job_timeout(const i2c_bus_t* bus, const i2c_bus_job_t* job) {
+  uint32_t bytes = 0;
+  for (uint8_t i = 0; i < job->transaction.number_of_transfers; i++) {
+    bytes += job->transfers[i].length + 1; // data plus address byte
+  }
+  // 9 clocks per byte, four times over
+  uint32_t wire_us = bytes * 9 * 4 * 1000 / frequency_khz(bus->config.frequency);
+  return (wire_us + TIMEOUT_MARGIN_US) * CYCLES_PER_US;
+}
+
+// Hand the highest priority waiting job to the TWI manager
+// Called with interrupts disabled or from the TWI interrupt
+static void start_next(i2c_bus_t* bus) {
+  while (bus->active == NULL && !bus->paused) {
+    i2c_bus_job_t* job = NULL;
+    for (int priority = 0; priority < I2C_BUS_PRIORITY_COUNT && job == NULL; priority++) {
+      job = bus->head[priority];
+      if (job != NULL) {
+        bus->head[priority] = job->next;
+        if (bus->head[priority] == NULL) {
+          bus->tail[priority] = NULL;
+        }
+      }
+    }
+    if (job == NULL) {
+      return;
+    }
+    bus->queued--;
+
+    // Fail fast for unplugged devices, letting an occasional request through
+    i2c_device_t* device = job->device;
+    if (!device->online && (++device->stats.skipped % I2C_BUS_OFFLINE_RETRY) != 0) {
+      job_finish(job, NRF_ERROR_INVALID_STATE, false);
+      continue;
+    }
+
+    bus->active = job;
+    if (bus->activity != NULL) {
+      bus->activity(true);
+    }
+    job->started = DWT->CYCCNT;
+    job->timeout = job_timeout(bus, job);
+    job->transaction.callback = job_complete;
+    job->transaction.p_user_data = job;
+
+    ret_code_t result = nrf_twi_mngr_schedule(bus->mngr, &job->transaction);
+    if (result != NRF_SUCCESS) {
+      // Fail this job and try the next one
+      bus->active = NULL;
+      if (bus->activity != NULL) {
+        bus->activity(false);
+      }
+      job_finish(job, result, false);
+    }
+  }
+}
+
+// Count a bus error and decide whether the bus needs attention
+static void track_bus_error(i2c_bus_t* bus, bool error) {
+  if (error) {
+    bus->consecutive_errors++;
+    bus->window_errors++;
+    if (bus->consecutive_errors >= I2C_BUS_RECOVER_AFTER) {
+      bus->recover_pending = true;
+    }
+  } else {
+    bus->consecutive_errors = 0;
+  }
+
+  bus->window_count++;
+  if (bus->window_count >= I2C_BUS_ERROR_WINDOW) {
+    if (bus->window_errors > I2C_BUS_ERROR_LIMIT) {
+      bus->step_down_pending = true;
+    }
+    bus->window_count = 0;
+    bus->window_errors = 0;
+  }
+}
+
+static void job_finish(i2c_bus_job_t* job, ret_code_t result, bool on_bus) {
+  i2c_device_t* device = job->device;
+  i2c_bus_t* bus = device->bus;
+
+  if (on_bus) {
+    if (bus->activity != NULL) {
+      bus->activity(false);
+    }
+    uint32_t cycles = DWT->CYCCNT - job->started;
+    uint32_t bytes = 0;
+    for (uint8_t i = 0; i < job->transaction.number_of_transfers; i++) {
+      bytes += job->transfers[i].length;
+    }
+    bus->stats.transactions++;
+    bus->stats.bytes += bytes;
+    bus->stats.bus_cycles += cycles;
+    device->stats.transactions++;
+    device->stats.bus_cycles += cycles;
+
+    if (result == NRF_SUCCESS) {
+      device->stats.bytes += bytes;
+      device->consecutive_nacks = 0;
+      device->online = true;
+      track_bus_error(bus, false);
+    } else if (result == NRF_ERROR_DRV_TWI_ERR_ANACK) {
+      // Nobody answered, which says more about the device than the bus
+      bus->stats.errors++;
+      bus->stats.nacks++;
+      device->stats.errors++;
+      if (++device->consecutive_nacks >= I2C_BUS_OFFLINE_AFTER) {
+        device->online = false;
+      }
+    } else {
+      bus->stats.errors++;
+      device->stats.errors++;
+      if (result == NRF_ERROR_DRV_TWI_ERR_DNACK) {
+        bus->stats.nacks++;
+      }
+      track_bus_error(bus, true);
+    }
+  }
+
+  if (result == NRF_SUCCESS) {
+    // Mirror the registers into the shadow
+    uint16_t length = job->rx ? job->rx_length : job->tx_length;
+    if (length > 0 && job->reg + length <= device->shadow_size) {
+      memcpy(&device->shadow[job->reg], job->rx ? job->rx : &job->tx[1], length);
+      if (job->tx_length > 0) {
+        for (uint16_t i = 0; i < length; i++) {
+          bit_set(device->written, job->reg + i);
+        }
+      }
+    }
+  }
+
+  // Keep the bus busy before running the callback
+  if (on_bus) {
+    CRITICAL_REGION_ENTER();
+    bus->active = NULL;
+    start_next(bus);
+    CRITICAL_REGION_EXIT();
+  }
+
+  job->result = result;
+  if (job->callback != NULL) {
+    job->callback(result, job->context);
+  }
+  job->done = true;
+}
+
+ret_code_t i2c_bus_submit(i2c_bus_job_t* job, i2c_bus_priority_t priority,
+    i2c_bus_callback_t callback, void* context) {
+  if (job->device == NULL || priority >= I2C_BUS_PRIORITY_COUNT) {
+    return NRF_ERROR_INVALID_PARAM;
+  }
+  i2c_bus_t* bus = job->device->bus;
+
+  job->callback = callback;
+  job->context = context;
+  job->done = false;
+  job->next = NULL;
+
+  CRITICAL_REGION_ENTER();
+  if (bus->tail[priority] != NULL) {
+    bus->tail[priority]->next = job;
+  } else {
+    bus->head[priority] = job;
+  }
+  bus->tail[priority] = job;
+
+  bus->queued++;
+  if (bus->queued > bus->stats.queue_high_water) {
+    bus->stats.queue_high_water = bus->queued;
+  }
+
+  start_next(bus);
+  CRITICAL_REGION_EXIT();
+
+  return NRF_SUCCESS;
+}
+
+ret_code_t i2c_bus_run(i2c_bus_job_t* job, i2c_bus_priority_t priority) {
+  ret_code_t result = i2c_bus_submit(job, priority, NULL, NULL);
+  if (result != NRF_SUCCESS) {
+    return result;
+  }
+  while (!job->done) {
+    i2c_bus_poll(job->device->bus);
+  }
+  return job->result;
+}
+
+ret_code_t i2c_device_read_regs(i2c_device_t* device, uint8_t reg, uint8_t* data, uint8_t len) {
+  i2c_bus_job_t job;
+  i2c_job_read_regs(&job, device, reg, data, len);
+  return i2c_bus_run(&job, device->priority);
+}
+
+ret_code_t i2c_device_write_regs(i2c_device_t* device, uint8_t reg, const uint8_t* data, uint8_t len) {
+  i2c_bus_job_t job;
+  i2c_job_write_regs(&job, device, reg, data, len);
+  ret_code_t result = i2c_bus_run(&job, device->priority);
+  if (result == NRF_SUCCESS && reg + len <= device->shadow_size) {
+    for (uint16_t i = 0; i < len; i++) {
+      bit_clear(device->staged, reg + i);
+    }
+  }
+  return result;
+}
+
+ret_code_t i2c_device_read(i2c_device_t* device, uint8_t* data, uint8_t len) {
+  i2c_bus_job_t job;
+  i2c_job_read(&job, device, data, len);
+  return i2c_bus_run(&job, device->priority);
+}
+
+uint8_t i2c_device_read_reg(i2c_device_t* device, uint8_t reg) {
+  uint8_t value = 0;
+  ret_code_t result = i2c_device_read_regs(device, reg, &value, 1);
+  if (result != NRF_SUCCESS) {
+    printf("I2C read of %s register 0x%02X failed! Error: %lX\n", device->name, reg, result);
+  }
+  return value;
+}
+
+ret_code_t i2c_device_write_reg(i2c_device_t* device, uint8_t reg, uint8_t value) {
+  ret_code_t result = i2c_device_write_regs(device, reg, &value, 1);
+  if (result != NRF_SUCCESS) {
+    printf("I2C write of %s register 0x%02X failed! Error: %lX\n", device->name, reg, result);
+  }
+  return result;
+}
+
+void i2c_device_stage(i2c_device_t* device, uint8_t reg, uint8_t value) {
+  if (reg >= device->shadow_size) {
+    // No shadow to hold it, write straight away
+    i2c_device_write_reg(device, reg, value);
+    return;
+  }
+  device->shadow[reg] = value;
+  bit_set(device->staged, reg);
+}
+
+ret_code_t i2c_device_flush(i2c_device_t* device) {
+  ret_code_t first_error = NRF_SUCCESS;
+
+  uint16_t reg = 0;
+  while (reg < device->shadow_size) {
+    if (!bit_get(device->staged, reg)) {
+      reg++;
+      continue;
+    }
+
+    // Grow the block over staged registers and known gaps
+    uint16_t start = reg;
+    uint16_t end = reg;
+    for (uint16_t next = reg + 1; next < device->shadow_size && next - start < I2C_BUS_MAX_WRITE; next++) {
+      if (bit_get(device->staged, next)) {
+        end = next;
+      } else if (!bit_get(device->written, next)) {
+        break;
+      }
+    }
+
+    ret_code_t result = i2c_device_write_regs(device, start, &device->shadow[start], end - start + 1);
+    if (result != NRF_SUCCESS) {
+      printf("I2C flush of %s registers 0x%02X-0x%02X failed! Error: %lX\n",
+          device->name, start, end, result);
+      if (first_error == NRF_SUCCESS) {
+        first_error = result;
+      }
+    }
+    reg = end + 1;
+  }
+
+  return first_error;
+}
+
+void i2c_job_probe(i2c_bus_job_t* job, i2c_device_t* scratch, i2c_bus_t* bus, uint8_t address, uint8_t* data) {
+  device_setup(scratch, bus, address, 0, NULL, 0, "probe");
+  i2c_job_read(job, scratch, data, 1);
+}
+
+bool i2c_bus_probe(i2c_bus_t* bus, uint8_t address) {
+  i2c_device_t device;
+  i2c_bus_job_t job;
+  uint8_t data = 0;
+  i2c_job_probe(&job, &device, bus, address, &data);
+  return i2c_bus_run(&job, I2C_BUS_PRIORITY_NORMAL) == NRF_SUCCESS;
+}
+
+// Re-initialize the TWI manager, optionally clearing the bus first
+// Returns false if SDA was still held low after clearing
+static bool bus_restart(i2c_bus_t* bus, bool clear) {
+  bool released = true;
+
+  bus->paused = true;
+  nrf_twi_mngr_uninit(bus->mngr);
+
+  // No more callbacks, anything still active never finished
+  i2c_bus_job_t* orphan;
+  CRITICAL_REGION_ENTER();
+  orphan = bus->active;
+  bus->active = NULL;
+  CRITICAL_REGION_EXIT();
+
+  if (clear) {
+    uint32_t scl = bus->config.scl;
+    uint32_t sda = bus->config.sda;
+    nrf_gpio_cfg(scl, NRF_GPIO_PIN_DIR_OUTPUT, NRF_GPIO_PIN_INPUT_CONNECT,
+        NRF_GPIO_PIN_PULLUP, NRF_GPIO_PIN_S0D1, NRF_GPIO_PIN_NOSENSE);
+    nrf_gpio_cfg(sda, NRF_GPIO_PIN_DIR_OUTPUT, NRF_GPIO_PIN_INPUT_CONNECT,
+        NRF_GPIO_PIN_PULLUP, NRF_GPIO_PIN_S0D1, NRF_GPIO_PIN_NOSENSE);
+    nrf_gpio_pin_set(scl);
+    nrf_gpio_pin_set(sda);
+    nrf_delay_us(5);
+
+    // Clock out whatever byte the slave is stuck in
+    for (int i = 0; i < 9 && !nrf_gpio_pin_read(sda); i++) {
+      nrf_gpio_pin_clear(scl);
+      nrf_delay_us(5);
+      nrf_gpio_pin_set(scl);
+      nrf_delay_us(5);
+    }
+
+    // STOP: SDA rises while SCL is high
+    nrf_gpio_pin_clear(scl);
+    nrf_gpio_pin_clear(sda);
+    nrf_delay_us(5);
+    nrf_gpio_pin_set(scl);
+    nrf_delay_us(5);
+    nrf_gpio_pin_set(sda);
+    nrf_delay_us(5);
+    released = nrf_gpio_pin_read(sda);
+
+    bus->stats.recoveries++;
+  }
+
+  APP_ERROR_CHECK(nrf_twi_mngr_init(bus->mngr, &bus->config));
+
+  bus->consecutive_errors = 0;
+  bus->window_count = 0;
+  bus->window_errors = 0;
+  bus->recover_pending = false;
+  bus->paused = false;
+
+  if (orphan != NULL) {
+    bus->stats.timeouts++;
+    job_finish(orphan, NRF_ERROR_TIMEOUT, true);
+  } else {
+    CRITICAL_REGION_ENTER();
+    start_next(bus);
+    CRITICAL_REGION_EXIT();
+  }
+  return released;
+}
+
+void i2c_bus_set_frequency(i2c_bus_t* bus, nrf_drv_twi_frequency_t frequency) {
+  bus->config.frequency = frequency;
+  bus_restart(bus, false);
+  for (uint8_t i = 0; i < bus->device_count; i++) {
+    bus->devices[i]->max_frequency = frequency;
+  }
+}
+
+bool i2c_bus_recover(i2c_bus_t* bus) {
+  bool released = bus_restart(bus, true);
+  printf("I2C bus %s recovered%s\n", bus->name, released ? "" : ", SDA still held low");
+  return released;
+}
+
+void i2c_bus_poll(i2c_bus_t* bus) {
+  // A transaction that never finished means the bus is stuck
+  i2c_bus_job_t* active = bus->active;
+  if (active != NULL && DWT->CYCCNT - active->started > active->timeout) {
+    i2c_bus_recover(bus);
+    return;
+  }
+  if (active != NULL) {
+    return;
+  }
+
+  if (bus->recover_pending) {
+    i2c_bus_recover(bus);
+  }
+
+  if (bus->step_down_pending) {
+    bus->step_down_pending = false;
+    for (uint32_t i = 0; i + 1 < FREQUENCY_COUNT; i++) {
+      if (frequencies[i] == bus->config.frequency) {
+        bus->config.frequency = frequencies[i + 1];
+        bus->stats.step_downs++;
+        bus_restart(bus, false);
+        printf("I2C bus %s: too many errors, clock lowered to %lu kHz\n",
+            bus->name, frequency_khz(bus->config.frequency));
+        break;
+      }
+    }
+  }
+}
+
+// Repeatedly check a device answers correctly at the current clock rate
+static bool device_verify(i2c_device_t* device) {
+  for (int round = 0; round < I2C_BUS_PROBE_ROUNDS; round++) {
+    uint8_t value = 0;
+    ret_code_t result;
+    if (device->has_id) {
+      result = i2c_device_read_regs(device, device->id_reg, &value, 1);
+      if (result == NRF_SUCCESS && value != device->id_value) {
+        return false;
+      }
+    } else {
+      result = i2c_device_read(device, &value, 1);
+    }
+    if (result != NRF_SUCCESS) {
+      return false;
+    }
+  }
+  return true;
+}
+
+nrf_drv_twi_frequency_t i2c_bus_select_frequency(i2c_bus_t* bus) {
+  bool passed[I2C_BUS_MAX_DEVICES] = {false};
+
+  // Fastest rate each device passes at
+  for (uint32_t f = 0; f < FREQUENCY_COUNT; f++) {
+    bus->config.frequency = frequencies[f];
+    bus_restart(bus, false);
+
+    for (uint8_t i = 0; i < bus->device_count; i++) {
+      i2c_device_t* device = bus->devices[i];
+      if (!passed[i]) {
+        device->online = true;
+        device->consecutive_nacks = 0;
+        if (device_verify(device)) {
+          passed[i] = true;
+          device->max_frequency = frequencies[f];
+        }
+      }
+    }
+  }
+
+  // The bus runs at the rate its slowest working device manages
+  nrf_drv_twi_frequency_t selected = frequencies[0];
+  bool any = false;
+  for (uint8_t i = 0; i < bus->device_count; i++) {
+    i2c_device_t* device = bus->devices[i];
+    if (passed[i]) {
+      any = true;
+      if (frequency_khz(device->max_frequency) < frequency_khz(selected)) {
+        selected = device->max_frequency;
+      }
+      printf("I2C bus %s: %s passes at %lu kHz\n", bus->name, device->name,
+          frequency_khz(device->max_frequency));
+    } else {
+      device->online = false;
+      printf("I2C bus %s: %s not responding\n", bus->name, device->name);
+    }
+  }
+  if (!any) {
+    selected = frequencies[FREQUENCY_COUNT - 1];
+  }
+
+  bus->config.frequency = selected;
+  bus_restart(bus, false);
+  memset(&bus->stats, 0, sizeof(bus->stats));
+  bus->stats_start = DWT->CYCCNT;
+  printf("I2C bus %s: running at %lu kHz\n", bus->name, frequency_khz(selected));
+  return selected;
+}
+
+void i2c_bus_set_activity_handler(i2c_bus_t* bus, i2c_bus_activity_handler_t handler) {
+  bus->activity = handler;
+}
+
+void i2c_bus_print_stats(i2c_bus_t* bus) {
+  uint32_t now = DWT->CYCCNT;
+  uint32_t elapsed = now - bus->stats_start;
+  i2c_bus_stats_t stats = bus->stats;
+
+  memset(&bus->stats, 0, sizeof(bus->stats));
+  bus->stats_start = now;
+
+  printf("I2C bus %s at %lu kHz: %lu transactions, %lu bytes, %lu NACKs, %lu errors, queue high-water %lu\n",
+      bus->name, frequency_khz(bus->config.frequency), stats.transactions, stats.bytes,
+      stats.nacks, stats.errors, stats.queue_high_water);
+  if (elapsed > 0 && stats.transactions > 0) {
+    printf("  busy %lu.%02lu%%, %lu us per transaction\n",
+        (uint32_t)((uint64_t)stats.bus_cycles * 100 / elapsed),
+        (uint32_t)((uint64_t)stats.bus_cycles * 10000 / elapsed % 100),
+        stats.bus_cycles / stats.transactions / CYCLES_PER_US);
+  }
+  if (stats.timeouts || stats.recoveries || stats.step_downs) {
+    printf("  %lu timeouts, %lu recoveries, %lu clock step-downs\n",
+        stats.timeouts, stats.recoveries, stats.step_downs);
+  }
+
+  // Effective throughput counts only bytes of successful transactions
+  for (uint8_t i = 0; i < bus->device_count; i++) {
+    i2c_device_t* device = bus->devices[i];
+    i2c_device_stats_t device_stats = device->stats;
+    memset(&device->stats, 0, sizeof(device->stats));
+
+    uint32_t bytes_per_s = device_stats.bus_cycles
+        ? (uint32_t)((uint64_t)device_stats.bytes * CYCLES_PER_US * 1000000 / device_stats.bus_cycles)
+        : 0;
+    printf("  %-14s %s, %lu transactions, %lu errors, %lu skipped, %lu B/s on the bus\n",
+        device->name, device->online ? "online" : "offline", device_stats.transactions,
+        device_stats.errors, device_stats.skipped, bytes_per_s);
+  }
+}
@@ -0,0 +1,239 @@
+// Shared I2C register access layer
+//
+// Wraps one nrf_twi_mngr instance per bus. Drivers describe their chip with
+// an i2c_device_t and never touch the TWI manager directly. Every transaction
+// goes through a per-bus priority queue, with a single transaction handed to
+// the TWI manager at a time, so a high priority read never waits behind a
+// queue of low priority traffic.
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "nrf_drv_twi.h"
+#include "nrf_twi_mngr.h"
+
+// Largest register block that can be written in one transaction
+#define I2C_BUS_MAX_WRITE 32
+
+// Registers tracked per device, enough for any 8-bit register address
+#define I2C_BUS_REGISTER_COUNT 256
+
+// Devices per bus that take part in clock selection and reporting
+#define I2C_BUS_MAX_DEVICES 8
+
+// Reads each device must pass at a clock rate before it is used
+#define I2C_BUS_PROBE_ROUNDS 8
+
+// Bus errors in a row before the bus is cleared and re-initialized
+#define I2C_BUS_RECOVER_AFTER 3
+
+// Step the clock down when more than ERROR_LIMIT of the last ERROR_WINDOW
+// transactions failed with bus errors
+#define I2C_BUS_ERROR_WINDOW 32
+#define I2C_BUS_ERROR_LIMIT 4
+
+// Address NACKs in a row before a device is treated as unplugged. After that
+// only one request in OFFLINE_RETRY reaches the bus, the rest fail at once
+#define I2C_BUS_OFFLINE_AFTER 5
+#define I2C_BUS_OFFLINE_RETRY 16
+
+typedef enum {
+  I2C_BUS_PRIORITY_HIGH,
+  I2C_BUS_PRIORITY_NORMAL,
+  I2C_BUS_PRIORITY_LOW,
+  I2C_BUS_PRIORITY_COUNT,
+} i2c_bus_priority_t;
+
+typedef struct {
+  uint32_t transactions;
+  uint32_t bytes;          // Payload and register address bytes, not I2C addresses
+  uint32_t nacks;          // Address or data not acknowledged
+  uint32_t errors;         // Any failed transaction, including NACKs
+  uint32_t bus_cycles;     // CPU cycles between scheduling and completion
+  uint32_t queue_high_water;
+  uint32_t timeouts;
+  uint32_t recoveries;
+  uint32_t step_downs;
+} i2c_bus_stats_t;
+
+typedef struct {
+  uint32_t transactions;
+  uint32_t bytes;
+  uint32_t errors;
+  uint32_t skipped;        // Failed without using the bus while offline
+  uint32_t bus_cycles;
+} i2c_device_stats_t;
+
+struct i2c_bus_job_s;
+struct i2c_device_s;
+
+// Called with true when a transaction goes out on the bus and false when it
+// is done, from thread context or the TWI interrupt
+typedef void (*i2c_bus_activity_handler_t)(bool busy);
+
+typedef struct {
+  const nrf_twi_mngr_t* mngr;
+  nrf_drv_twi_config_t config;
+  const char* name;
+
+  // Pending jobs, one FIFO list per priority
+  struct i2c_bus_job_s* head[I2C_BUS_PRIORITY_COUNT];
+  struct i2c_bus_job_s* tail[I2C_BUS_PRIORITY_COUNT];
+  struct i2c_bus_job_s* active;
+  uint32_t queued;
+  volatile bool paused;    // TWI manager is being re-initialized
+
+  struct i2c_device_s* devices[I2C_BUS_MAX_DEVICES];
+  uint8_t device_count;
+
+  // Error tracking, acted on by i2c_bus_poll()
+  uint8_t consecutive_errors;
+  uint8_t window_count;
+  uint8_t window_errors;
+  volatile bool recover_pending;
+  volatile bool step_down_pending;
+
+  i2c_bus_stats_t stats;
+  uint32_t stats_start;
+  i2c_bus_activity_handler_t activity;
+} i2c_bus_t;
+
+// One chip on a bus
+//
+// The optional shadow array mirrors the chip's registers, indexed by register
+// address. Writes and reads keep it up to date, and staged writes are held in
+// it until i2c_device_flush().
+typedef struct i2c_device_s {
+  i2c_bus_t* bus;
+  uint8_t address;
+  uint8_t auto_increment;  // Or'ed into the register address for multi-byte access
+  i2c_bus_priority_t priority;
+  const char* name;
+
+  uint8_t* shadow;
+  uint16_t shadow_size;
+  uint32_t staged[I2C_BUS_REGISTER_COUNT / 32];   // Written to shadow, not yet to the chip
+  uint32_t written[I2C_BUS_REGISTER_COUNT / 32];  // Shadow holds a value the chip accepted
+
+  // Identity check used when probing clock rates, see i2c_device_set_id()
+  bool has_id;
+  uint8_t id_reg;
+  uint8_t id_value;
+  nrf_drv_twi_frequency_t max_frequency;
+
+  bool online;
+  uint8_t consecutive_nacks;
+  i2c_device_stats_t stats;
+} i2c_device_t;
+
+typedef void (*i2c_bus_callback_t)(ret_code_t result, void* context);
+
+// A queued transaction. Owned by the caller until its callback has run
+typedef struct i2c_bus_job_s {
+  i2c_device_t* device;
+  nrf_twi_mngr_transfer_t transfers[2];
+  nrf_twi_mngr_transaction_t transaction;
+  uint8_t tx[I2C_BUS_MAX_WRITE + 1];
+
+  // Register block to mirror into the shadow once the transaction completes
+  uint8_t reg;
+  uint8_t* rx;
+  uint8_t rx_length;
+  uint8_t tx_length;
+
+  i2c_bus_callback_t callback;
+  void* context;
+  volatile bool done;
+  ret_code_t result;
+  uint32_t started;
+  uint32_t timeout;        // Cycles before the bus is assumed stuck
+  struct i2c_bus_job_s* next;
+} i2c_bus_job_t;
+
+// Initialize the TWI manager behind <bus>
+//
+// mngr - instance from NRF_TWI_MNGR_DEF, a queue of one transaction is enough
+// config - pins and frequency, copied into the bus
+ret_code_t i2c_bus_init(i2c_bus_t* bus, const nrf_twi_mngr_t* mngr,
+    const nrf_drv_twi_config_t* config, const char* name);
+
+// Describe a chip on <bus> and add it to the bus's device list
+//
+// auto_increment - bit to set in the register address for burst access,
+//                  0 if the chip always increments
+// shadow - optional register mirror of shadow_size bytes, may be NULL
+void i2c_device_init(i2c_device_t* device, i2c_bus_t* bus, uint8_t address,
+    uint8_t auto_increment, uint8_t* shadow, uint16_t shadow_size, const char* name);
+
+// Prepare jobs. Nothing is sent until the job is submitted or run
+void i2c_job_read_regs(i2c_bus_job_t* job, i2c_device_t* device, uint8_t reg, uint8_t* data, uint8_t len);
+void i2c_job_write_regs(i2c_bus_job_t* job, i2c_device_t* device, uint8_t reg, const uint8_t* data, uint8_t len);
+void i2c_job_read(i2c_bus_job_t* job, i2c_device_t* device, uint8_t* data, uint8_t len);
+
+// Queue a prepared job. <callback> runs from the TWI interrupt when it is done
+ret_code_t i2c_bus_submit(i2c_bus_job_t* job, i2c_bus_priority_t priority,
+    i2c_bus_callback_t callback, void* context);
+
+// Queue a prepared job and wait until it is done
+// A transaction that takes far longer than its length allows is aborted with
+// NRF_ERROR_TIMEOUT and the bus is recovered
+// Must not be called from an interrupt at or above the TWI interrupt priority
+ret_code_t i2c_bus_run(i2c_bus_job_t* job, i2c_bus_priority_t priority);
+
+// Blocking helpers at the device's priority, one transaction each
+ret_code_t i2c_device_read_regs(i2c_device_t* device, uint8_t reg, uint8_t* data, uint8_t len);
+ret_code_t i2c_device_write_regs(i2c_device_t* device, uint8_t reg, const uint8_t* data, uint8_t len);
+ret_code_t i2c_device_read(i2c_device_t* device, uint8_t* data, uint8_t len);
+uint8_t i2c_device_read_reg(i2c_device_t* device, uint8_t reg);
+ret_code_t i2c_device_write_reg(i2c_device_t* device, uint8_t reg, uint8_t value);
+
+// Stage a register write in the shadow without touching the bus
+void i2c_device_stage(i2c_device_t* device, uint8_t reg, uint8_t value);
+
+// Write every staged register, in ascending address order
+//
+// Staged registers are grouped into contiguous blocks, bridging gaps with
+// registers whose written value is already known, and each block is sent as
+// one burst write. Returns the first error, or NRF_SUCCESS
+ret_code_t i2c_device_flush(i2c_device_t* device);
+
+// Check whether any chip acknowledges <address> with a one byte read
+bool i2c_bus_probe(i2c_bus_t* bus, uint8_t address);
+
+// Prepare the same probe as a job that can be submitted without waiting
+// scratch describes the address for the job's lifetime and is not added to
+// the bus's device list
+void i2c_job_probe(i2c_bus_job_t* job, i2c_device_t* scratch, i2c_bus_t* bus, uint8_t address, uint8_t* data);
+
+// Give a device a register with a fixed value, such as WHO_AM_I
+// Clock probing reads it repeatedly and compares. Devices without one are
+// only checked for an acknowledge
+void i2c_device_set_id(i2c_device_t* device, uint8_t reg, uint8_t value);
+
+// Try 400 kHz, 250 kHz and 100 kHz and keep the fastest clock every device on
+// the bus passes I2C_BUS_PROBE_ROUNDS checks at
+// Devices that fail at every rate are marked offline
+// Returns the chosen frequency
+nrf_drv_twi_frequency_t i2c_bus_select_frequency(i2c_bus_t* bus);
+
+// Re-initialize the bus at <frequency>, for a rate known to work already
+void i2c_bus_set_frequency(i2c_bus_t* bus, nrf_drv_twi_frequency_t frequency);
+
+// Release a stuck bus: clock SCL up to nine times until the slave lets go of
+// SDA, send a STOP, then re-initialize the TWI manager
+// A transaction in progress is aborted with NRF_ERROR_TIMEOUT
+// Returns false if SDA is still held low
+bool i2c_bus_recover(i2c_bus_t* bus);
+
+// Act on timeouts and error rates: recover the bus or step the clock down
+// Call from thread context. i2c_bus_run() calls it while waiting
+void i2c_bus_poll(i2c_bus_t* bus);
+
+// Report when the TWIM peripheral is busy, e.g. for clock accounting
+// NULL to remove
+void i2c_bus_set_activity_handler(i2c_bus_t* bus, i2c_bus_activity_handler_t handler);
+
+// Print and reset the bus and per-device counters
+void i2c_bus_print_stats(i2c_bus_t* bus);
@@ -0,0 +1,249 @@
+#!/usr/bin/env python3
+"""Build the TFT glyph tables from the fonts/*.txt sources.
+
+    python3 font_gen.py fonts/font_8x8.txt fonts/font_5x5.txt \\
+        -o ../apps/rfid_music/font_data
+
+writes font_data.c and font_data.h. Each source describes one font:
+
+    name font_8x8       C identifier of the font
+    height 8            rows per glyph
+    width 8             columns per glyph, at most 8
+    proportional        optional, trim each glyph to its inked columns
+    spacing 1           optional, blank columns after each glyph
+    space 3             optional, width of ' ' in a proportional font
+
+followed by one block per glyph: 'glyph' and the character (or its code as
+0xNN), then <height> lines with '#' for each lit pixel, as seen on screen.
+
+Only the characters present are stored. Consecutive code points form a
+range, and short gaps are filled with blank glyphs when that costs less flash
+than a new range entry. Rows are stored in drawing order: the panel is
+mirrored, so the rightmost pixel on screen is drawn first and sits in the
+most significant bit.
+"""
+
+import argparse
+import os
+import sys
+
+RANGE_BYTES = 4  # tft_font_range_t: first, last, uint16_t glyph
+
+
+class Font:
+    def __init__(self, path):
+        self.path = path
+        self.name = None
+        self.height = None
+        self.width = None
+        self.proportional = False
+        self.spacing = None
+        self.space = None
+        self.glyphs = {}  # code point -> list of row strings
+        self._parse()
+
+    def _parse(self):
+        with open(self.path) as f:
+            lines = [line.rstrip("\n") for line in f]
+
+        i = 0
+        while i < len(lines):
+            line = lines[i].strip()
+            i += 1
+            if not line or line.startswith("#"):
+                continue
+            key, _, value = line.partition(" ")
+            if key == "name":
+                self.name = value
+            elif key == "height":
+                self.height = int(value)
+            elif key == "width":
+                self.width = int(value)
+            elif key == "proportional":
+                self.proportional = True
+            elif key == "spacing":
+                self.spacing = int(value)
+            elif key == "space":
+                self.space = int(value)
+            elif key == "glyph":
+                code = int(value, 16) if value.startswith("0x") else ord(value)
+                rows = lines[i:i + self.height]
+                i += self.height
+                for row in rows:
+                    if len(row) != self.width or set(row) - set("#."):
+                        self._fail("glyph %r: bad row %r" % (chr(code), row))
+                self.glyphs[code] = rows
+            else:
+                self._fail("unknown key %r" % key)
+
+        if self.name is None or self.height is None or self.width is None:
+            self._fail("name, height and width are required")
+        if self.width > 8:
+            self._fail("glyphs are stored one byte per row, width must be <= 8")
+        if self.spacing is None:
+            self.spacing = 1 if self.proportional else 0
+
+    def _fail(self, message):
+        sys.exit("%s: %s" % (self.path, message))
+
+    def glyph_width(self, code):
+        if not self.proportional:
+            return self.width
+        if code == ord(" "):
+            return self.space or max(1, self.width // 2)
+        inked = [c for c in range(self.width) if any(r[c] == "#" for r in self.glyphs[code])]
+        return inked[-1] - inked[0] + 1 if inked else 1
+
+    def glyph_rows(self, code):
+        """Row bytes in drawing order, trimmed to the glyph's width."""
+        rows = self.glyphs[code]
+        width = self.glyph_width(code)
+        left = 0
+        if self.proportional and code != ord(" "):
+            left = min((c for c in range(self.width) if any(r[c] == "#" for r in rows)), default=0)
+        encoded = []
+        for row in rows:
+            visible = row[left:left + width].ljust(width, ".")
+            byte = 0
+            for col in range(width):
+                # Column 0 is drawn first and shows up rightmost on screen
+                if visible[width - 1 - col] == "#":
+                    byte |= 0x80 >> col
+            encoded.append(byte)
+        return encoded
+
+    def ranges(self):
+        """Runs of code points, bridging gaps cheaper than a range entry."""
+        codes = sorted(self.glyphs)
+        runs = [[codes[0], codes[0]]]
+        for code in codes[1:]:
+            gap = code - runs[-1][1] - 1
+            if gap * self.height <= RANGE_BYTES:
+                runs[-1][1] = code
+            else:
+                runs.append([code, code])
+        return runs
+
+
+def c_array(values, per_line=16):
+    lines = []
+    for i in range(0, len(values), per_line):
+        lines.append("    " + " ".join("0x%02X," % v for v in values[i:i + per_line]))
+    return "\n".join(lines)
+
+
+def generate(fonts, out_base):
+    guard = os.path.basename(out_base).upper() + "_H"
+    header = os.path.basename(out_base) + ".h"
+    command = "python3 font_gen.py " + " ".join(os.path.relpath(f.path) for f in fonts)
+
+    source = [
+        "// Generated by software/tools/font_gen.py, do not edit",
+        "// Rebuild with: " + command + " -o <app>/" + os.path.basename(out_base),
+        "",
+        '#include "%s"' % header,
+    ]
+    report = []
+
+    for font in fonts:
+        runs = font.ranges()
+        rows = []
+        widths = []
+        range_entries = []
+        for first, last in runs:
+            range_entries.append("    {0x%02X, 0x%02X, %d}," % (first, last, len(widths)))
+            for code in range(first, last + 1):
+                if code in font.glyphs:
+                    rows.extend(font.glyph_rows(code))
+                    widths.append(font.glyph_width(code))
+                else:
+                    rows.extend([0] * font.height)
+                    widths.append(font.space or font.width)
+
+        glyph_count = len(widths)
+        flash = len(rows) + len(runs) * RANGE_BYTES + (glyph_count if font.proportional else 0)
+        dense = 128 * font.height
+        report.append((font, glyph_count, len(runs), flash, dense))
+
+        source += [
+            "",
+            "// %s: %d glyphs in %d ranges, %d bytes (a dense 128 entry table is %d)"
+            % (font.name, glyph_count, len(runs), flash, dense),
+            "static const uint8_t %s_rows[] = {" % font.name,
+            c_array(rows),
+            "};",
+            "",
+            "static const tft_font_range_t %s_ranges[] = {" % font.name,
+        ] + range_entries + ["};"]
+        if font.proportional:
+            source += [
+                "",
+                "static const uint8_t %s_widths[] = {" % font.name,
+                c_array(widths),
+                "};",
+            ]
+        source += [
+            "",
+            "const tft_font_t %s = {" % font.name,
+            '    .name = "%s",' % font.name,
+            "    .height = %d," % font.height,
+            "    .advance = %d," % (0 if font.proportional else font.width),
+            "    .spacing = %d," % font.spacing,
+            "    .range_count = %d," % len(runs),
+            "    .glyph_count = %d," % glyph_count,
+            "    .ranges = %s_ranges," % font.name,
+            "    .widths = %s," % (font.name + "_widths" if font.proportional else "NULL"),
+            "    .rows = %s_rows," % font.name,
+            "};",
+        ]
+
+    source += [
+        "",
+        "const tft_font_t *const tft_fonts[TFT_FONT_COUNT] = {",
+    ] + ["    &%s," % font.name for font in fonts] + ["};", ""]
+
+    header_lines = [
+        "// Generated by software/tools/font_gen.py, do not edit",
+        "",
+        "#ifndef " + guard,
+        "#define " + guard,
+        "",
+        '#include "tft_font.h"',
+        "",
+        "#define TFT_FONT_COUNT %d" % len(fonts),
+        "",
+    ] + ["extern const tft_font_t %s;" % font.name for font in fonts] + [
+        "",
+        "// Every generated font, for reporting",
+        "extern const tft_font_t *const tft_fonts[TFT_FONT_COUNT];",
+        "",
+        "#endif",
+        "",
+    ]
+
+    with open(out_base + ".c", "w") as f:
+        f.write("\n".join(source))
+    with open(out_base + ".h", "w") as f:
+        f.write("\n".join(header_lines))
+
+    for font, glyph_count, range_count, flash, dense in report:
+        print("%-10s %3d glyphs %2d ranges %5d bytes flash (dense table %d)"
+              % (font.name, glyph_count, range_count, flash, dense))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("sources", nargs="+", help="font description files")
+    parser.add_argument("-o", "--output", required=True,
+                        help="output path without extension, e.g. ../apps/rfid_music/font_data")
+    args = parser.parse_args()
+
+    fonts = [Font(path) for path in args.sources]
+    names = [font.name for font in fonts]
+    if len(set(names)) != len(names):
+        sys.exit("font names must be unique")
+    generate(fonts, args.output)
+
+
+if __name__ == "__main__":
+    main()
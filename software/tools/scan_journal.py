@@ -0,0 +1,115 @@
+#!/usr/bin/env python3
+"""Decode a scan journal export from rfid_music.
+
+    python3 scan_journal.py /dev/ttyACM0            # press button A, wait
+    python3 scan_journal.py capture.bin --csv scans.csv
+
+Pressing button A on the micro:bit flushes the journal and sends it over the
+serial port as one binary frame, in between the usual text output:
+
+    "RSJOURNL"  magic
+    uint32      record count
+    uint16      record size (24)
+    uint16      format version (1)
+    records     oldest first
+    uint16      CRC-16-CCITT of the record bytes
+
+Reading from a serial port needs pyserial. A file is searched for the last
+frame it contains, so a raw capture of the whole session works too.
+"""
+
+import argparse
+import csv
+import struct
+import sys
+
+MAGIC = b"RSJOURNL"
+HEADER = struct.Struct("<8sIHH")
+RECORD = struct.Struct("<I6sBBIIhH")
+VERSION = 1
+BAUD = 38400
+TICK_HZ = 32768
+
+
+def crc16(data, crc=0xFFFF):
+    """CRC-16-CCITT as computed by the SDK's crc16_compute()."""
+    for byte in data:
+        crc = ((crc >> 8) | (crc << 8)) & 0xFFFF
+        crc ^= byte
+        crc ^= (crc & 0xFF) >> 4
+        crc ^= (crc << 12) & 0xFFFF
+        crc ^= ((crc & 0xFF) << 5) & 0xFFFF
+    return crc
+
+
+def read_serial(port):
+    import serial
+
+    with serial.Serial(port, BAUD, timeout=30) as link:
+        print("Waiting for an export, press button A", file=sys.stderr)
+        data = link.read_until(MAGIC)
+        if not data.endswith(MAGIC):
+            sys.exit("No export seen on " + port)
+        rest = link.read(HEADER.size - len(MAGIC))
+        count, size = struct.unpack_from("<IH", rest)
+        body = link.read(count * size + 2)
+        return MAGIC + rest + body
+
+
+def parse(data):
+    start = data.rfind(MAGIC)
+    if start < 0:
+        sys.exit("No journal export found")
+    _, count, size, version = HEADER.unpack_from(data, start)
+    if version != VERSION or size != RECORD.size:
+        sys.exit("Unsupported journal format %d with %d byte records" % (version, size))
+
+    body = data[start + HEADER.size:start + HEADER.size + count * size]
+    if len(body) != count * size:
+        sys.exit("Export truncated: %d of %d records" % (len(body) // size, count))
+    (crc,) = struct.unpack_from("<H", data, start + HEADER.size + count * size)
+    if crc16(body) != crc:
+        print("Warning: export CRC mismatch, the transfer is damaged", file=sys.stderr)
+
+    records = []
+    for offset in range(0, len(body), size):
+        chunk = body[offset:offset + size]
+        sequence, tag, reader, _, reader_time, ticks, centi_oz, record_crc = RECORD.unpack(chunk)
+        records.append({
+            "sequence": sequence,
+            "tag": tag.hex().upper(),
+            "reader": reader,
+            "reader_time_ms": reader_time,
+            "uptime_s": round(ticks / TICK_HZ, 3),
+            "weight_oz": centi_oz / 100,
+            "valid": crc16(chunk[:-2]) == record_crc,
+        })
+    return records
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("source", help="serial port, or a file holding a capture")
+    parser.add_argument("--csv", help="write the records to this CSV file instead of stdout")
+    args = parser.parse_args()
+
+    if args.source.startswith("/dev/") or args.source.upper().startswith("COM"):
+        data = read_serial(args.source)
+    else:
+        with open(args.source, "rb") as f:
+            data = f.read()
+    records = parse(data)
+
+    out = open(args.csv, "w", newline="") if args.csv else sys.stdout
+    writer = csv.DictWriter(out, fieldnames=list(records[0].keys()) if records else ["sequence"])
+    writer.writeheader()
+    writer.writerows(records)
+    if args.csv:
+        out.close()
+
+    bad = sum(not r["valid"] for r in records)
+    print("%d records, %d failed their CRC" % (len(records), bad), file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,142 @@
+#!/usr/bin/env python3
+"""Summarize scan pipeline traces from rfid_music.
+
+    python3 scan_trace.py /dev/ttyACM0 --minutes 10 --chrome scans.json
+    python3 scan_trace.py capture.txt
+
+Every report the micro:bit prints the scans traced since the last one, one
+line each, in between the usual text output:
+
+    TRACE <id> <reader> <uptime ms> i2c_start=0 i2c_end=3120 ... spi_last=41200
+
+Stage times are microseconds after the read started, and a stage that did not
+happen, such as the SPI stages while the TFT is off, is left out. This prints
+percentiles for each stage of the pipeline and can write a Chrome trace-event
+file to load in chrome://tracing or ui.perfetto.dev.
+
+Reading from a serial port needs pyserial.
+"""
+
+import argparse
+import json
+import math
+import sys
+import time
+
+BAUD = 38400
+
+# Spans between stamps, in pipeline order. The SPI span overlaps the others,
+# it runs from the ticker scroll through to the end of the screen
+SPANS = [
+    ("i2c", "i2c_start", "i2c_end"),
+    ("decode", "i2c_end", "decoded"),
+    ("queue", "decoded", "lookup_start"),
+    ("lookup", "lookup_start", "lookup_end"),
+    ("history", "lookup_end", "layout"),
+    ("render", "layout", "spi_last"),
+    ("spi", "spi_first", "spi_last"),
+    ("total", "i2c_start", "spi_last"),
+]
+
+
+def read_serial(port, minutes):
+    import serial
+
+    lines = []
+    deadline = time.time() + minutes * 60
+    with serial.Serial(port, BAUD, timeout=1) as link:
+        print("Collecting traces for %g minutes" % minutes, file=sys.stderr)
+        while time.time() < deadline:
+            line = link.readline().decode("ascii", "replace")
+            if line.startswith("TRACE "):
+                lines.append(line)
+    return lines
+
+
+def parse(lines):
+    scans = []
+    for line in lines:
+        fields = line.split()
+        if len(fields) < 4 or fields[0] != "TRACE":
+            continue
+        stages = {}
+        for field in fields[4:]:
+            name, _, value = field.partition("=")
+            stages[name] = int(value)
+        scans.append({
+            "id": int(fields[1]),
+            "reader": int(fields[2]),
+            "start_ms": int(fields[3]),
+            "stages": stages,
+        })
+    return scans
+
+
+def percentile(values, fraction):
+    """Nearest-rank percentile of a sorted list."""
+    return values[max(0, math.ceil(fraction * len(values)) - 1)]
+
+
+def print_summary(scans):
+    print("%d scans" % len(scans))
+    print("%-8s %6s %9s %9s %9s %9s" % ("stage", "count", "p50 us", "p90 us", "p99 us", "max us"))
+    for name, begin, end in SPANS:
+        values = sorted(s["stages"][end] - s["stages"][begin] for s in scans
+                        if begin in s["stages"] and end in s["stages"])
+        if not values:
+            continue
+        print("%-8s %6d %9d %9d %9d %9d" % (name, len(values), percentile(values, 0.5),
+                                           percentile(values, 0.9), percentile(values, 0.99), values[-1]))
+
+
+def chrome_trace(scans):
+    """One process per reader, pipeline spans on one track and SPI on another."""
+    events = []
+    for scan in scans:
+        base = scan["start_ms"] * 1000
+        stages = scan["stages"]
+        for name, begin, end in SPANS:
+            if name == "total" or begin not in stages or end not in stages:
+                continue
+            events.append({
+                "name": name,
+                "cat": "scan",
+                "ph": "X",
+                "ts": base + stages[begin],
+                "dur": stages[end] - stages[begin],
+                "pid": scan["reader"],
+                "tid": 2 if name == "spi" else 1,
+                "args": {"scan": scan["id"]},
+            })
+    for reader in sorted({s["reader"] for s in scans}):
+        events.append({"name": "process_name", "ph": "M", "pid": reader, "args": {"name": "reader %d" % reader}})
+        events.append({"name": "thread_name", "ph": "M", "pid": reader, "tid": 1, "args": {"name": "pipeline"}})
+        events.append({"name": "thread_name", "ph": "M", "pid": reader, "tid": 2, "args": {"name": "SPIM"}})
+    return {"traceEvents": events, "displayTimeUnit": "ms"}
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("source", help="serial port, or a file holding a capture")
+    parser.add_argument("--minutes", type=float, default=5, help="how long to read a serial port for")
+    parser.add_argument("--chrome", help="write a Chrome trace-event JSON file")
+    args = parser.parse_args()
+
+    if args.source.startswith("/dev/") or args.source.upper().startswith("COM"):
+        lines = read_serial(args.source, args.minutes)
+    else:
+        with open(args.source, errors="replace") as f:
+            lines = f.readlines()
+    scans = parse(lines)
+    if not scans:
+        sys.exit("No TRACE lines found")
+
+    print_summary(scans)
+    if args.chrome:
+        with open(args.chrome, "w") as f:
+            json.dump(chrome_trace(scans), f)
+        print("Wrote %s" % args.chrome, file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,139 @@
+// Replay recorded weight traces through weight_filter on a PC
+//
+//     make test
+//     ./weight_replay capture.txt
+//
+// Build rfid_music with WEIGHT_TRACE defined in weight_sensor.c and it prints
+// every burst of readings, one line each, in between the usual output:
+//
+//     WEIGHT_BURST 1012 1009 1015 1010 1011
+//     WEIGHT_RESUME
+//
+// Each burst goes through the same filter, default calibration and
+// hysteresis as on the board, and WEIGHT_RESUME restarts the filter like
+// weight_sensor_resume() does. Other lines are skipped, so a raw serial
+// capture can be replayed as is. Expectations are added to the capture by
+// hand as comments:
+//
+//     # expect 12          whole ounces shown, 0 for an empty plate
+//     # expect changes 1   display changes since the previous check
+//
+// Exits with 1 if any expectation fails.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "weight_filter.h"
+
+#define LINE_LENGTH 256
+
+typedef struct
+{
+    weight_filter_t filter;
+    weight_hysteresis_t hysteresis;
+    uint32_t bursts;
+    uint32_t changes;
+    uint32_t checks;
+    uint32_t failures;
+} replay_t;
+
+static void replay_burst(replay_t *replay, const char *args, const char *name, uint32_t line)
+{
+    int16_t samples[WEIGHT_FILTER_MAX_SAMPLES];
+    uint8_t count = 0;
+    char *end;
+    long value = strtol(args, &end, 10);
+    while (end != args && count < WEIGHT_FILTER_MAX_SAMPLES)
+    {
+        samples[count++] = (int16_t)value;
+        args = end;
+        value = strtol(args, &end, 10);
+    }
+
+    int32_t raw = weight_filter_update(&replay->filter, samples, count);
+    int32_t centi_oz = weight_calibrate(&weight_default_calibration, raw);
+    replay->bursts++;
+    if (weight_hysteresis_update(&replay->hysteresis, centi_oz))
+    {
+        replay->changes++;
+        printf("%s:%u: raw %d, %d.%02d oz, showing %d oz\n", name, line,
+               raw, centi_oz / 100, centi_oz % 100, replay->hysteresis.shown);
+    }
+}
+
+static void check(replay_t *replay, const char *args, const char *name, uint32_t line)
+{
+    const char *what = "shown ounces";
+    int32_t actual = replay->hysteresis.shown;
+    if (strncmp(args, "changes", 7) == 0)
+    {
+        what = "display changes";
+        actual = replay->changes;
+        replay->changes = 0;
+        args += 7;
+    }
+
+    int32_t expected = strtol(args, NULL, 10);
+    replay->checks++;
+    if (actual != expected)
+    {
+        replay->failures++;
+        printf("%s:%u: FAIL expected %d %s, got %d\n", name, line, expected, what, actual);
+    }
+}
+
+static int replay_file(replay_t *replay, const char *name)
+{
+    FILE *file = fopen(name, "r");
+    if (!file)
+    {
+        perror(name);
+        return -1;
+    }
+
+    weight_filter_init(&replay->filter);
+    weight_hysteresis_init(&replay->hysteresis);
+    replay->changes = 0;
+
+    char text[LINE_LENGTH];
+    uint32_t line = 0;
+    while (fgets(text, sizeof(text), file))
+    {
+        line++;
+        if (strncmp(text, "WEIGHT_BURST", 12) == 0)
+        {
+            replay_burst(replay, text + 12, name, line);
+        }
+        else if (strncmp(text, "WEIGHT_RESUME", 13) == 0)
+        {
+            weight_filter_init(&replay->filter);
+        }
+        else if (strncmp(text, "# expect ", 9) == 0)
+        {
+            check(replay, text + 9, name, line);
+        }
+    }
+    fclose(file);
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: %s trace...\n", argv[0]);
+        return 2;
+    }
+
+    replay_t replay = {0};
+    for (int i = 1; i < argc; i++)
+    {
+        if (replay_file(&replay, argv[i]) < 0)
+        {
+            return 2;
+        }
+    }
+
+    printf("%u bursts, %u checks, %u failed\n", replay.bursts, replay.checks, replay.failures);
+    return replay.failures ? 1 : 0;
+}